@@ -0,0 +1,119 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <atomic>
+#include <new>
+
+
+// Compteur des appels au operator new global, pour traquer les allocations qui restent dans la boucle de trame.
+// Les remplacements de new/delete ne peuvent être définis qu'une fois dans le programme : un seul .cpp doit faire
+//     #define INF2705_ALLOCATION_COUNTER_IMPLEMENTATION
+// avant sa première inclusion d'un en-tête inf2705 (OpenGLApplication.hpp inclut celui-ci).
+// Sans ça, isEnabled() est faux et les compteurs restent à zéro.
+namespace AllocationCounter
+{
+	inline std::atomic<uint64_t> totalCount = 0;
+	inline thread_local uint64_t threadCount = 0;
+	inline bool enabled = false;
+
+	inline bool isEnabled() { return enabled; }
+
+	// Nombre d'allocations depuis le début du programme, tous fils confondus.
+	inline uint64_t getCount() { return totalCount.load(std::memory_order_relaxed); }
+
+	// Nombre d'allocations faites par le fil appelant.
+	inline uint64_t getThreadCount() { return threadCount; }
+
+	inline void record() {
+		totalCount.fetch_add(1, std::memory_order_relaxed);
+		threadCount++;
+	}
+}
+
+
+#ifdef INF2705_ALLOCATION_COUNTER_IMPLEMENTATION
+
+namespace AllocationCounter
+{
+	static const bool installed = (enabled = true);
+
+	inline void* allocate(size_t size) {
+		record();
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	inline void* allocateAligned(size_t size, std::align_val_t alignment) {
+		record();
+		size_t align = static_cast<size_t>(alignment);
+		size = size == 0 ? align : (size + align - 1) & ~(align - 1);
+#ifdef _WIN32
+		return _aligned_malloc(size, align);
+#else
+		return std::aligned_alloc(align, size);
+#endif
+	}
+
+	inline void freeAligned(void* ptr) {
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+void* operator new(size_t size) {
+	if (void* ptr = AllocationCounter::allocate(size))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return AllocationCounter::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return AllocationCounter::allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	if (void* ptr = AllocationCounter::allocateAligned(size, alignment))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return AllocationCounter::allocateAligned(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return AllocationCounter::allocateAligned(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { AllocationCounter::freeAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { AllocationCounter::freeAligned(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { AllocationCounter::freeAligned(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { AllocationCounter::freeAligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { AllocationCounter::freeAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { AllocationCounter::freeAligned(ptr); }
+
+#endif
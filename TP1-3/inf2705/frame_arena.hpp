@@ -0,0 +1,109 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+
+// Allocateur linéaire pour les données qui ne vivent qu'une trame. Une allocation avance un pointeur, une
+// désallocation ne fait rien et reset() (au début de chaque trame) libère tout d'un coup. S'utilise avec les
+// conteneurs std::pmr : std::pmr::vector<float> v(&arena).
+// Si une trame dépasse la capacité, des blocs supplémentaires sont chaînés, puis fusionnés en un seul bloc plus
+// grand au prochain reset() : en régime permanent, l'arène ne touche plus au tas.
+// Fil de rendu seulement.
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+	explicit FrameArena(size_t capacity = 1 << 20) {
+		grow(capacity);
+	}
+
+	~FrameArena() override {
+		for (auto& block : blocks_)
+			freeBlock(block);
+	}
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Invalide tout ce qui a été alloué depuis le dernier reset().
+	void reset() {
+		highWater_ = std::max(highWater_, usedBytes_);
+		lastFrameBytes_ = usedBytes_;
+		if (blocks_.size() > 1) {
+			size_t total = getCapacity();
+			for (auto& block : blocks_)
+				freeBlock(block);
+			blocks_.clear();
+			grow(total);
+		}
+		offset_ = 0;
+		usedBytes_ = 0;
+	}
+
+	// Octets demandés depuis le dernier reset().
+	size_t getUsedBytes() const { return usedBytes_; }
+	// Octets demandés pendant la trame précédente.
+	size_t getLastFrameBytes() const { return lastFrameBytes_; }
+	// Plus grand nombre d'octets demandés pendant une trame.
+	size_t getHighWater() const { return std::max(highWater_, usedBytes_); }
+
+	size_t getCapacity() const {
+		size_t total = 0;
+		for (auto& block : blocks_)
+			total += block.size;
+		return total;
+	}
+
+	int getBlockCount() const { return (int)blocks_.size(); }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		Block& block = blocks_.back();
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+		uintptr_t aligned = (base + offset_ + alignment - 1) & ~(uintptr_t(alignment) - 1);
+		if (aligned + bytes > base + block.size) {
+			// Le nouveau bloc double au moins la capacité pour que la fusion converge vite.
+			grow(std::max(bytes + alignment, getCapacity()));
+			return do_allocate(bytes, alignment);
+		}
+		offset_ = aligned + bytes - base;
+		usedBytes_ += bytes;
+		return reinterpret_cast<void*>(aligned);
+	}
+
+	void do_deallocate(void*, size_t, size_t) override {}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+
+private:
+	struct Block
+	{
+		std::byte* data;
+		size_t size;
+	};
+
+	static constexpr std::align_val_t BLOCK_ALIGNMENT = std::align_val_t(64);
+
+	void grow(size_t size) {
+		blocks_.push_back({ static_cast<std::byte*>(::operator new(size, BLOCK_ALIGNMENT)), size });
+		offset_ = 0;
+	}
+
+	static void freeBlock(Block& block) {
+		::operator delete(block.data, BLOCK_ALIGNMENT);
+	}
+
+	std::vector<Block> blocks_;
+	size_t offset_ = 0;
+	size_t usedBytes_ = 0;
+	size_t lastFrameBytes_ = 0;
+	size_t highWater_ = 0;
+};
@@ -0,0 +1,473 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <bitset>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <SFML/Window.hpp>
+
+#include <inf2705/sfml_utils.hpp>
+
+
+// Journal des entrées pour rejouer exactement une session (--record-input fichier, --replay-input fichier).
+// Une trame d'entrée correspond à un appel de handleEvents(). Pour chaque trame où quelque chose change, le journal
+// contient un marqueur (écart de trames en varint) suivi des enregistrements de la trame : les événements SFML traités
+// par OpenGLApplication, l'état de la souris, les touches interrogées par isKeyPressed() et le focus.
+// ImGui n'a pas d'enregistrement à part : il reçoit les mêmes événements de souris avec la même disposition et refait
+// donc les mêmes changements d'état.
+class InputRecorder
+{
+public:
+	enum class Mode
+	{
+		Off,
+		Recording,
+		Replaying,
+	};
+
+	struct Header
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		// Pas de temps simulé de chaque trame, identique à l'enregistrement et au rejeu.
+		float deltaTime = 0.0f;
+		// Donné à std::srand() avant init().
+		uint32_t seed = 0;
+	};
+
+	~InputRecorder() {
+		finish();
+	}
+
+	Mode getMode() const { return mode_; }
+	bool isActive() const { return mode_ != Mode::Off; }
+	bool isRecording() const { return mode_ == Mode::Recording; }
+	bool isReplaying() const { return mode_ == Mode::Replaying; }
+	const Header& getHeader() const { return header_; }
+	// Trame d'entrée courante (0 au premier appel de handleEvents()).
+	int getFrame() const { return frame_; }
+
+	bool startRecording(const std::string& filename, const Header& header) {
+		file_.open(filename, std::ios::binary);
+		if (not file_) {
+			std::cerr << "Could not write input log \"" << filename << "\"" << "\n";
+			return false;
+		}
+		mode_ = Mode::Recording;
+		header_ = header;
+		reset();
+		buffer_.clear();
+		buffer_.reserve(1 << 20);
+		buffer_.insert(buffer_.end(), MAGIC, MAGIC + sizeof(MAGIC));
+		writeByte(VERSION);
+		writeU32(header.width);
+		writeU32(header.height);
+		writeFloat(header.deltaTime);
+		writeU32(header.seed);
+		filename_ = filename;
+		return true;
+	}
+
+	bool startReplay(const std::string& filename) {
+		std::ifstream file(filename, std::ios::binary);
+		if (not file) {
+			std::cerr << "Could not read input log \"" << filename << "\"" << "\n";
+			return false;
+		}
+		buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		cursor_ = 0;
+		if (buffer_.size() < sizeof(MAGIC) + 1 or std::memcmp(buffer_.data(), MAGIC, sizeof(MAGIC)) != 0 or buffer_[sizeof(MAGIC)] != VERSION) {
+			std::cerr << "\"" << filename << "\" is not an input log (version " << (int)VERSION << ")" << "\n";
+			return false;
+		}
+		cursor_ = sizeof(MAGIC) + 1;
+		header_.width = readU32();
+		header_.height = readU32();
+		header_.deltaTime = readFloat();
+		header_.seed = readU32();
+		mode_ = Mode::Replaying;
+		reset();
+		return true;
+	}
+
+	// Termine l'enregistrement : marque la fin du journal à la trame courante et l'écrit sur disque.
+	void finish() {
+		if (mode_ == Mode::Recording) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::End);
+			file_.write(reinterpret_cast<const char*>(buffer_.data()), (std::streamsize)buffer_.size());
+			file_.close();
+			std::cout << "Input log written to \"" << filename_ << "\" (" << frame_ + 1 << " frames, "
+			          << buffer_.size() << " bytes)" << std::endl;
+		}
+		mode_ = Mode::Off;
+	}
+
+	// Enregistrement : au début de chaque handleEvents(), avant recordEvent().
+	void beginRecordedFrame(const MouseState& mouse, bool hasFocus) {
+		frame_++;
+		queriedKeys_.reset();
+		if (frame_ == 0 or not isSameMouse(mouse, mouse_)) {
+			mouse_ = mouse;
+			writeFrameMarker();
+			writeByte((uint8_t)Record::Mouse);
+			writeMouse(mouse);
+		}
+		if (frame_ == 0 or hasFocus != hasFocus_) {
+			hasFocus_ = hasFocus;
+			writeFrameMarker();
+			writeByte((uint8_t)Record::Focus);
+			writeByte(hasFocus ? 1 : 0);
+		}
+	}
+
+	void recordEvent(const sf::Event& event) {
+		if (event.is<sf::Event::Closed>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::Closed);
+		} else if (auto* e = event.getIf<sf::Event::Resized>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::Resized);
+			writeVarint(e->size.x);
+			writeVarint(e->size.y);
+		} else if (auto* e = event.getIf<sf::Event::KeyPressed>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::KeyPressed);
+			writeKey(e->code, e->scancode, e->alt, e->control, e->shift, e->system);
+		} else if (auto* e = event.getIf<sf::Event::KeyReleased>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::KeyReleased);
+			writeKey(e->code, e->scancode, e->alt, e->control, e->shift, e->system);
+		} else if (auto* e = event.getIf<sf::Event::MouseButtonPressed>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::MouseButtonPressed);
+			writeByte((uint8_t)e->button);
+			writeVector(e->position);
+		} else if (auto* e = event.getIf<sf::Event::MouseButtonReleased>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::MouseButtonReleased);
+			writeByte((uint8_t)e->button);
+			writeVector(e->position);
+		} else if (auto* e = event.getIf<sf::Event::MouseMoved>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::MouseMoved);
+			writeVector(e->position);
+		} else if (auto* e = event.getIf<sf::Event::MouseWheelScrolled>()) {
+			writeFrameMarker();
+			writeByte((uint8_t)Record::MouseWheelScrolled);
+			writeByte((uint8_t)e->wheel);
+			writeFloat(e->delta);
+			writeVector(e->position);
+		}
+	}
+
+	// Enregistrement : la première interrogation d'une touche dans la trame fixe sa valeur pour toute la trame, pour que
+	// le rejeu (qui applique les changements au début de la trame) donne la même réponse à chaque appel.
+	bool recordKey(sf::Keyboard::Key key, bool isPressed) {
+		size_t index = keyIndex(key);
+		if (queriedKeys_[index])
+			return keys_[index];
+		queriedKeys_[index] = true;
+		if (keys_[index] != isPressed) {
+			keys_[index] = isPressed;
+			writeFrameMarker();
+			writeByte((uint8_t)Record::Key);
+			writeVarint((uint32_t)index);
+			writeByte(isPressed ? 1 : 0);
+		}
+		return isPressed;
+	}
+
+	// Rejeu : au début de chaque handleEvents(). Ajoute à events ceux de la trame. Faux si le journal se termine à cette
+	// trame : l'enregistrement s'est arrêté ici, la trame n'a pas été dessinée.
+	bool readFrame(std::vector<sf::Event>& events) {
+		if (isFinished_)
+			return false;
+		frame_++;
+		while (cursor_ < buffer_.size()) {
+			auto type = (Record)buffer_[cursor_];
+			if (type == Record::Frame) {
+				size_t marker = cursor_++;
+				int nextFrame = recordFrame_ + (int)readVarint();
+				if (nextFrame > frame_) {
+					cursor_ = marker;
+					return true;
+				}
+				recordFrame_ = nextFrame;
+				continue;
+			}
+			cursor_++;
+			switch (type) {
+			case Record::End:
+				isFinished_ = true;
+				return false;
+			case Record::Mouse:
+				mouse_ = readMouse();
+				break;
+			case Record::Focus:
+				hasFocus_ = readByte() != 0;
+				break;
+			case Record::Key: {
+				size_t index = readVarint();
+				bool isPressed = readByte() != 0;
+				if (index < keys_.size())
+					keys_[index] = isPressed;
+				break;
+			}
+			case Record::Closed:
+				events.push_back(sf::Event::Closed{});
+				break;
+			case Record::Resized: {
+				unsigned int width = readVarint();
+				unsigned int height = readVarint();
+				events.push_back(sf::Event::Resized{{width, height}});
+				break;
+			}
+			case Record::KeyPressed: {
+				sf::Event::KeyPressed e = {};
+				readKey(e.code, e.scancode, e.alt, e.control, e.shift, e.system);
+				events.push_back(e);
+				break;
+			}
+			case Record::KeyReleased: {
+				sf::Event::KeyReleased e = {};
+				readKey(e.code, e.scancode, e.alt, e.control, e.shift, e.system);
+				events.push_back(e);
+				break;
+			}
+			case Record::MouseButtonPressed: {
+				sf::Event::MouseButtonPressed e = {};
+				e.button = (sf::Mouse::Button)readByte();
+				e.position = readVector();
+				events.push_back(e);
+				break;
+			}
+			case Record::MouseButtonReleased: {
+				sf::Event::MouseButtonReleased e = {};
+				e.button = (sf::Mouse::Button)readByte();
+				e.position = readVector();
+				events.push_back(e);
+				break;
+			}
+			case Record::MouseMoved: {
+				sf::Event::MouseMoved e = {};
+				e.position = readVector();
+				events.push_back(e);
+				break;
+			}
+			case Record::MouseWheelScrolled: {
+				sf::Event::MouseWheelScrolled e = {};
+				e.wheel = (sf::Mouse::Wheel)readByte();
+				e.delta = readFloat();
+				e.position = readVector();
+				events.push_back(e);
+				break;
+			}
+			default:
+				std::cerr << "Corrupted input log at byte " << cursor_ - 1 << "\n";
+				isFinished_ = true;
+				return false;
+			}
+		}
+		// Journal tronqué (enregistrement interrompu).
+		isFinished_ = true;
+		return false;
+	}
+
+	// Rejeu : état de la trame courante.
+	const MouseState& getMouse() const { return mouse_; }
+	bool hasFocus() const { return hasFocus_; }
+	bool isKeyPressed(sf::Keyboard::Key key) const { return keys_[keyIndex(key)]; }
+
+private:
+	enum class Record : uint8_t
+	{
+		Frame = 1,
+		End,
+		Mouse,
+		Focus,
+		Key,
+		Closed,
+		Resized,
+		KeyPressed,
+		KeyReleased,
+		MouseButtonPressed,
+		MouseButtonReleased,
+		MouseMoved,
+		MouseWheelScrolled,
+	};
+
+	static constexpr char MAGIC[8] = { 'I', 'N', 'F', '2', '7', '0', '5', 'I' };
+	static constexpr uint8_t VERSION = 1;
+	// Key::Unknown (-1) a l'index 0.
+	static constexpr size_t N_KEYS = sf::Keyboard::KeyCount + 1;
+
+	static size_t keyIndex(sf::Keyboard::Key key) {
+		return std::min<size_t>(size_t((int)key + 1), N_KEYS - 1);
+	}
+
+	static bool isSameMouse(const MouseState& a, const MouseState& b) {
+		return std::equal(std::begin(a.buttons), std::end(a.buttons), std::begin(b.buttons)) and a.absolute == b.absolute
+		   and a.relative == b.relative and a.normalized == b.normalized and a.isInsideWindow == b.isInsideWindow;
+	}
+
+	void reset() {
+		frame_ = -1;
+		recordFrame_ = -1;
+		writtenFrame_ = -1;
+		isFinished_ = false;
+		mouse_ = {};
+		hasFocus_ = false;
+		keys_.reset();
+		queriedKeys_.reset();
+	}
+
+	void writeFrameMarker() {
+		if (writtenFrame_ == frame_)
+			return;
+		writeByte((uint8_t)Record::Frame);
+		writeVarint(uint32_t(frame_ - writtenFrame_));
+		writtenFrame_ = frame_;
+	}
+
+	void writeByte(uint8_t value) {
+		buffer_.push_back(value);
+	}
+
+	void writeU32(uint32_t value) {
+		for (int i = 0; i < 4; i++)
+			writeByte(uint8_t(value >> (8 * i)));
+	}
+
+	void writeFloat(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		writeU32(bits);
+	}
+
+	// LEB128 : 7 bits par octet, le bit de poids fort indique une suite.
+	void writeVarint(uint32_t value) {
+		while (value >= 0x80) {
+			writeByte(uint8_t(value) | 0x80);
+			value >>= 7;
+		}
+		writeByte(uint8_t(value));
+	}
+
+	// Zigzag : les petits négatifs restent courts.
+	void writeSigned(int32_t value) {
+		writeVarint((uint32_t(value) << 1) ^ uint32_t(value >> 31));
+	}
+
+	void writeVector(sf::Vector2i v) {
+		writeSigned(v.x);
+		writeSigned(v.y);
+	}
+
+	void writeKey(sf::Keyboard::Key code, sf::Keyboard::Scancode scancode, bool alt, bool control, bool shift, bool system) {
+		writeVarint((uint32_t)keyIndex(code));
+		writeSigned((int32_t)scancode);
+		writeByte(uint8_t(alt) | uint8_t(control) << 1 | uint8_t(shift) << 2 | uint8_t(system) << 3);
+	}
+
+	void writeMouse(const MouseState& mouse) {
+		uint8_t buttons = 0;
+		for (unsigned int i = 0; i < sf::Mouse::ButtonCount; i++)
+			buttons |= uint8_t(mouse.buttons[i]) << i;
+		writeByte(buttons | uint8_t(mouse.isInsideWindow) << 7);
+		writeVector(mouse.absolute);
+		writeVector(mouse.relative);
+		writeFloat(mouse.normalized.x);
+		writeFloat(mouse.normalized.y);
+	}
+
+	uint8_t readByte() {
+		return cursor_ < buffer_.size() ? buffer_[cursor_++] : 0;
+	}
+
+	uint32_t readU32() {
+		uint32_t value = 0;
+		for (int i = 0; i < 4; i++)
+			value |= uint32_t(readByte()) << (8 * i);
+		return value;
+	}
+
+	float readFloat() {
+		uint32_t bits = readU32();
+		float value;
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	uint32_t readVarint() {
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			uint8_t byte = readByte();
+			value |= uint32_t(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				break;
+		}
+		return value;
+	}
+
+	int32_t readSigned() {
+		uint32_t value = readVarint();
+		return int32_t(value >> 1) ^ -int32_t(value & 1);
+	}
+
+	sf::Vector2i readVector() {
+		int32_t x = readSigned();
+		int32_t y = readSigned();
+		return { x, y };
+	}
+
+	void readKey(sf::Keyboard::Key& code, sf::Keyboard::Scancode& scancode, bool& alt, bool& control, bool& shift, bool& system) {
+		code = sf::Keyboard::Key((int)readVarint() - 1);
+		scancode = sf::Keyboard::Scancode(readSigned());
+		uint8_t flags = readByte();
+		alt = flags & 1;
+		control = flags & 2;
+		shift = flags & 4;
+		system = flags & 8;
+	}
+
+	MouseState readMouse() {
+		MouseState mouse;
+		uint8_t buttons = readByte();
+		for (unsigned int i = 0; i < sf::Mouse::ButtonCount; i++)
+			mouse.buttons[i] = (buttons >> i) & 1;
+		mouse.isInsideWindow = (buttons >> 7) & 1;
+		mouse.absolute = readVector();
+		mouse.relative = readVector();
+		mouse.normalized.x = readFloat();
+		mouse.normalized.y = readFloat();
+		return mouse;
+	}
+
+	Mode mode_ = Mode::Off;
+	Header header_;
+	std::string filename_;
+	std::ofstream file_;
+	// Tout le journal en mémoire : écrit d'un coup à la fin, lu d'un coup au début. Aucune E/S pendant les trames.
+	std::vector<uint8_t> buffer_;
+	size_t cursor_ = 0;
+
+	int frame_ = -1;
+	int recordFrame_ = -1;
+	int writtenFrame_ = -1;
+	bool isFinished_ = false;
+
+	MouseState mouse_ = {};
+	bool hasFocus_ = false;
+	std::bitset<N_KEYS> keys_;
+	std::bitset<N_KEYS> queriedKeys_;
+};
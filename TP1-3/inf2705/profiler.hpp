@@ -0,0 +1,317 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+
+#include <imgui/imgui.h>
+
+#include <inf2705/gl_debug.hpp>
+
+
+using namespace gl;
+
+
+// Profileur de trame par passe. Chaque PROFILE_SCOPE mesure le temps CPU (steady_clock) et le temps GPU
+// d'un bloc. Les requêtes GPU sont lues deux trames plus tard pour ne jamais attendre après le pilote.
+// Le GPU est mesuré par paires d'horodatages (glQueryCounter) plutôt que GL_TIME_ELAPSED, qui ne peut pas
+// être imbriqué (la trame contient les passes).
+class Profiler
+{
+public:
+	static constexpr int N_FRAMES_IN_FLIGHT = 3;
+	static constexpr int HISTORY_SIZE = 240;
+
+	static Profiler& get() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	// Appelée au début de chaque trame, avant toute mesure. Lit les résultats d'il y a deux trames.
+	// Le temps de trame est l'intervalle réel entre deux appels: le deltaTime de la simulation est
+	// fixe en mode sans fenêtre, banc d'essai ou relecture.
+	void beginFrame(int frame) {
+		auto now = std::chrono::steady_clock::now();
+		if (hasFrameStart_) {
+			std::chrono::duration<float, std::milli> frameTime = now - frameStart_;
+			frameTimes_[frameTimeIndex_] = frameTime.count();
+			frameTimeIndex_ = (frameTimeIndex_ + 1) % HISTORY_SIZE;
+			nFrameTimes_ = std::min(nFrameTimes_ + 1, HISTORY_SIZE);
+		}
+		frameStart_ = now;
+		hasFrameStart_ = true;
+
+		if (not isEnabled)
+			return;
+
+		resolve(slots_[(frame + 1) % N_FRAMES_IN_FLIGHT]);
+
+		currentSlot_ = &slots_[frame % N_FRAMES_IN_FLIGHT];
+		currentSlot_->frame = frame;
+		currentSlot_->markers.clear();
+		currentSlot_->nQueriesUsed = 0;
+		currentSlot_->lastQuery = 0;
+		openMarkers_.clear();
+	}
+
+	void endFrame() {
+		// Les blocs restés ouverts sont abandonnés, leurs requêtes n'ont pas été émises.
+		if (currentSlot_ != nullptr and not openMarkers_.empty())
+			currentSlot_->markers.resize(openMarkers_.front());
+		currentSlot_ = nullptr;
+	}
+
+	void beginScope(const char* name) {
+		if (currentSlot_ == nullptr)
+			return;
+
+		Marker marker;
+		marker.name = name;
+		marker.depth = (int)openMarkers_.size();
+		marker.queries[0] = acquireQuery();
+		marker.queries[1] = acquireQuery();
+		glQueryCounter(marker.queries[0], GL_TIMESTAMP);
+		marker.cpuStart = std::chrono::steady_clock::now();
+
+		openMarkers_.push_back(currentSlot_->markers.size());
+		currentSlot_->markers.push_back(marker);
+	}
+
+	void endScope() {
+		if (currentSlot_ == nullptr or openMarkers_.empty())
+			return;
+
+		Marker& marker = currentSlot_->markers[openMarkers_.back()];
+		openMarkers_.pop_back();
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - marker.cpuStart;
+		marker.cpuMs = elapsed.count();
+		glQueryCounter(marker.queries[1], GL_TIMESTAMP);
+		currentSlot_->lastQuery = marker.queries[1];
+	}
+
+	// Fenêtre ImGui: moyennes glissantes, p95/p99 et graphe des temps de trame.
+	void drawImGui() {
+		ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+		if (not ImGui::Begin("Profiler")) {
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Checkbox("Enabled", &isEnabled);
+		ImGui::SameLine();
+		if (ImGui::Button("Export CSV"))
+			exportCsv("profile.csv");
+
+		std::array<float, HISTORY_SIZE> ordered;
+		for (int i = 0; i < nFrameTimes_; i++)
+			ordered[i] = frameTimes_[(frameTimeIndex_ - nFrameTimes_ + i + HISTORY_SIZE) % HISTORY_SIZE];
+		Summary frameSummary = summarize(ordered.data(), nFrameTimes_);
+		char overlay[64];
+		snprintf(overlay, sizeof(overlay), "avg %.2f ms  p99 %.2f ms", frameSummary.average, frameSummary.p99);
+		ImGui::PlotLines("Frame (ms)", ordered.data(), nFrameTimes_, 0, overlay, 0.0f, std::max(frameSummary.p99 * 1.5f, 1.0f), ImVec2(0, 80));
+
+		if (ImGui::BeginTable("passes", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+			ImGui::TableSetupColumn("Pass");
+			ImGui::TableSetupColumn("CPU avg");
+			ImGui::TableSetupColumn("CPU p95");
+			ImGui::TableSetupColumn("CPU p99");
+			ImGui::TableSetupColumn("GPU avg");
+			ImGui::TableSetupColumn("GPU p95");
+			ImGui::TableSetupColumn("GPU p99");
+			ImGui::TableHeadersRow();
+			for (const History& history : histories_) {
+				Summary cpu = summarize(history.cpuMs.data(), history.count);
+				Summary gpu = summarize(history.gpuMs.data(), history.count);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Indent(history.depth * 8.0f + 1.0f);
+				ImGui::TextUnformatted(history.name);
+				ImGui::Unindent(history.depth * 8.0f + 1.0f);
+				for (float value : { cpu.average, cpu.p95, cpu.p99, gpu.average, gpu.p95, gpu.p99 }) {
+					ImGui::TableNextColumn();
+					ImGui::Text("%.3f", value);
+				}
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
+	// Une ligne par bloc et par trame conservée dans l'historique.
+	bool exportCsv(const std::string& filename) const {
+		std::ofstream file(filename);
+		if (not file) {
+			std::cerr << "Could not write profile to \"" << filename << "\"" << "\n";
+			return false;
+		}
+
+		file << "pass,depth,frame,cpu_ms,gpu_ms\n";
+		for (const History& history : histories_) {
+			for (int i = 0; i < history.count; i++) {
+				int index = (history.next - history.count + i + HISTORY_SIZE) % HISTORY_SIZE;
+				file << history.name << "," << history.depth << "," << history.frames[index] << ","
+				     << history.cpuMs[index] << "," << history.gpuMs[index] << "\n";
+			}
+		}
+		std::cout << "Profile written to \"" << filename << "\"" << std::endl;
+		return true;
+	}
+
+	bool isEnabled = true;
+
+	// Appelé pour chaque bloc dont les temps GPU sont revenus (mode banc d'essai).
+	std::function<void(const char* name, int depth, int frame, float cpuMs, float gpuMs)> listener;
+
+private:
+	Profiler() = default;
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	struct Marker
+	{
+		const char* name = "";
+		int depth = 0;
+		std::chrono::steady_clock::time_point cpuStart;
+		float cpuMs = 0.0f;
+		GLuint queries[2] = {};
+	};
+
+	struct FrameSlot
+	{
+		int frame = -1;
+		std::vector<Marker> markers;
+		std::vector<GLuint> queryPool;
+		size_t nQueriesUsed = 0;
+		GLuint lastQuery = 0;
+	};
+
+	// Historique circulaire d'un bloc, dans l'ordre de première apparition.
+	struct History
+	{
+		const char* name = "";
+		int depth = 0;
+		std::array<float, HISTORY_SIZE> cpuMs = {};
+		std::array<float, HISTORY_SIZE> gpuMs = {};
+		std::array<int, HISTORY_SIZE> frames = {};
+		int next = 0;
+		int count = 0;
+	};
+
+	struct Summary
+	{
+		float average = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+	};
+
+	GLuint acquireQuery() {
+		FrameSlot& slot = *currentSlot_;
+		if (slot.nQueriesUsed == slot.queryPool.size()) {
+			size_t oldSize = slot.queryPool.size();
+			slot.queryPool.resize(std::max<size_t>(oldSize * 2, 32));
+			glGenQueries(GLsizei(slot.queryPool.size() - oldSize), slot.queryPool.data() + oldSize);
+		}
+		return slot.queryPool[slot.nQueriesUsed++];
+	}
+
+	void resolve(FrameSlot& slot) {
+		if (slot.frame < 0 or slot.lastQuery == 0)
+			return;
+
+		// Les horodatages se terminent dans l'ordre: si le dernier émis est prêt, tous le sont.
+		// Sinon la trame est abandonnée plutôt que d'attendre.
+		GLint isAvailable = 0;
+		glGetQueryObjectiv(slot.lastQuery, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+		if (isAvailable) {
+			for (const Marker& marker : slot.markers) {
+				GLuint64 start = 0, end = 0;
+				glGetQueryObjectui64v(marker.queries[0], GL_QUERY_RESULT, &start);
+				glGetQueryObjectui64v(marker.queries[1], GL_QUERY_RESULT, &end);
+				record(marker, slot.frame, float(double(end - start) * 1e-6));
+			}
+		}
+
+		slot.markers.clear();
+		slot.frame = -1;
+	}
+
+	void record(const Marker& marker, int frame, float gpuMs) {
+		auto it = std::find_if(histories_.begin(), histories_.end(), [&](const History& h) {
+			return h.depth == marker.depth and std::strcmp(h.name, marker.name) == 0;
+		});
+		if (it == histories_.end()) {
+			histories_.emplace_back();
+			it = histories_.end() - 1;
+			it->name = marker.name;
+			it->depth = marker.depth;
+		}
+
+		it->cpuMs[it->next] = marker.cpuMs;
+		it->gpuMs[it->next] = gpuMs;
+		it->frames[it->next] = frame;
+		it->next = (it->next + 1) % HISTORY_SIZE;
+		it->count = std::min(it->count + 1, HISTORY_SIZE);
+
+		if (listener)
+			listener(marker.name, marker.depth, frame, marker.cpuMs, gpuMs);
+	}
+
+	static Summary summarize(const float* values, int count) {
+		Summary summary;
+		if (count == 0)
+			return summary;
+
+		std::array<float, HISTORY_SIZE> sorted;
+		std::copy(values, values + count, sorted.begin());
+		std::sort(sorted.begin(), sorted.begin() + count);
+		for (int i = 0; i < count; i++)
+			summary.average += sorted[i];
+		summary.average /= count;
+		summary.p95 = sorted[std::min(count - 1, int(count * 0.95f))];
+		summary.p99 = sorted[std::min(count - 1, int(count * 0.99f))];
+		return summary;
+	}
+
+	std::array<FrameSlot, N_FRAMES_IN_FLIGHT> slots_;
+	FrameSlot* currentSlot_ = nullptr;
+	std::vector<size_t> openMarkers_;
+	std::vector<History> histories_;
+
+	std::array<float, HISTORY_SIZE> frameTimes_ = {};
+	int frameTimeIndex_ = 0;
+	int nFrameTimes_ = 0;
+	std::chrono::steady_clock::time_point frameStart_;
+	bool hasFrameStart_ = false;
+};
+
+// Mesure le bloc englobant et le regroupe sous le même nom dans les outils externes (glPushDebugGroup).
+// name doit vivre aussi longtemps que le profileur (littéral).
+struct ProfileScope
+{
+	ProfileScope(const char* name) {
+		GLDebug::pushGroup(name);
+		Profiler::get().beginScope(name);
+	}
+	~ProfileScope() {
+		Profiler::get().endScope();
+		GLDebug::popGroup();
+	}
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
@@ -0,0 +1,63 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+
+
+// Triple tampon sans verrou entre un seul producteur et un seul consommateur. Le producteur remplit
+// getWriteBuffer() puis publish() ; le consommateur appelle acquire() puis lit getReadBuffer(). Chacun garde
+// son tampon à lui, le troisième est échangé atomiquement : personne n'attend, et le consommateur voit toujours
+// le plus récent publié (les intermédiaires sont sautés). Les tampons sont réutilisés, donc un T qui contient
+// des std::vector ne réalloue plus une fois sa capacité atteinte.
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// Fil producteur seulement.
+	T& getWriteBuffer() {
+		return buffers_[writeIndex_];
+	}
+
+	// Fil producteur seulement. Rend le tampon d'écriture visible au consommateur.
+	void publish() {
+		uint8_t previous = shared_.exchange(uint8_t(writeIndex_ | FRESH_BIT), std::memory_order_acq_rel);
+		writeIndex_ = previous & INDEX_MASK;
+	}
+
+	// Fil consommateur seulement. Retourne true si un nouveau tampon a été publié depuis le dernier appel.
+	bool acquire() {
+		if ((shared_.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+			return false;
+		uint8_t previous = shared_.exchange(readIndex_, std::memory_order_acq_rel);
+		readIndex_ = previous & INDEX_MASK;
+		return true;
+	}
+
+	// Fil consommateur seulement. Valide jusqu'au prochain acquire().
+	const T& getReadBuffer() const {
+		return buffers_[readIndex_];
+	}
+
+	// Avant que les deux fils ne démarrent : donne la même valeur initiale aux trois tampons.
+	void reset(const T& value) {
+		buffers_.fill(value);
+	}
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH_BIT = 0x4;
+
+	std::array<T, 3> buffers_ = {};
+	uint8_t writeIndex_ = 0;
+	uint8_t readIndex_ = 1;
+	// Index du tampon échangé, avec FRESH_BIT s'il n'a pas encore été lu.
+	std::atomic<uint8_t> shared_ = 2;
+};
@@ -0,0 +1,135 @@
+#include "camera_rail.hpp"
+
+#include <algorithm>
+
+void CameraRail::build(const BezierCurve* curves, unsigned int nCurves, unsigned int samplesPerCurve)
+{
+    samplesPerCurve_ = std::max(samplesPerCurve, 1u);
+
+    polynomials_.resize(nCurves);
+    for (unsigned int i = 0; i < nCurves; i++)
+    {
+        const BezierCurve& c = curves[i];
+        polynomials_[i].a = -c.p0 + 3.0f * c.c0 - 3.0f * c.c1 + c.p1;
+        polynomials_[i].b = 3.0f * c.p0 - 6.0f * c.c0 + 3.0f * c.c1;
+        polynomials_[i].c = -3.0f * c.p0 + 3.0f * c.c0;
+        polynomials_[i].d = c.p0;
+    }
+
+    // Rail vide: getPosition() et getFrame() gèrent déjà ce cas.
+    if (nCurves == 0)
+    {
+        distances_.clear();
+        frames_.clear();
+        return;
+    }
+
+    size_t nSamples = static_cast<size_t>(nCurves) * samplesPerCurve_ + 1;
+    distances_.resize(nSamples);
+    frames_.resize(nSamples);
+
+    // Longueurs cumulées par cordes entre échantillons.
+    distances_[0] = 0.0f;
+    frames_[0].position = evaluate(0, 0.0f);
+    for (size_t s = 1; s < nSamples; s++)
+    {
+        frames_[s].position = evaluate(s - 1, 1.0f);
+        distances_[s] = distances_[s - 1] + glm::length(frames_[s].position - frames_[s - 1].position);
+    }
+
+    // Tangentes par la dérivée du polynôme.
+    for (size_t s = 0; s < nSamples; s++)
+    {
+        size_t curve = std::min(s / samplesPerCurve_, polynomials_.size() - 1);
+        float t = static_cast<float>(s - curve * samplesPerCurve_) / samplesPerCurve_;
+        const Polynomial& p = polynomials_[curve];
+        glm::vec3 derivative = (3.0f * p.a * t + 2.0f * p.b) * t + p.c;
+        frames_[s].tangent = glm::length(derivative) > 1e-6f ? glm::normalize(derivative) : glm::vec3(1.0f, 0.0f, 0.0f);
+    }
+
+    // Repères à rotation minimale (double réflexion), en partant de la
+    // verticale projetée sur le plan normal à la première tangente.
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 normal = up - glm::dot(up, frames_[0].tangent) * frames_[0].tangent;
+    frames_[0].normal = glm::length(normal) > 1e-6f ? glm::normalize(normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+    for (size_t s = 0; s + 1 < nSamples; s++)
+    {
+        CameraRailFrame& current = frames_[s];
+        CameraRailFrame& next = frames_[s + 1];
+
+        glm::vec3 v1 = next.position - current.position;
+        float c1 = glm::dot(v1, v1);
+        glm::vec3 reflectedNormal = current.normal;
+        glm::vec3 reflectedTangent = current.tangent;
+        if (c1 > 1e-12f)
+        {
+            reflectedNormal -= (2.0f / c1) * glm::dot(v1, current.normal) * v1;
+            reflectedTangent -= (2.0f / c1) * glm::dot(v1, current.tangent) * v1;
+        }
+
+        glm::vec3 v2 = next.tangent - reflectedTangent;
+        float c2 = glm::dot(v2, v2);
+        next.normal = c2 > 1e-12f ? reflectedNormal - (2.0f / c2) * glm::dot(v2, reflectedNormal) * v2 : reflectedNormal;
+    }
+
+    for (CameraRailFrame& frame : frames_)
+        frame.binormal = glm::cross(frame.tangent, frame.normal);
+}
+
+float CameraRail::getLength() const
+{
+    return distances_.empty() ? 0.0f : distances_.back();
+}
+
+void CameraRail::locate(float distance, size_t& sample, float& fraction) const
+{
+    distance = glm::clamp(distance, 0.0f, getLength());
+
+    // Premier échantillon strictement après distance.
+    size_t upper = std::upper_bound(distances_.begin(), distances_.end(), distance) - distances_.begin();
+    sample = std::min(upper, distances_.size() - 1) - 1;
+
+    float length = distances_[sample + 1] - distances_[sample];
+    fraction = length > 0.0f ? glm::clamp((distance - distances_[sample]) / length, 0.0f, 1.0f) : 0.0f;
+}
+
+// Entre deux échantillons, la longueur d'arc est approximée comme linéaire
+// en t; l'erreur diminue avec samplesPerCurve.
+glm::vec3 CameraRail::evaluate(size_t sample, float fraction) const
+{
+    size_t curve = sample / samplesPerCurve_;
+    float t = (static_cast<float>(sample - curve * samplesPerCurve_) + fraction) / samplesPerCurve_;
+    const Polynomial& p = polynomials_[curve];
+    return ((p.a * t + p.b) * t + p.c) * t + p.d;
+}
+
+glm::vec3 CameraRail::getPosition(float distance) const
+{
+    if (polynomials_.empty())
+        return glm::vec3(0.0f);
+
+    size_t sample;
+    float fraction;
+    locate(distance, sample, fraction);
+    return evaluate(sample, fraction);
+}
+
+CameraRailFrame CameraRail::getFrame(float distance) const
+{
+    if (polynomials_.empty())
+        return { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+    size_t sample;
+    float fraction;
+    locate(distance, sample, fraction);
+
+    const CameraRailFrame& a = frames_[sample];
+    const CameraRailFrame& b = frames_[sample + 1];
+
+    CameraRailFrame frame;
+    frame.position = evaluate(sample, fraction);
+    frame.tangent = glm::normalize(glm::mix(a.tangent, b.tangent, fraction));
+    frame.normal = glm::normalize(glm::mix(a.normal, b.normal, fraction));
+    frame.binormal = glm::cross(frame.tangent, frame.normal);
+    return frame;
+}
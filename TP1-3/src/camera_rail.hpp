@@ -0,0 +1,57 @@
+#ifndef CAMERA_RAIL_H
+#define CAMERA_RAIL_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct BezierCurve
+{
+    glm::vec3 p0;
+    glm::vec3 c0;
+    glm::vec3 c1;
+    glm::vec3 p1;
+};
+
+// Repère le long du rail: tangent est la direction de déplacement, normal et
+// binormal tournent le moins possible d'un échantillon à l'autre.
+struct CameraRailFrame
+{
+    glm::vec3 position;
+    glm::vec3 tangent;
+    glm::vec3 normal;
+    glm::vec3 binormal;
+};
+
+// Suite de courbes de Bézier paramétrée par la longueur d'arc. La table des
+// longueurs cumulées et les repères sont calculés une fois dans build();
+// une évaluation coûte une recherche binaire et un polynôme de degré 3.
+class CameraRail
+{
+public:
+    void build(const BezierCurve* curves, unsigned int nCurves, unsigned int samplesPerCurve = 64);
+
+    float getLength() const;
+
+    // distance est ramenée dans [0, getLength()].
+    glm::vec3 getPosition(float distance) const;
+    CameraRailFrame getFrame(float distance) const;
+
+private:
+    // Coefficients de ((a t + b) t + c) t + d.
+    struct Polynomial
+    {
+        glm::vec3 a, b, c, d;
+    };
+
+    // Échantillon précédant distance et position entre lui et le suivant.
+    void locate(float distance, size_t& sample, float& fraction) const;
+    glm::vec3 evaluate(size_t sample, float fraction) const;
+
+    std::vector<Polynomial> polynomials_;
+    std::vector<float> distances_;
+    std::vector<CameraRailFrame> frames_;
+    unsigned int samplesPerCurve_ = 1;
+};
+
+#endif // CAMERA_RAIL_H
@@ -3,6 +3,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <map>
+#include <memory_resource>
 
 #include "shaders.hpp"
 
@@ -19,23 +20,20 @@ struct Material
 };
 
 Car::Car()
-    : position(0.0f, 0.0f, 0.0f), orientation(0.0f, 0.0f)
-    , speed(0.f), wheelsRollAngle(0.f), steeringAngle(0.f)
-    , isHeadlightOn(false), isBraking(false)
-    , isLeftBlinkerActivated(false), isRightBlinkerActivated(false)
-    , isBlinkerOn(false), blinkerTimer(0.f)
+    : carModel(1.0f)
 {
 }
 
 void Car::loadModels()
 {
-    frame_.load("../models/frame.ply");
-    wheel_.load("../models/wheel.ply");
-    blinker_.load("../models/blinker.ply");
-    light_.load("../models/light.ply");
-
-    const char* WINDOW_MODEL_PATHES[] =
+    Model* models[] = { &frame_, &wheel_, &blinker_, &light_,
+        &windows[0], &windows[1], &windows[2], &windows[3], &windows[4], &windows[5] };
+    const char* MODEL_PATHES[] =
     {
+        "../models/frame.ply",
+        "../models/wheel.ply",
+        "../models/blinker.ply",
+        "../models/light.ply",
         "../models/window.f.ply",
         "../models/window.r.ply",
         "../models/window.fl.ply",
@@ -43,14 +41,14 @@ void Car::loadModels()
         "../models/window.rl.ply",
         "../models/window.rr.ply"
     };
-    for (unsigned int i = 0; i < 6; ++i)
-    {
-        windows[i].load(WINDOW_MODEL_PATHES[i]);
-    }
+    Model::loadAll(models, MODEL_PATHES, 10);
 }
 
-void Car::update(float deltaTime)
+void CarState::update(float deltaTime)
 {
+    previousPosition = position;
+    previousOrientation = orientation;
+
     if (isBraking)
     {
         const float LOW_SPEED_THRESHOLD = 0.1f;
@@ -94,10 +92,39 @@ void Car::update(float deltaTime)
         isBlinkerOn = true;
         blinkerTimer = 0.f;
     }
+}
+
+CarControls CarState::getControls() const
+{
+    return { speed, steeringAngle, isHeadlightOn, isBraking, isLeftBlinkerActivated, isRightBlinkerActivated };
+}
+
+void CarState::setControls(const CarControls& controls)
+{
+    speed = controls.speed;
+    steeringAngle = controls.steeringAngle;
+    isHeadlightOn = controls.isHeadlightOn;
+    isBraking = controls.isBraking;
+    isLeftBlinkerActivated = controls.isLeftBlinkerActivated;
+    isRightBlinkerActivated = controls.isRightBlinkerActivated;
+}
+
+glm::mat4 CarState::getTransform() const
+{
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+    return glm::rotate(transform, orientation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+}
 
+void Car::setState(const CarState& state)
+{
+    static_cast<CarState&>(*this) = state;
+}
+
+void Car::interpolate(float alpha)
+{
     carModel = glm::mat4(1.0f);
-    carModel = glm::translate(carModel, position);
-    carModel = glm::rotate(carModel, orientation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+    carModel = glm::translate(carModel, glm::mix(previousPosition, position, alpha));
+    carModel = glm::rotate(carModel, glm::mix(previousOrientation.y, orientation.y, alpha), glm::vec3(0.0f, 1.0f, 0.0f));
 }
 
 
@@ -112,8 +139,7 @@ void Car::draw(glm::mat4& projView, glm::mat4& view)
 
     celShadingShader->use();
 
-    glm::mat4 carTransform = glm::translate(glm::mat4(1.0f), position);
-    carTransform = glm::rotate(carTransform, orientation.y, glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 carTransform = carModel;
     glm::mat4 carMVP = projView * carTransform;
 
     drawFrame(projView, view, carTransform);
@@ -184,7 +210,7 @@ void Car::drawWheels(const mat4& carMVP)
 }
 
 
-void Car::drawWindows(glm::mat4& projView, glm::mat4& view)
+void Car::drawWindows(glm::mat4& projView, glm::mat4& view, std::pmr::memory_resource* memory)
 {
     const glm::vec3 WINDOW_POSITION[] =
     {
@@ -196,14 +222,14 @@ void Car::drawWindows(glm::mat4& projView, glm::mat4& view)
         glm::vec3(0.643, 0.756, -0.508)
     };
 
-    std::map<float, unsigned int> sorted;
+    std::pmr::map<float, unsigned int> sorted(memory);
     for (unsigned int i = 0; i < 6; i++)
     {
       
     }
 
   
-    for (std::map<float, unsigned int>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
+    for (std::pmr::map<float, unsigned int>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it)
     {
     }
 }
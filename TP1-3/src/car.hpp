@@ -3,6 +3,8 @@
 #include <glbinding/gl/gl.h>
 #include <glm/glm.hpp>
 
+#include <memory_resource>
+
 #include "model.hpp"
 #include "uniform_buffer.hpp"
 
@@ -10,18 +12,63 @@
 class EdgeEffect;
 class CelShading;
 
-class Car
+// Commandes de l'interface, envoyées au fil de simulation.
+struct CarControls
+{
+    float speed = 0.f;
+    float steeringAngle = 0.f;
+    bool isHeadlightOn = false;
+    bool isBraking = false;
+    bool isLeftBlinkerActivated = false;
+    bool isRightBlinkerActivated = false;
+};
+
+// État simulé de l'auto, sans ressource OpenGL: il peut avancer sur le fil de simulation et être copié tel quel
+// dans un instantané pour le rendu.
+struct CarState
+{
+    void update(float deltaTime);
+
+    CarControls getControls() const;
+    void setControls(const CarControls& controls);
+
+    // Transformation au dernier pas simulé, sans interpolation.
+    glm::mat4 getTransform() const;
+
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec2 orientation = glm::vec2(0.0f);
+    glm::vec3 previousPosition = glm::vec3(0.0f);
+    glm::vec2 previousOrientation = glm::vec2(0.0f);
+
+    float speed = 0.f;
+    float wheelsRollAngle = 0.f;
+    float steeringAngle = 0.f;
+    bool isHeadlightOn = false;
+    bool isBraking = false;
+    bool isLeftBlinkerActivated = false;
+    bool isRightBlinkerActivated = false;
+
+    bool isBlinkerOn = false;
+    float blinkerTimer = 0.f;
+};
+
+class Car : public CarState
 {
 public:
     Car();
 
     void loadModels();
 
-    void update(float deltaTime);
+    // Remplace l'état simulé, par exemple par celui d'un instantané.
+    void setState(const CarState& state);
+
+    // Calcule carModel entre l'état précédent et l'état courant (alpha dans [0, 1]).
+    void interpolate(float alpha);
 
     void draw(glm::mat4& projView, glm::mat4& view); 
 
-    void drawWindows(glm::mat4& projView, glm::mat4& view); 
+    // memory : ressource des données temporaires du tri, typiquement l'arène de la trame.
+    void drawWindows(glm::mat4& projView, glm::mat4& view, std::pmr::memory_resource* memory); 
 
 private:
    
@@ -43,20 +90,6 @@ private:
     Model windows[6]; 
 
 public:
-    glm::vec3 position;
-    glm::vec2 orientation;
-
-    float speed;
-    float wheelsRollAngle;
-    float steeringAngle;
-    bool isHeadlightOn;
-    bool isBraking;
-    bool isLeftBlinkerActivated;
-    bool isRightBlinkerActivated;
-
-    bool isBlinkerOn;
-    float blinkerTimer;
-
     GLuint colorModUniformLocation;
     GLuint mvpUniformLocation;
 
@@ -0,0 +1,61 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// Plans du frustum extraits d'une matrice projection * vue (Gribb-Hartmann).
+// Chaque plan est normalisé et orienté vers l'intérieur: dot(n, p) + d >= 0.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& projView)
+    {
+        glm::vec4 rowX(projView[0][0], projView[1][0], projView[2][0], projView[3][0]);
+        glm::vec4 rowY(projView[0][1], projView[1][1], projView[2][1], projView[3][1]);
+        glm::vec4 rowZ(projView[0][2], projView[1][2], projView[2][2], projView[3][2]);
+        glm::vec4 rowW(projView[0][3], projView[1][3], projView[2][3], projView[3][3]);
+
+        Frustum frustum;
+        frustum.planes[0] = rowW + rowX; // gauche
+        frustum.planes[1] = rowW - rowX; // droite
+        frustum.planes[2] = rowW + rowY; // bas
+        frustum.planes[3] = rowW - rowY; // haut
+        frustum.planes[4] = rowW + rowZ; // proche
+        frustum.planes[5] = rowW - rowZ; // loin
+
+        for (glm::vec4& plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+
+        return frustum;
+    }
+
+    // Faux seulement si la sphère est entièrement derrière un des plans.
+    bool intersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // Test conservateur: une boîte qui chevauche un coin du frustum peut être acceptée.
+    bool intersectsBox(const glm::vec3& minCorner, const glm::vec3& maxCorner) const
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            glm::vec3 positive(
+                plane.x >= 0.0f ? maxCorner.x : minCorner.x,
+                plane.y >= 0.0f ? maxCorner.y : minCorner.y,
+                plane.z >= 0.0f ? maxCorner.z : minCorner.z);
+
+            if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif // FRUSTUM_H
@@ -1,9 +1,13 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -16,18 +20,22 @@
 #include "happly.h"
 #include <imgui/imgui.h>
 
+// Compte les appels à new pour le panneau Memory du profileur.
+#define INF2705_ALLOCATION_COUNTER_IMPLEMENTATION
 #include <inf2705/OpenGLApplication.hpp>
 
 #include "model.hpp"
+#include "camera_rail.hpp"
 #include "car.hpp"
+#include "frustum.hpp"
 #include "model_data.hpp"
+#include "particle_simulator.hpp"
+#include "particle_system.hpp"
 #include "shaders.hpp"
 #include "textures.hpp"
 #include "uniform_buffer.hpp"
 #include "shader_storage_buffer.hpp"
 
-#define CHECK_GL_ERROR printGLError(__FILE__, __LINE__)
-
 using namespace gl;
 using namespace glm;
 
@@ -135,14 +143,6 @@ Material bezierMat =
     0.0f
 };
 
-struct BezierCurve
-{
-    glm::vec3 p0;
-    glm::vec3 c0;
-    glm::vec3 c1;
-    glm::vec3 p1;
-};
-
 BezierCurve curves[5] =
 {
     {
@@ -184,10 +184,8 @@ const vec4 green = { 0.f, 1.f, 0.f, 1.0f };
 const vec4 blue = { 0.f, 0.f, 1.f, 1.0f };
 
 unsigned int bezierNPoints = 3;
-unsigned int oldBezierNPoints = 0;
 
 int cameraMode = 0;
-float cameraAnimation = 0.f;
 bool isAnimatingCamera = false;
 vec3 resetCameraPosition = { -20.53f, 10.36f, -12.87f };
 
@@ -195,8 +193,6 @@ struct App : public OpenGLApplication
 {
     App()
         : totalTime(0.0)       // Initialiser à 0
-        , timerParticles_(0.0) // Initialiser à 0
-        , nParticles_(0)       // Initialiser à 0
         , isDay_(true)
         , cameraPosition_(resetCameraPosition)
         , cameraOrientation_(-0.31f, 4.18f)
@@ -234,8 +230,8 @@ struct App : public OpenGLApplication
         skyShader_.create();
         bezierShader_.create();
         grassShader_.create();
-        particlesShader_.create();
-        particlesUpdateShader_.create();
+        grassGenerateShader_.create();
+        grassBladeShader_.create();
 
         car_.celShadingShader = &celShadingShader_;
         car_.edgeEffectShader = &edgeEffectShader_;
@@ -268,6 +264,7 @@ struct App : public OpenGLApplication
         // Partie 3
 
         material_.allocate(&defaultMat, sizeof(Material));
+        material_.setLabel("Material");
         material_.setBindingIndex(0);
 
         lightsData_.dirLight =
@@ -278,36 +275,7 @@ struct App : public OpenGLApplication
             {0.5f, -1.0f, 0.5f, 0.0f}
         };
 
-        for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
-        {
-            lightsData_.spotLights[i].position = glm::vec4(streetlightLightPositions[i], 0.0f);
-            lightsData_.spotLights[i].direction = glm::vec3(0, -1, 0);
-            lightsData_.spotLights[i].exponent = 6.0f;
-            lightsData_.spotLights[i].openingAngle = 60.f;
-        }
-
-        // Initialisation des paramètres de lumière des phares
-
-        lightsData_.spotLights[N_STREETLIGHTS].position = glm::vec4(-1.6, 0.64, -0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS].direction = glm::vec3(-10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS].openingAngle = 30.f;
-
-        lightsData_.spotLights[N_STREETLIGHTS + 1].position = glm::vec4(-1.6, 0.64, 0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS + 1].direction = glm::vec3(-10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS + 1].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS + 1].openingAngle = 30.f;
-
-        lightsData_.spotLights[N_STREETLIGHTS + 2].position = glm::vec4(1.6, 0.64, -0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS + 2].direction = glm::vec3(10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS + 2].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS + 2].openingAngle = 60.f;
-
-        lightsData_.spotLights[N_STREETLIGHTS + 3].position = glm::vec4(1.6, 0.64, 0.45, 0.0f);
-        lightsData_.spotLights[N_STREETLIGHTS + 3].direction = glm::vec3(10, -1, 0);
-        lightsData_.spotLights[N_STREETLIGHTS + 3].exponent = 4.0f;
-        lightsData_.spotLights[N_STREETLIGHTS + 3].openingAngle = 60.f;
-
+        initSpotLights();
 
         toggleStreetlight();
         updateCarLight();
@@ -315,23 +283,76 @@ struct App : public OpenGLApplication
         setLightingUniform();
 
         lights_.allocate(&lightsData_, sizeof(lightsData_));
+        lights_.setLabel("Lights");
         lights_.setBindingIndex(1);
         bezierVAO_ = 0;
         bezierVBO_ = 0;
         bezierVertexCount = 0;
 
-        buildAndUploadBezierMesh();
+        updateBezierMesh(getPerspectiveProjectionMatrix(), getViewMatrix());
+        cameraRail_.build(curves, nPoints);
+        cameraRailSpeed_ = cameraRail_.getLength() / (CAMERA_SECONDS_PER_CURVE * nPoints);
 
-        generateGrassPatches(110, 55, 0.9f);
+        generateGrassPatches(grassGridX_, grassGridZ_, grassCellSize_);
+        initGrassBlades();
+        initGrassStatistics();
 
         initParticles();
 
+        for (int i = 1; i < argc_; i++)
+        {
+            if (std::strcmp(argv_[i], "--particle-check") == 0)
+            {
+                exitCode_ = checkParticleSimulator() ? 0 : 1;
+                window_.close();
+            }
+        }
+
         glEnable(GL_PROGRAM_POINT_SIZE); // pour être en mesure de modifier gl_PointSize dans les shaders
 
         CHECK_GL_ERROR;
     }
 
 
+    // Scène de stress (--stress, --benchmark): trees, streetlights, grass (densité relative) et particles (capacité).
+    void applyStressConfig(const StressConfig& config) override
+    {
+        nTrees_ = std::max(1, config.getInt("trees", DEFAULT_N_TREES));
+        nStreetlights_ = std::max(1, config.getInt("streetlights", DEFAULT_N_STREETLIGHTS));
+        initStaticModelMatrices();
+
+        initSpotLights();
+        toggleStreetlight();
+        updateCarLight();
+        setLightingUniform();
+        lights_.updateData(&lightsData_, 0, sizeof(lightsData_));
+        updateStreetlightSmokeEmitters();
+
+        setGrassDensity(std::max(0.01f, config.get("grass", 1.0f)));
+
+        GLuint capacity = static_cast<GLuint>(std::max(1, config.getInt("particles", PARTICLE_CAPACITY)));
+        if (capacity != particles_.getCapacity())
+            particles_.setCapacity(capacity);
+        requestedParticleCapacity_ = static_cast<int>(capacity);
+
+        std::cout << "Stress: " << nTrees_ << " trees, " << nStreetlights_ << " streetlights (" << nLitStreetlights_ << " lit), "
+            << grassGridX_ * grassGridZ_ << " grass cells, " << capacity << " particles" << std::endl;
+    }
+
+    // Même étendue de gazon, density fois plus de cellules et de brins.
+    void setGrassDensity(float density)
+    {
+        float scale = std::sqrt(density);
+        grassGridX_ = std::max(1, static_cast<int>(std::lround(DEFAULT_GRASS_GRID_X * scale)));
+        grassGridZ_ = std::max(1, static_cast<int>(std::lround(DEFAULT_GRASS_GRID_Z * scale)));
+        grassCellSize_ = DEFAULT_GRASS_CELL_SIZE * DEFAULT_GRASS_GRID_X / grassGridX_;
+        maxGrassBlades_ = std::max<GLuint>(1024, static_cast<GLuint>(DEFAULT_MAX_GRASS_BLADES * density));
+
+        generateGrassPatches(grassGridX_, grassGridZ_, grassCellSize_);
+        grassBlades_.allocate(nullptr, maxGrassBlades_ * sizeof(GrassBlade), GL_DYNAMIC_COPY);
+    }
+
+
     void checkShaderCompilingError(const char* name, GLuint id)
     {
         GLint success;
@@ -362,6 +383,30 @@ struct App : public OpenGLApplication
     }
 
 
+    // État de l'auto au pas fixe, sur le fil de simulation si --sim-thread. Le rendu ne lit que les instantanés.
+    void simulate(float fixedDeltaTime) override
+    {
+        if (carControls_.acquire())
+            simulatedCar_.setControls(carControls_.getReadBuffer());
+        simulatedCar_.update(fixedDeltaTime);
+
+        SceneSnapshot& snapshot = snapshots_.getWriteBuffer();
+        snapshot.car = simulatedCar_;
+        snapshot.publishTime = getElapsedTime();
+        snapshots_.publish();
+    }
+
+    // Pas fixe du côté OpenGL: les particules sont simulées sur le GPU.
+    void fixedUpdate(float fixedDeltaTime) override
+    {
+        snapshots_.acquire();
+
+        PROFILE_SCOPE("Particles Update");
+        updateParticles(fixedDeltaTime);
+        CHECK_GL_ERROR;
+    }
+
+
     // Appelée à chaque trame. Le buffer swap est fait juste après.
     void drawFrame() override
     {
@@ -376,11 +421,22 @@ struct App : public OpenGLApplication
             celShadingShader_.reload();
             skyShader_.reload();
             grassShader_.reload();
-            particlesShader_.reload();
-            particlesUpdateShader_.reload();
+            grassGenerateShader_.reload();
+            grassBladeShader_.reload();
+            particles_.reloadShaders();
             setLightingUniform();
             CHECK_GL_ERROR;
         }
+        if (ImGui::Button("Screenshot"))
+            saveScreenshot();
+        ImGui::SameLine();
+        if (ImGui::Button(isRecording() ? "Stop Recording" : "Record"))
+        {
+            if (isRecording())
+                stopRecording();
+            else
+                startRecording("recording.y4m");
+        }
         ImGui::End();
 
         sceneMain();
@@ -396,6 +452,7 @@ struct App : public OpenGLApplication
         glDeleteBuffers(1, &ebo_);
         glDeleteVertexArrays(1, &vao_);
         glDeleteVertexArrays(1, &bezierVAO_);
+        glDeleteVertexArrays(1, &grassBladeVAO_);
     }
 
     // Appelée lors d'une touche de clavier.
@@ -444,7 +501,7 @@ struct App : public OpenGLApplication
 
     void updateCameraInput()
     {
-        if (!window_.hasFocus())
+        if (!hasFocus())
             return;
 
         if (isMouseMotionEnabled_)
@@ -459,13 +516,13 @@ struct App : public OpenGLApplication
 
         const float KEYBOARD_MOUSE_SENSITIVITY = 1.5f;
 
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Up))
+        if (isKeyPressed(sf::Keyboard::Key::Up))
             cameraMouvementX -= KEYBOARD_MOUSE_SENSITIVITY;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Down))
+        if (isKeyPressed(sf::Keyboard::Key::Down))
             cameraMouvementX += KEYBOARD_MOUSE_SENSITIVITY;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Left))
+        if (isKeyPressed(sf::Keyboard::Key::Left))
             cameraMouvementY -= KEYBOARD_MOUSE_SENSITIVITY;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Right))
+        if (isKeyPressed(sf::Keyboard::Key::Right))
             cameraMouvementY += KEYBOARD_MOUSE_SENSITIVITY;
 
         cameraOrientation_.y -= cameraMouvementY * deltaTime_;
@@ -476,38 +533,38 @@ struct App : public OpenGLApplication
         const float SPEED = 10.f;
         if (isQWERTY_)
         {
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W))
+            if (isKeyPressed(sf::Keyboard::Key::W))
                 positionOffset.z -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S))
+            if (isKeyPressed(sf::Keyboard::Key::S))
                 positionOffset.z += SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A))
+            if (isKeyPressed(sf::Keyboard::Key::A))
                 positionOffset.x -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
+            if (isKeyPressed(sf::Keyboard::Key::D))
                 positionOffset.x += SPEED;
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q))
+            if (isKeyPressed(sf::Keyboard::Key::Q))
                 positionOffset.y -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::E))
+            if (isKeyPressed(sf::Keyboard::Key::E))
                 positionOffset.y += SPEED;
         }
         else {
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Z))
+            if (isKeyPressed(sf::Keyboard::Key::Z))
                 positionOffset.z -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S))
+            if (isKeyPressed(sf::Keyboard::Key::S))
                 positionOffset.z += SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q))
+            if (isKeyPressed(sf::Keyboard::Key::Q))
                 positionOffset.x -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
+            if (isKeyPressed(sf::Keyboard::Key::D))
                 positionOffset.x += SPEED;
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A))
+            if (isKeyPressed(sf::Keyboard::Key::A))
                 positionOffset.y -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl))
+            if (isKeyPressed(sf::Keyboard::Key::LControl))
                 positionOffset.y -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::E))
+            if (isKeyPressed(sf::Keyboard::Key::E))
                 positionOffset.y += SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift))
+            if (isKeyPressed(sf::Keyboard::Key::LShift))
                 positionOffset.y += SPEED;
         }
         positionOffset = glm::rotate(glm::mat4(1.0f), cameraOrientation_.y, glm::vec3(0.0, 1.0, 0.0)) * glm::vec4(positionOffset, 1);
@@ -517,13 +574,21 @@ struct App : public OpenGLApplication
     void loadModels()
     {
         car_.loadModels();
-        tree_.load("../models/tree.ply");
-        streetlight_.load("../models/streetlight.ply");
-        streetlightLight_.load("../models/streetlight_light.ply");
-        skybox_.load("../models/skybox.ply");
+
+        Model* models[] = { &tree_, &streetlight_, &streetlightLight_, &skybox_ };
+        const char* MODEL_PATHES[] =
+        {
+            "../models/tree.ply",
+            "../models/streetlight.ply",
+            "../models/streetlight_light.ply",
+            "../models/skybox.ply"
+        };
+        Model::loadAll(models, MODEL_PATHES, 4);
 
         grass_.load(ground, sizeof(ground), planeElements, sizeof(planeElements)); 
         street_.load(street, sizeof(street), planeElements, sizeof(planeElements));
+        grass_.setLabel("Ground");
+        street_.setLabel("Street");
     }
 
     void loadTextures()
@@ -547,16 +612,21 @@ struct App : public OpenGLApplication
     void initStreetlights()
     {
         lightsPosition.clear();
-        lightsPosition.reserve(N_STREETLIGHTS);
+        lightsPosition.reserve(nStreetlights_);
+        streetlightModelMatrices_.resize(nStreetlights_);
+        streetlightLightPositions.resize(nStreetlights_);
+        nLitStreetlights_ = std::min(nStreetlights_, MAX_LIT_STREETLIGHTS);
         float position = -0.f;
 
 
-        for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+        for (unsigned int i = 0; i < nStreetlights_; i++)
         {
-            position = 110.f *i / N_STREETLIGHTS+(rand() % N_STREETLIGHTS);
+            position = 110.f *i / nStreetlights_+(rand() % nStreetlights_);
             position = std::fmod(position, 100.f);
             lightsPosition.push_back(position - 50.f);
 
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(lightsPosition[i], -0.15f, getRoadsideZ(i, nStreetlights_, DEFAULT_N_STREETLIGHTS)));
+            streetlightModelMatrices_[i] = glm::rotate(model, glm::radians(i % 2 == 0 ? -90.f : 90.f), glm::vec3(0.f, 1.f, 0.f));
             streetlightLightPositions[i] = glm::vec3(streetlightModelMatrices_[i] * glm::vec4(-2.77, 5.2, 0.0, 1.0));
         }
     }
@@ -567,15 +637,16 @@ struct App : public OpenGLApplication
         treesOrientation.clear();
         treesScale.clear();
 
-        treesPosition.reserve(N_TREES);
-        treesOrientation.reserve(N_TREES);
-        treesScale.reserve(N_TREES);
+        treesPosition.reserve(nTrees_);
+        treesOrientation.reserve(nTrees_);
+        treesScale.reserve(nTrees_);
+        treeModelMatrices_.resize(nTrees_);
 
         float position = 0.f;
 
-        for (unsigned int i = 0; i < N_TREES; i++)
+        for (unsigned int i = 0; i < nTrees_; i++)
         {
-            position = 110.f*i / N_TREES + (rand() % N_TREES);
+            position = 110.f*i / nTrees_ + (rand() % nTrees_);
             position = std::fmod(position,100.f);
             treesPosition.push_back(position -50.f);
         
@@ -585,9 +656,42 @@ struct App : public OpenGLApplication
 
             float scale = 0.6f + (rand() % 60) / 100.f;
             treesScale.push_back(scale);
+
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(treesPosition[i], -0.15f, getRoadsideZ(i, nTrees_, DEFAULT_N_TREES)));
+            model = glm::rotate(model, angleRad, glm::vec3(0.f, 1.f, 0.f));
+            treeModelMatrices_[i] = glm::scale(model, glm::vec3(scale));
         }
     }
 
+    // Matrices de dessin et de contour (agrandi de 3 % autour de center) de chaque instance dans instanceMatrices_,
+    // calculées en parallèle avant les boucles de dessin: celles-ci ne font plus que les appels OpenGL, sur ce fil.
+    void buildInstanceMatrices(const std::vector<glm::mat4>& models, const glm::vec3& center, const glm::mat4& projView)
+    {
+        glm::mat4 outline = glm::translate(glm::mat4(1.0f), center);
+        outline = glm::scale(outline, glm::vec3(1.03f));
+        outline = glm::translate(outline, -center);
+
+        instanceMatrices_.resize(models.size());
+        JobSystem::get().parallelFor(static_cast<uint32_t>(models.size()), INSTANCE_MATRIX_GRAIN, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                InstanceMatrices& instance = instanceMatrices_[i];
+                instance.mvp = projView * models[i];
+                instance.outlineModel = models[i] * outline;
+                instance.outlineMvp = projView * instance.outlineModel;
+            }
+        });
+    }
+
+    // Côté de la rue selon la parité, puis une rangée de plus en retrait par tranche de defaultCount objets.
+    static float getRoadsideZ(unsigned int i, unsigned int count, unsigned int defaultCount)
+    {
+        unsigned int nRows = std::max(1u, (count + defaultCount - 1) / defaultCount);
+        float offset = 3.f + ROADSIDE_ROW_SPACING * ((i / 2) % nRows);
+        return i % 2 == 0 ? offset : -offset;
+    }
+
     void drawStreetlights(glm::mat4& projView)
     {
         glm::mat4 view = getViewMatrix();
@@ -602,28 +706,18 @@ struct App : public OpenGLApplication
         glStencilMask(0xFF);
         glClear(GL_STENCIL_BUFFER_BIT);
 
+        buildInstanceMatrices(streetlightModelMatrices_, streetlight_.center_, projView);
+
         celShadingShader_.use();
 
-        for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+        for (unsigned int i = 0; i < nStreetlights_; i++)
         {
-            float x = lightsPosition[i];
-            float z = (i % 2 == 0 ? 3.f : -3.f);
-
-            glm::mat4 model(1.0f);
-            model = glm::translate(model, glm::vec3(x, -0.15f, z));
-            if (i % 2 == 0)
-                model = glm::rotate(model, glm::radians(-90.f), glm::vec3(0.f, 1.f, 0.f));
-            else
-                model = glm::rotate(model, glm::radians(90.f), glm::vec3(0.f, 1.f, 0.f));
-
-            glm::mat4 mvp = projView * model;
-
             if (!isDay_)
                 setMaterial(streetlightLightMat);
             else
                 setMaterial(streetlightMat);
 
-            celShadingShader_.setMatrices(mvp, view, model);
+            celShadingShader_.setMatrices(instanceMatrices_[i].mvp, view, streetlightModelMatrices_[i]);
             streetlight_.draw();
             
         }
@@ -634,25 +728,9 @@ struct App : public OpenGLApplication
 
         edgeEffectShader_.use();
 
-        for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+        for (unsigned int i = 0; i < nStreetlights_; i++)
         {
-            float x = lightsPosition[i];
-            float z = (i % 2 == 0 ? 3.f : -3.f);
-
-            glm::mat4 model(1.0f);
-            model = glm::translate(model, glm::vec3(x, -0.15f, z));
-            if (i % 2 == 0)
-                model = glm::rotate(model, glm::radians(-90.f), glm::vec3(0.f, 1.f, 0.f));
-            else
-                model = glm::rotate(model, glm::radians(90.f), glm::vec3(0.f, 1.f, 0.f));
-
-            glm::vec3 center = streetlight_.center_;
-            glm::mat4 scaledModel = glm::translate(model, center);
-            scaledModel = glm::scale(scaledModel, glm::vec3(1.03f));
-            scaledModel = glm::translate(scaledModel, -center);
-
-            glm::mat4 mvpScaled = projView * scaledModel;
-            edgeEffectShader_.setMatrices(mvpScaled, view, scaledModel);
+            edgeEffectShader_.setMatrices(instanceMatrices_[i].outlineMvp, view, instanceMatrices_[i].outlineModel);
             streetlight_.draw();
         }
 
@@ -678,18 +756,11 @@ struct App : public OpenGLApplication
         treeTexture_.enableMipmap();
         treeTexture_.setFiltering(GL_NEAREST_MIPMAP_NEAREST);
 
+        buildInstanceMatrices(treeModelMatrices_, tree_.center_, projView);
 
-        for (unsigned int i = 0; i < N_TREES; i++)
+        for (unsigned int i = 0; i < nTrees_; i++)
         {
-            glm::mat4 model(1.0f);
-            float x = treesPosition[i];
-            float z = (i % 2 == 0) ? 3.f : -3.f;
-            model = glm::translate(model, glm::vec3(x, -0.15f, z));
-            model = glm::rotate(model, treesOrientation[i], glm::vec3(0.f, 1.f, 0.f));
-            model = glm::scale(model, glm::vec3(treesScale[i]));
-
-            glm::mat4 mvp = projView * model;
-            celShadingShader_.setMatrices(mvp, view, model);
+            celShadingShader_.setMatrices(instanceMatrices_[i].mvp, view, treeModelMatrices_[i]);
             tree_.draw();
         }
 
@@ -699,23 +770,9 @@ struct App : public OpenGLApplication
 
         edgeEffectShader_.use();
 
-        for (unsigned int i = 0; i < N_TREES; i++)
+        for (unsigned int i = 0; i < nTrees_; i++)
         {
-            glm::mat4 model(1.0f);
-            float x = treesPosition[i];
-            float z = (i % 2 == 0 ? 3.f : -3.f);
-            model = glm::translate(model, glm::vec3(x, -0.15f, z));
-            model = glm::rotate(model, treesOrientation[i], glm::vec3(0.f, 1.f, 0.f));
-            model = glm::scale(model, glm::vec3(treesScale[i]));
-
-            glm::mat4 scaleAroundCenter = glm::translate(glm::mat4(1.0f), tree_.center_);
-            scaleAroundCenter = glm::scale(scaleAroundCenter, glm::vec3(1.03f));
-            scaleAroundCenter = glm::translate(scaleAroundCenter, -tree_.center_);
-
-            glm::mat4 finalModel = model * scaleAroundCenter;
-            glm::mat4 mvpScaled = projView * finalModel;
-
-            edgeEffectShader_.setMatrices(mvpScaled, view, finalModel);
+            edgeEffectShader_.setMatrices(instanceMatrices_[i].outlineMvp, view, instanceMatrices_[i].outlineModel);
             tree_.draw();
         }
 
@@ -755,57 +812,133 @@ struct App : public OpenGLApplication
         grass_.draw();
     }
 
-    void drawGrass()
+    // Les tuiles hors du frustum ou au-delà de GRASS_FADE_DISTANCE ne sont pas soumises;
+    // le niveau de tessellation de chaque tuile suit sa taille à l'écran.
+    void drawGrass(const glm::mat4& proj, const glm::mat4& view)
     {
+        Frustum frustum = Frustum::fromMatrix(proj * view);
+        float halfViewportHeight = 0.5f * static_cast<float>(window_.getSize().y);
+
         grassShader_.use();
+        glUniform3fv(grassShader_.cameraPositionULoc, 1, glm::value_ptr(cameraPosition_));
+        glUniform1f(grassShader_.fadeDistanceULoc, GRASS_FADE_DISTANCE);
+
+        beginGrassStatistics();
 
         glBindVertexArray(grassVAO);
         glPatchParameteri(GL_PATCH_VERTICES, 3);
-        glDrawArrays(GL_PATCHES, 0, grassVertexCount);
+
+        // Élimination en parallèle; les appels OpenGL restent sur ce fil, dans l'ordre des tuiles.
+        grassTileTessLevels_.resize(grassTiles_.size());
+        JobSystem::get().parallelFor(static_cast<uint32_t>(grassTiles_.size()), GRASS_CULL_GRAIN, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const GrassTile& tile = grassTiles_[i];
+                glm::vec3 center = 0.5f * (tile.minCorner + tile.maxCorner);
+                float radius = 0.5f * glm::length(tile.maxCorner - tile.minCorner);
+                float dist = glm::distance(cameraPosition_, center);
+
+                grassTileTessLevels_[i] = -1.0f;
+                if (dist - radius > GRASS_FADE_DISTANCE)
+                    continue;
+                if (!frustum.intersectsBox(tile.minCorner, tile.maxCorner))
+                    continue;
+
+                // Rayon de la sphère englobante projeté, en pixels.
+                float screenRadius = radius * proj[1][1] / std::max(dist, radius) * halfViewportHeight;
+                grassTileTessLevels_[i] = 2.0f * screenRadius / GRASS_PIXELS_PER_TESS_LEVEL;
+            }
+        });
+
+        nGrassTilesDrawn_ = 0;
+        for (size_t i = 0; i < grassTiles_.size(); i++)
+        {
+            if (grassTileTessLevels_[i] < 0.0f)
+                continue;
+
+            glUniform1f(grassShader_.tileTessLevelULoc, grassTileTessLevels_[i]);
+            glDrawArrays(GL_PATCHES, grassTiles_[i].first, grassTiles_[i].count);
+            nGrassTilesDrawn_++;
+        }
+
         glBindVertexArray(0);
+
+        endGrassStatistics();
     }
 
 
     void generateGrassPatches(int gridX, int gridZ, float spacing)
     {
         std::vector<Vertex> vertices;
+        grassTiles_.clear();
 
         float width = gridX * spacing;
         float depth = gridZ * spacing;
         float startX = -width / 2.0f;
         float startZ = -depth / 2.0f;
 
-        for (int x = 0; x < gridX; ++x)
+        // Les cellules sont regroupées par tuile pour que chaque tuile soit une plage contiguë.
+        for (int tileX = 0; tileX < gridX; tileX += GRASS_TILE_CELLS)
         {
-            for (int z = 0; z < gridZ; ++z)
+            for (int tileZ = 0; tileZ < gridZ; tileZ += GRASS_TILE_CELLS)
             {
-                glm::vec3 center(startX + x * spacing, 0.0f, startZ + z * spacing);
-
-                if (center.z > -3.0f && center.z < 2.0f)
+                GrassTile tile;
+                tile.first = static_cast<GLint>(vertices.size());
+                tile.minCorner = glm::vec3(std::numeric_limits<float>::max());
+                tile.maxCorner = glm::vec3(std::numeric_limits<float>::lowest());
+
+                for (int x = tileX; x < std::min(tileX + GRASS_TILE_CELLS, gridX); ++x)
+                {
+                    for (int z = tileZ; z < std::min(tileZ + GRASS_TILE_CELLS, gridZ); ++z)
+                    {
+                        glm::vec3 center(startX + x * spacing, 0.0f, startZ + z * spacing);
+
+                        if (center.z > -3.0f && center.z < 2.0f)
+                            continue;
+
+                        glm::vec3 p0 = center + glm::vec3(0.f, 0.f, 0.f);
+                        glm::vec3 p1 = center + glm::vec3(spacing, 0.f, 0.f);
+                        glm::vec3 p2 = center + glm::vec3(spacing, 0.f, spacing);
+                        glm::vec3 p3 = center + glm::vec3(0.f, 0.f, spacing);
+
+                        vertices.push_back({ p0 });
+                        vertices.push_back({ p1 });
+                        vertices.push_back({ p2 });
+                        vertices.push_back({ p0 });
+                        vertices.push_back({ p2 });
+                        vertices.push_back({ p3 });
+
+                        tile.minCorner = glm::min(tile.minCorner, p0);
+                        tile.maxCorner = glm::max(tile.maxCorner, p2);
+                    }
+                }
+
+                tile.count = static_cast<GLsizei>(vertices.size()) - tile.first;
+                if (tile.count == 0)
                     continue;
 
-                glm::vec3 p0 = center + glm::vec3(0.f, 0.f, 0.f);
-                glm::vec3 p1 = center + glm::vec3(spacing, 0.f, 0.f);
-                glm::vec3 p2 = center + glm::vec3(spacing, 0.f, spacing);
-                glm::vec3 p3 = center + glm::vec3(0.f, 0.f, spacing);
-
-                vertices.push_back({ p0 });
-                vertices.push_back({ p1 });
-                vertices.push_back({ p2 });
-                vertices.push_back({ p0 });
-                vertices.push_back({ p2 });
-                vertices.push_back({ p3 });
+                // Les brins dépassent de la tuile en hauteur et, inclinés, sur les côtés.
+                glm::vec3 margin(GRASS_MAX_BLADE_HEIGHT, 0.f, GRASS_MAX_BLADE_HEIGHT);
+                tile.minCorner -= margin;
+                tile.maxCorner += margin + glm::vec3(0.f, GRASS_MAX_BLADE_HEIGHT, 0.f);
+                grassTiles_.push_back(tile);
             }
         }
 
         grassVertexCount = static_cast<int>(vertices.size());
 
+        // Régénéré quand la densité change.
+        glDeleteVertexArrays(1, &grassVAO);
+        glDeleteBuffers(1, &grassVBO);
         glGenVertexArrays(1, &grassVAO);
         glGenBuffers(1, &grassVBO);
 
         glBindVertexArray(grassVAO);
         glBindBuffer(GL_ARRAY_BUFFER, grassVBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        GLDebug::label(GL_VERTEX_ARRAY, grassVAO, "Grass Patches");
+        GLDebug::label(GL_BUFFER, grassVBO, "Grass Patches");
 
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -814,6 +947,123 @@ struct App : public OpenGLApplication
         glBindVertexArray(0);
     }
 
+    bool isExtensionSupported(const char* name)
+    {
+        GLint nExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nExtensions);
+        for (GLint i = 0; i < nExtensions; i++)
+        {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // Requêtes de statistiques du pipeline autour de la passe de gazon tessellé.
+    // Les résultats sont lus GRASS_QUERY_LATENCY trames plus tard pour ne pas bloquer.
+    void initGrassStatistics()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        isPipelineStatisticsSupported_ = (major > 4 || (major == 4 && minor >= 6))
+            || isExtensionSupported("GL_ARB_pipeline_statistics_query");
+
+        if (isPipelineStatisticsSupported_)
+            glGenQueries(2 * GRASS_QUERY_LATENCY, &grassQueries_[0][0]);
+    }
+
+    void beginGrassStatistics()
+    {
+        if (!isPipelineStatisticsSupported_)
+            return;
+
+        unsigned int slot = frame_ % GRASS_QUERY_LATENCY;
+        if (isGrassQueryPending_[slot])
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(grassQueries_[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                glGetQueryObjectui64v(grassQueries_[slot][0], GL_QUERY_RESULT, &grassTcsPatches_);
+                glGetQueryObjectui64v(grassQueries_[slot][1], GL_QUERY_RESULT, &grassTesInvocations_);
+            }
+            isGrassQueryPending_[slot] = false;
+        }
+
+        glBeginQuery(GL_TESS_CONTROL_SHADER_PATCHES, grassQueries_[slot][0]);
+        glBeginQuery(GL_TESS_EVALUATION_SHADER_INVOCATIONS, grassQueries_[slot][1]);
+    }
+
+    void endGrassStatistics()
+    {
+        if (!isPipelineStatisticsSupported_)
+            return;
+
+        glEndQuery(GL_TESS_CONTROL_SHADER_PATCHES);
+        glEndQuery(GL_TESS_EVALUATION_SHADER_INVOCATIONS);
+        isGrassQueryPending_[frame_ % GRASS_QUERY_LATENCY] = true;
+    }
+
+    void initGrassBlades()
+    {
+        grassBlades_.allocate(nullptr, maxGrassBlades_ * sizeof(GrassBlade), GL_DYNAMIC_COPY);
+        grassBlades_.setLabel("Grass Blades");
+
+        DrawArraysIndirectCommand command = { GRASS_BLADE_VERTEX_COUNT, 0, 0, 0 };
+        grassDrawCommand_.allocate(&command, sizeof(command), GL_DYNAMIC_DRAW);
+        grassDrawCommand_.setLabel("Grass Draw Command");
+
+        // Aucun attribut: grassBlade.vs.glsl lit les brins dans grassBlades_.
+        glGenVertexArrays(1, &grassBladeVAO_);
+    }
+
+    // Remplit grassBlades_ et le nombre d'instances de grassDrawCommand_ sur le GPU.
+    void generateGrassBlades(const glm::mat4& projView)
+    {
+        DrawArraysIndirectCommand command = { GRASS_BLADE_VERTEX_COUNT, 0, 0, 0 };
+        grassDrawCommand_.updateData(&command, 0, sizeof(command));
+
+        Frustum frustum = Frustum::fromMatrix(projView);
+        float width = grassGridX_ * grassCellSize_;
+        float depth = grassGridZ_ * grassCellSize_;
+
+        grassGenerateShader_.use();
+        glUniform2i(grassGenerateShader_.gridSizeULoc, grassGridX_, grassGridZ_);
+        glUniform2f(grassGenerateShader_.gridStartULoc, -width / 2.0f, -depth / 2.0f);
+        glUniform1f(grassGenerateShader_.cellSizeULoc, grassCellSize_);
+        glUniform1ui(grassGenerateShader_.maxBladesULoc, maxGrassBlades_);
+        glUniform3fv(grassGenerateShader_.cameraPositionULoc, 1, glm::value_ptr(cameraPosition_));
+        glUniform4fv(grassGenerateShader_.frustumPlanesULoc, 6, glm::value_ptr(frustum.planes[0]));
+
+        grassBlades_.setBindingIndex(0);
+        grassDrawCommand_.setBindingIndex(1);
+
+        const GLuint nCells = grassGridX_ * grassGridZ_;
+        glDispatchCompute((nCells + 63) / 64, 1, 1);
+
+        glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    void drawGrassBlades(const glm::mat4& projView)
+    {
+        grassBladeShader_.use();
+        glUniformMatrix4fv(grassBladeShader_.mvpULoc, 1, GL_FALSE, glm::value_ptr(projView));
+
+        // Les brins sont visibles des deux côtés.
+        glDisable(GL_CULL_FACE);
+
+        glBindVertexArray(grassBladeVAO_);
+        grassBlades_.setBindingIndex(0);
+        grassDrawCommand_.bindAsDrawIndirect();
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, nullptr);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindVertexArray(0);
+
+        glEnable(GL_CULL_FACE);
+    }
+
 
     void drawCar(glm::mat4& projView, glm::mat4& view)
     { 
@@ -823,7 +1073,6 @@ struct App : public OpenGLApplication
         carTexture_.enableMipmap();
         carTexture_.setFiltering(GL_NEAREST_MIPMAP_NEAREST);
 
-        car_.update(deltaTime_);
         car_.draw(projView, view);
         }
 
@@ -847,13 +1096,8 @@ struct App : public OpenGLApplication
 
         glBindVertexArray(bezierVAO_);
 
-        GLsizei vertsPerCurve = bezierNPoints + 1;
-
-        for (unsigned int i = 0; i < nPoints; ++i)
-        {
-            GLsizei start = i * vertsPerCurve;
-            glDrawArrays(GL_LINE_STRIP, start, vertsPerCurve);
-        }
+        // Une bande par courbe, toutes en un seul appel.
+        glMultiDrawArrays(GL_LINE_STRIP, bezierFirsts_.data(), bezierCounts_.data(), static_cast<GLsizei>(bezierCounts_.size()));
 
         glBindVertexArray(0);
     }
@@ -861,53 +1105,111 @@ struct App : public OpenGLApplication
 
 
 
-    vec3 casteljauPoints(const BezierCurve& c, float t) {
-        vec3 q01 = mix(c.p0, c.c0, t);
-        vec3 q12 = mix(c.c0, c.c1, t);
-        vec3 q23 = mix(c.c1, c.p1, t);
+    // Nombre de segments pour que la corde s'écarte de la courbe d'au plus
+    // tolerance (formule de Wang pour une cubique).
+    unsigned int computeBezierSegmentCount(const BezierCurve& c, float tolerance)
+    {
+        const unsigned int MAX_SEGMENTS = 256;
 
-        vec3 q012 = mix(q01, q12, t);
-        vec3 q123 = mix(q12, q23, t);
+        float m = glm::max(glm::length(c.p0 - 2.0f * c.c0 + c.c1), glm::length(c.c0 - 2.0f * c.c1 + c.p1));
+        float n = glm::ceil(glm::sqrt(0.75f * m / tolerance));
+        return static_cast<unsigned int>(glm::clamp(n, 1.0f, static_cast<float>(MAX_SEGMENTS)));
+    }
 
-        vec3 qf = mix(q012, q123, t);
+    // Tolérance en unités du monde qui correspond à tolerancePixels pour la
+    // partie de la courbe la plus proche de la caméra.
+    float computeBezierWorldTolerance(const BezierCurve& c, const glm::mat4& proj, const glm::vec3& eye, float tolerancePixels)
+    {
+        glm::vec3 minCorner = glm::min(glm::min(c.p0, c.c0), glm::min(c.c1, c.p1));
+        glm::vec3 maxCorner = glm::max(glm::max(c.p0, c.c0), glm::max(c.c1, c.p1));
+        float distance = glm::length(eye - glm::clamp(eye, minCorner, maxCorner));
 
-        return qf;
+        // Taille d'un pixel à cette distance; 0.1 est le plan proche.
+        float pixelSize = 2.0f * glm::max(distance, 0.1f) / (proj[1][1] * static_cast<float>(window_.getSize().y));
+        return tolerancePixels * pixelSize;
     }
 
-    void buildAndUploadBezierMesh()
+    // Évalue nSegments + 1 points par différences avant: 3 additions de
+    // vec3 par point au lieu des 6 interpolations de de Casteljau.
+    void appendBezierPoints(const BezierCurve& c, unsigned int nSegments, std::pmr::vector<glm::vec3>& verts)
     {
-        std::vector<glm::vec3> verts;
-        verts.reserve((bezierNPoints +1) * nPoints + bezierNPoints);
+        glm::vec3 a = -c.p0 + 3.0f * c.c0 - 3.0f * c.c1 + c.p1;
+        glm::vec3 b = 3.0f * c.p0 - 6.0f * c.c0 + 3.0f * c.c1;
+        glm::vec3 d = -3.0f * c.p0 + 3.0f * c.c0;
+
+        float h = 1.0f / static_cast<float>(nSegments);
+        glm::vec3 point = c.p0;
+        glm::vec3 delta1 = a * (h * h * h) + b * (h * h) + d * h;
+        glm::vec3 delta2 = a * (6.0f * h * h * h) + b * (2.0f * h * h);
+        glm::vec3 delta3 = a * (6.0f * h * h * h);
+
+        verts.push_back(point);
+        for (unsigned int s = 1; s < nSegments; ++s)
+        {
+            point += delta1;
+            delta1 += delta2;
+            delta2 += delta3;
+            verts.push_back(point);
+        }
+        // Le dernier point est exact pour que les courbes restent jointes.
+        verts.push_back(c.p1);
+    }
+
+    // Recalcule le nombre de segments de chaque courbe et ne reconstruit le
+    // tampon que si l'un d'eux a changé. Les tableaux temporaires viennent de
+    // l'arène de la trame.
+    void updateBezierMesh(const glm::mat4& proj, const glm::mat4& view)
+    {
+        glm::vec3 eye = glm::vec3(glm::inverse(view)[3]);
 
+        std::pmr::vector<GLsizei> counts(nPoints, &getFrameArena());
         for (unsigned int ic = 0; ic < nPoints; ++ic)
         {
-            const BezierCurve& c = curves[ic];
-            for (unsigned int s = 0; s <= bezierNPoints; ++s)
-            {
-                float t = (float)s / (float)bezierNPoints;
-                glm::vec3 p = casteljauPoints(c, t);
-                verts.push_back(p);
-            }
+            unsigned int nSegments = glm::max(bezierNPoints, 1u);
+            if (isBezierAdaptive_)
+                nSegments = computeBezierSegmentCount(curves[ic], computeBezierWorldTolerance(curves[ic], proj, eye, bezierTolerancePixels_));
+            counts[ic] = static_cast<GLsizei>(nSegments + 1);
         }
 
+        if (std::equal(counts.begin(), counts.end(), bezierCounts_.begin(), bezierCounts_.end()))
+            return;
+
+        std::pmr::vector<glm::vec3> verts(&getFrameArena());
+        bezierFirsts_.resize(nPoints);
+        for (unsigned int ic = 0; ic < nPoints; ++ic)
+        {
+            bezierFirsts_[ic] = static_cast<GLint>(verts.size());
+            appendBezierPoints(curves[ic], counts[ic] - 1, verts);
+        }
+        bezierCounts_.assign(counts.begin(), counts.end());
         bezierVertexCount = verts.size();
 
         if (bezierVAO_ == 0)
         {
             glGenVertexArrays(1, &bezierVAO_);
             glGenBuffers(1, &bezierVBO_);
+
+            glBindVertexArray(bezierVAO_);
+            glBindBuffer(GL_ARRAY_BUFFER, bezierVBO_);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+            glBindVertexArray(0);
+            GLDebug::label(GL_VERTEX_ARRAY, bezierVAO_, "Bezier");
+            GLDebug::label(GL_BUFFER, bezierVBO_, "Bezier");
         }
 
-        glBindVertexArray(bezierVAO_);
+        // Le tampon ne fait que grandir; sinon seule la partie utilisée est remplacée.
         glBindBuffer(GL_ARRAY_BUFFER, bezierVBO_);
-
-        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(glm::vec3), verts.data(), GL_DYNAMIC_DRAW);
-
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
-
+        if (verts.size() > bezierVertexCapacity_)
+        {
+            bezierVertexCapacity_ = verts.size();
+            glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(glm::vec3), verts.data(), GL_DYNAMIC_DRAW);
+        }
+        else
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, verts.size() * sizeof(glm::vec3), verts.data());
+        }
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
     }
 
 
@@ -935,12 +1237,37 @@ struct App : public OpenGLApplication
     void setLightingUniform()
     {
         celShadingShader_.use();
-        glUniform1i(celShadingShader_.nSpotLightsULoc, N_STREETLIGHTS + 4);
+        glUniform1i(celShadingShader_.nSpotLightsULoc, nLitStreetlights_ + 4);
 
         float ambientIntensity = 0.05;
         glUniform3f(celShadingShader_.globalAmbientULoc, ambientIntensity, ambientIntensity, ambientIntensity);
     }
 
+    // Projecteurs des lampadaires allumés, suivis des quatre feux de l'auto.
+    void initSpotLights()
+    {
+        for (unsigned int i = 0; i < nLitStreetlights_; i++)
+        {
+            lightsData_.spotLights[i].position = glm::vec4(streetlightLightPositions[i], 0.0f);
+            lightsData_.spotLights[i].direction = glm::vec3(0, -1, 0);
+            lightsData_.spotLights[i].exponent = 6.0f;
+            lightsData_.spotLights[i].openingAngle = 60.f;
+        }
+
+        // Initialisation des paramètres de lumière des phares. Positions et directions: updateCarLight().
+        lightsData_.spotLights[nLitStreetlights_].exponent = 4.0f;
+        lightsData_.spotLights[nLitStreetlights_].openingAngle = 30.f;
+
+        lightsData_.spotLights[nLitStreetlights_ + 1].exponent = 4.0f;
+        lightsData_.spotLights[nLitStreetlights_ + 1].openingAngle = 30.f;
+
+        lightsData_.spotLights[nLitStreetlights_ + 2].exponent = 4.0f;
+        lightsData_.spotLights[nLitStreetlights_ + 2].openingAngle = 60.f;
+
+        lightsData_.spotLights[nLitStreetlights_ + 3].exponent = 4.0f;
+        lightsData_.spotLights[nLitStreetlights_ + 3].openingAngle = 60.f;
+    }
+
     void toggleSun()
     {
         if (isDay_)
@@ -961,7 +1288,7 @@ struct App : public OpenGLApplication
     {
         if (isDay_)
         {
-            for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+            for (unsigned int i = 0; i < nLitStreetlights_; i++)
             {
                 lightsData_.spotLights[i].ambient = glm::vec4(glm::vec3(0.0f), 0.0f);
                 lightsData_.spotLights[i].diffuse = glm::vec4(glm::vec3(0.0f), 0.0f);
@@ -970,7 +1297,7 @@ struct App : public OpenGLApplication
         }
         else
         {
-            for (unsigned int i = 0; i < N_STREETLIGHTS; i++)
+            for (unsigned int i = 0; i < nLitStreetlights_; i++)
             {
                 lightsData_.spotLights[i].ambient = glm::vec4(glm::vec3(0.02f), 0.0f);
                 lightsData_.spotLights[i].diffuse = glm::vec4(glm::vec3(0.8f), 0.0f);
@@ -983,56 +1310,59 @@ struct App : public OpenGLApplication
     {
         if (car_.isHeadlightOn)
         {
-            lightsData_.spotLights[N_STREETLIGHTS].ambient = glm::vec4(glm::vec3(0.01), 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS].diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS].specular = glm::vec4(glm::vec3(0.4), 0.0f);
+            lightsData_.spotLights[nLitStreetlights_].ambient = glm::vec4(glm::vec3(0.01), 0.0f);
+            lightsData_.spotLights[nLitStreetlights_].diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
+            lightsData_.spotLights[nLitStreetlights_].specular = glm::vec4(glm::vec3(0.4), 0.0f);
 
-            lightsData_.spotLights[N_STREETLIGHTS + 1].ambient = glm::vec4(glm::vec3(0.01), 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 1].diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 1].specular = glm::vec4(glm::vec3(0.4), 0.0f);
-
-            lightsData_.spotLights[N_STREETLIGHTS].position = glm::vec4(-1.6, 0.64, -0.45, 1.0f);
-            lightsData_.spotLights[N_STREETLIGHTS].direction = glm::vec3(-10, -1, 0);
-
-            lightsData_.spotLights[N_STREETLIGHTS + 1].position = glm::vec4(-1.6, 0.64, 0.45, 1.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 1].direction = glm::vec3(-10, -1, 0);
+            lightsData_.spotLights[nLitStreetlights_ + 1].ambient = glm::vec4(glm::vec3(0.01), 0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 1].diffuse = glm::vec4(glm::vec3(1.0), 0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 1].specular = glm::vec4(glm::vec3(0.4), 0.0f);
         }
         else
         {
-            lightsData_.spotLights[N_STREETLIGHTS].ambient = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS].diffuse = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS].specular = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_].ambient = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_].diffuse = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_].specular = glm::vec4(0.0f);
 
-            lightsData_.spotLights[N_STREETLIGHTS + 1].ambient = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 1].diffuse = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 1].specular = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 1].ambient = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 1].diffuse = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 1].specular = glm::vec4(0.0f);
         }
 
         if (car_.isBraking)
         {
-            lightsData_.spotLights[N_STREETLIGHTS + 2].ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 2].diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 2].specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
-
-            lightsData_.spotLights[N_STREETLIGHTS + 3].ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 3].diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 3].specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
-
-            lightsData_.spotLights[N_STREETLIGHTS + 2].position = glm::vec4(1.6, 0.64, -0.45, 1.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 2].direction = glm::vec3(10, -1, 0);
+            lightsData_.spotLights[nLitStreetlights_ + 2].ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 2].diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 2].specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
 
-            lightsData_.spotLights[N_STREETLIGHTS + 3].position = glm::vec4(1.6, 0.64, 0.45, 1.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 3].direction = glm::vec3(10, -1, 0);
+            lightsData_.spotLights[nLitStreetlights_ + 3].ambient = glm::vec4(0.01, 0.0, 0.0, 0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 3].diffuse = glm::vec4(0.9, 0.1, 0.1, 0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 3].specular = glm::vec4(0.35, 0.05, 0.05, 0.0f);
         }
         else
         {
-            lightsData_.spotLights[N_STREETLIGHTS + 2].ambient = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 2].diffuse = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 2].specular = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 2].ambient = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 2].diffuse = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 2].specular = glm::vec4(0.0f);
 
-            lightsData_.spotLights[N_STREETLIGHTS + 3].ambient = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 3].diffuse = glm::vec4(0.0f);
-            lightsData_.spotLights[N_STREETLIGHTS + 3].specular = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 3].ambient = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 3].diffuse = glm::vec4(0.0f);
+            lightsData_.spotLights[nLitStreetlights_ + 3].specular = glm::vec4(0.0f);
+        }
+
+        // Phares puis feux arrière, donnés dans le repère de l'auto: phong.fs.glsl attend des coordonnées du monde.
+        static const glm::vec3 CAR_LIGHT_POSITIONS[4] = {
+            glm::vec3(-1.6f, 0.64f, -0.45f), glm::vec3(-1.6f, 0.64f, 0.45f),
+            glm::vec3(1.6f, 0.64f, -0.45f), glm::vec3(1.6f, 0.64f, 0.45f)
+        };
+        static const glm::vec3 CAR_LIGHT_DIRECTIONS[4] = {
+            glm::vec3(-10, -1, 0), glm::vec3(-10, -1, 0), glm::vec3(10, -1, 0), glm::vec3(10, -1, 0)
+        };
+        glm::mat3 carRotation(car_.carModel);
+        for (int i = 0; i < 4; i++)
+        {
+            lightsData_.spotLights[nLitStreetlights_ + i].position = car_.carModel * glm::vec4(CAR_LIGHT_POSITIONS[i], 1.0f);
+            lightsData_.spotLights[nLitStreetlights_ + i].direction = carRotation * CAR_LIGHT_DIRECTIONS[i];
         }
     }
 
@@ -1043,163 +1373,303 @@ struct App : public OpenGLApplication
 
     void initParticles()
     {
-        {
-            Particle* zeroParticles = new Particle[MAX_PARTICLES_]();
-            particles_[0].allocate(zeroParticles, MAX_PARTICLES_ * sizeof(Particle), GL_DYNAMIC_COPY);
-            delete[] zeroParticles;
-
-            particles_[1].allocate(nullptr, MAX_PARTICLES_ * sizeof(Particle), GL_DYNAMIC_COPY);
-        }
-
-        glGenVertexArrays(1, &vaoParticles_);
-        glBindVertexArray(vaoParticles_);
-
-        glEnableVertexAttribArray(0); // position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Particle),
-            (void*)offsetof(Particle, position));
-
-        glEnableVertexAttribArray(1); // zOrientation
-        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Particle),
-            (void*)offsetof(Particle, zOrientation));
-
-        glEnableVertexAttribArray(2); // color
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(Particle),
-            (void*)offsetof(Particle, color));
-
-        glEnableVertexAttribArray(3); // size
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Particle),
-            (void*)offsetof(Particle, size));
-
-        glBindVertexArray(0);
+        particles_.init(PARTICLE_CAPACITY);
 
         particlesTexture_.load("../textures/smoke.png");
         particlesTexture_.use();
         particlesTexture_.setFiltering(GL_LINEAR);
         particlesTexture_.setWrap(GL_CLAMP_TO_EDGE);
-
-        glEnable(GL_PROGRAM_POINT_SIZE);
+        particles_.setAtlas(particlesTexture_.getID(), 1, 1);
+
+        // Échappement de l'auto; la transformation suit l'instantané de la simulation à chaque pas.
+        ParticleEmitter exhaust;
+        exhaust.velocity = glm::vec3(0.3f, 0.2f, 0.0f);
+        exhaust.spawnRate = 5.0f;
+        exhaust.lifetime = glm::vec2(1.5f, 2.0f);
+        exhaust.colorStart = glm::vec4(1.0f, 1.0f, 1.0f, 0.2f);
+        exhaust.colorEnd = glm::vec4(0.5f, 0.5f, 0.5f, 0.2f);
+        exhaust.sizeStart = glm::vec2(0.5f);
+        exhaust.sizeEnd = glm::vec2(0.2f);
+        exhaustEmitter_ = particles_.addEmitter(exhaust);
+
+        // Fumée au-dessus de la tête de chaque lampadaire.
+        ParticleEmitter smoke;
+        smoke.velocity = glm::vec3(0.0f, 0.4f, 0.0f);
+        smoke.velocitySpread = 0.05f;
+        smoke.spawnRate = 3.0f;
+        smoke.lifetime = glm::vec2(2.0f, 3.0f);
+        smoke.colorStart = glm::vec4(0.6f, 0.6f, 0.6f, 0.15f);
+        smoke.colorEnd = glm::vec4(0.4f, 0.4f, 0.4f, 0.0f);
+        smoke.sizeStart = glm::vec2(0.3f);
+        smoke.sizeEnd = glm::vec2(0.8f);
+        streetlightSmoke_ = smoke;
+        updateStreetlightSmokeEmitters();
     }
 
-
-    void updateParticleCounters()
+    // ParticleSystem ne retire pas d'émetteurs: ceux des lampadaires en trop sont désactivés dans updateParticles().
+    // Une fois la table d'émetteurs pleine, les lampadaires suivants n'ont pas de fumée.
+    void updateStreetlightSmokeEmitters()
     {
-        totalTime += deltaTime_;
-        timerParticles_ += deltaTime_;
-
-        const float spawnInterval = 0.2f;
-        unsigned int particlesToAdd = timerParticles_ / spawnInterval;
-        timerParticles_ -= particlesToAdd * spawnInterval;
+        while (streetlightSmokeEmitters_.size() < nStreetlights_)
+        {
+            GLuint emitter = particles_.addEmitter(streetlightSmoke_);
+            if (emitter == ParticleSystem::INVALID_EMITTER)
+                break;
+            streetlightSmokeEmitters_.push_back(emitter);
+        }
+        for (unsigned int i = 0; i < nStreetlights_ && i < streetlightSmokeEmitters_.size(); i++)
+            particles_.getEmitter(streetlightSmokeEmitters_[i]).transform = glm::translate(streetlightModelMatrices_[i], glm::vec3(-2.77f, 5.4f, 0.0f));
+    }
 
-        nParticles_ += particlesToAdd;
-        if (nParticles_ > MAX_PARTICLES_)
-            nParticles_ = MAX_PARTICLES_;
+    // Code de sortie du processus: non nul si --particle-check a échoué.
+    int getExitCode() const
+    {
+        return exitCode_;
     }
 
-    void updateParticles(glm::vec3 exhaustPos, glm::vec3 exhaustDir, const glm::mat4& carModel)
+    // Un pas d'émission sur les deux chemins, depuis le même état vide et au
+    // même temps (la graine du hachage). Les indices dépilés doivent être les
+    // mêmes; l'ordre des invocations n'étant pas fixé sur le GPU, les
+    // particules sont comparées une fois triées par durée de vie. Plusieurs
+    // émetteurs, dont un sans particule, pour vérifier la recherche d'émetteur.
+    bool checkParticleEmission()
     {
-        particlesUpdateShader_.use();
+        const GLuint CAPACITY = 1024;
+        const float TIME = 1.25f;
+        const float DELTA_TIME = 1.0f / 60.0f;
+        const float TOLERANCE = 1e-3f;
+        const GLuint SPAWN_COUNTS[] = { 100, 0, 150 };
+
+        ParticleSimulator simulator;
+        simulator.init(CAPACITY);
+        ParticleSystem gpuParticles;
+        gpuParticles.init(CAPACITY);
+
+        for (int i = 0; i < 3; i++)
+        {
+            ParticleEmitter emitter;
+            emitter.transform = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(10.0f * i, 1.0f, -5.0f * i)),
+                0.5f * i, glm::vec3(0.0f, 1.0f, 0.0f));
+            emitter.velocity = glm::vec3(0.3f, 0.2f * (i + 1), 0.0f);
+            emitter.velocitySpread = 0.5f;
+            emitter.lifetime = glm::vec2(0.5f + i, 3.0f + i);
+            emitter.spawnRate = SPAWN_COUNTS[i] / DELTA_TIME;
+            emitter.isEnabled = SPAWN_COUNTS[i] > 0;
+            simulator.addEmitter(emitter);
+            gpuParticles.addEmitter(emitter);
+        }
+        gpuParticles.uploadState(simulator);
 
-        glm::vec3 worldPos = glm::vec3(carModel * glm::vec4(exhaustPos, 1.0f));
-        glm::vec3 worldDir = glm::vec3(carModel * glm::vec4(exhaustDir, 0.0f));
+        simulator.update(TIME, DELTA_TIME);
+        gpuParticles.update(TIME, DELTA_TIME);
 
-        glUniform1f(particlesUpdateShader_.timeULoc, totalTime);
-        glUniform1f(particlesUpdateShader_.deltaTimeULoc, deltaTime_);
-        glUniform3fv(particlesUpdateShader_.emitterPosULoc, 1, glm::value_ptr(worldPos));
-        glUniform3fv(particlesUpdateShader_.emitterDirULoc, 1, glm::value_ptr(worldDir));
+        std::vector<glm::vec4> positionTtl;
+        GLuint gpuAliveCount = 0;
+        gpuParticles.downloadState(positionTtl, gpuAliveCount);
 
-        particles_[0].setBindingIndex(0);
-        particles_[1].setBindingIndex(1);
+        const ParticleArrays& particles = simulator.getParticles();
+        std::vector<glm::vec4> cpuSpawned;
+        std::vector<glm::vec4> gpuSpawned;
+        GLuint nIdMismatches = 0;
+        for (GLuint i = 0; i < CAPACITY; i++)
+        {
+            bool isCpuAlive = particles.timeToLive[i] > 0.0f;
+            bool isGpuAlive = positionTtl[i].w > 0.0f;
+            if (isCpuAlive != isGpuAlive)
+                nIdMismatches++;
+            if (isCpuAlive)
+                cpuSpawned.emplace_back(particles.positionX[i], particles.positionY[i], particles.positionZ[i], particles.timeToLive[i]);
+            if (isGpuAlive)
+                gpuSpawned.push_back(positionTtl[i]);
+        }
 
-        glDispatchCompute(MAX_PARTICLES_, 1, 1);
+        auto byTimeToLive = [](const glm::vec4& a, const glm::vec4& b) { return a.w < b.w; };
+        std::sort(cpuSpawned.begin(), cpuSpawned.end(), byTimeToLive);
+        std::sort(gpuSpawned.begin(), gpuSpawned.end(), byTimeToLive);
 
-        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        GLuint nMismatches = 0;
+        float maxError = 0.0f;
+        for (size_t i = 0; i < std::min(cpuSpawned.size(), gpuSpawned.size()); i++)
+        {
+            glm::vec4 difference = glm::abs(gpuSpawned[i] - cpuSpawned[i]);
+            float error = glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w));
+            maxError = glm::max(maxError, error);
+            if (error > TOLERANCE)
+                nMismatches++;
+        }
 
-        std::swap(particles_[0], particles_[1]);
+        bool isConsistent = nIdMismatches == 0 && nMismatches == 0
+            && cpuSpawned.size() == gpuSpawned.size() && gpuAliveCount == simulator.getAliveCount();
+        std::cout << "Particle emission check: " << cpuSpawned.size() << " spawned on CPU, " << gpuSpawned.size()
+            << " on GPU, " << nIdMismatches << " different indices, " << nMismatches << " mismatches, max error "
+            << maxError << " -> " << (isConsistent ? "PASS" : "FAIL") << std::endl;
+        return isConsistent;
     }
 
-
-    void drawParticles()
+    // Compare ParticleSimulator au chemin GPU: l'émission d'abord, puis les
+    // pas d'intégration depuis le même état de départ, en comparant les
+    // particules vivantes relues (--particle-check).
+    bool checkParticleSimulator()
     {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glDepthMask(GL_FALSE);
-
-        particlesShader_.use();
-        glBindVertexArray(vaoParticles_);
-        particlesTexture_.use();
-
-        glm::mat4 V = getViewMatrix();
-        glm::mat4 P = getPerspectiveProjectionMatrix();
-        glm::vec3 cameraRight = glm::normalize(glm::vec3(V[0][0], V[1][0], V[2][0]));
-        glm::vec3 cameraUp = glm::normalize(glm::vec3(V[0][1], V[1][1], V[2][1]));
+        bool isEmissionConsistent = checkParticleEmission();
+
+        const GLuint CAPACITY = 4096;
+        const int N_STEPS = 120;
+        const float DELTA_TIME = 1.0f / 60.0f;
+        const float TOLERANCE = 1e-3f;
+
+        ParticleSimulator simulator;
+        simulator.init(CAPACITY);
+
+        // Vies variées pour que des particules meurent pendant la comparaison.
+        ParticleEmitter emitter;
+        emitter.velocity = glm::vec3(0.3f, 0.2f, 0.0f);
+        emitter.velocitySpread = 0.5f;
+        emitter.lifetime = glm::vec2(0.5f, 3.0f);
+        emitter.spawnRate = CAPACITY / 2 / DELTA_TIME;
+        GLuint emitterIndex = simulator.addEmitter(emitter);
+        simulator.update(0.0f, DELTA_TIME);
+        simulator.getEmitter(emitterIndex).isEnabled = false;
+
+        ParticleSystem gpuParticles;
+        gpuParticles.init(CAPACITY);
+        gpuParticles.uploadState(simulator);
+
+        for (int step = 1; step <= N_STEPS; step++)
+        {
+            simulator.update(step * DELTA_TIME, DELTA_TIME);
+            gpuParticles.update(step * DELTA_TIME, DELTA_TIME);
+        }
 
-        glUniformMatrix4fv(particlesShader_.viewULoc, 1, GL_FALSE, glm::value_ptr(V));
-        glUniform3fv(particlesShader_.cameraRightULoc, 1, glm::value_ptr(cameraRight));
-        glUniform3fv(particlesShader_.cameraUpULoc, 1, glm::value_ptr(cameraUp));
+        std::vector<glm::vec4> positionTtl;
+        GLuint gpuAliveCount = 0;
+        gpuParticles.downloadState(positionTtl, gpuAliveCount);
 
+        const ParticleArrays& particles = simulator.getParticles();
+        GLuint nMismatches = 0;
+        float maxError = 0.0f;
+        for (GLuint i = 0; i < CAPACITY; i++)
+        {
+            if (particles.timeToLive[i] <= 0.0f)
+                continue;
+
+            glm::vec4 expected(particles.positionX[i], particles.positionY[i], particles.positionZ[i], particles.timeToLive[i]);
+            glm::vec4 difference = glm::abs(positionTtl[i] - expected);
+            float error = glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w));
+            maxError = glm::max(maxError, error);
+            if (error > TOLERANCE)
+                nMismatches++;
+        }
 
-        glUniformMatrix4fv(particlesShader_.modelViewULoc, 1, GL_FALSE, glm::value_ptr(V));
-        glUniformMatrix4fv(particlesShader_.projectionULoc, 1, GL_FALSE, glm::value_ptr(P));
+        bool isConsistent = nMismatches == 0 && gpuAliveCount == simulator.getAliveCount();
+        std::cout << "Particle check (" << ParticleSimulator::getKernelName() << "): "
+            << simulator.getAliveCount() << " alive on CPU, " << gpuAliveCount << " on GPU, "
+            << nMismatches << " mismatches, max error " << maxError << " -> "
+            << (isConsistent ? "PASS" : "FAIL") << std::endl;
+        return isEmissionConsistent && isConsistent;
+    }
 
-        particles_[0].setBindingIndex(0);
-        glBindVertexArray(vaoParticles_);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particles_[0].getID());
-        glDrawArrays(GL_POINTS, 0, nParticles_);
+    void updateParticles(float deltaTime)
+    {
+        const glm::vec3 EXHAUST_POSITION = glm::vec3(2.0f, 0.24f, -0.43f);
 
+        particles_.getEmitter(exhaustEmitter_).transform = glm::translate(snapshots_.getReadBuffer().car.getTransform(), EXHAUST_POSITION);
+        for (unsigned int i = 0; i < streetlightSmokeEmitters_.size(); i++)
+            particles_.getEmitter(streetlightSmokeEmitters_[i]).isEnabled = isStreetlightSmokeEnabled_ && i < nStreetlights_;
 
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
+        totalTime += deltaTime;
+        particles_.update(totalTime, deltaTime);
     }
 
 
     void sceneMain()
     {
+        snapshots_.acquire();
+        const SceneSnapshot& snapshot = snapshots_.getReadBuffer();
+        car_.setState(snapshot.car);
+
         ImGui::Begin("Scene Parameters");
-        ImGui::SliderInt("Bezier Number Of Points", (int*)&bezierNPoints, 0, 16);
+        ImGui::Checkbox("Adaptive Bezier", &isBezierAdaptive_);
+        if (isBezierAdaptive_)
+            ImGui::SliderFloat("Bezier Tolerance", &bezierTolerancePixels_, 0.1f, 10.0f, "%.1f px", ImGuiSliderFlags_Logarithmic);
+        else
+            ImGui::SliderInt("Bezier Number Of Points", (int*)&bezierNPoints, 1, 16);
         if (ImGui::Button("Animate Camera"))
         {
+            if (!isAnimatingCamera)
+                resetCameraPosition = cameraPosition_;
             isAnimatingCamera = true;
             cameraMode = 1;
+            cameraRailDistance_ = 0.f;
         }
+        ImGui::SliderFloat("Camera Rail Speed", &cameraRailSpeed_, 0.5f, 50.0f, "%.1f m/s");
+        ImGui::Checkbox("Camera Follows Rail", &isCameraFollowingRail_);
 
         if (ImGui::Button("Toggle Day/Night"))
         {
             isDay_ = !isDay_;
             toggleSun();
             toggleStreetlight();
-            lights_.updateData(&lightsData_, 0, sizeof(DirectionalLight) + N_STREETLIGHTS * sizeof(SpotLight));
+            lights_.updateData(&lightsData_, 0, sizeof(DirectionalLight) + nLitStreetlights_ * sizeof(SpotLight));
         }
-        ImGui::SliderFloat("Car Speed", &car_.speed, -10.0f, 10.0f, "%.2f m/s");
-        ImGui::SliderFloat("Steering Angle", &car_.steeringAngle, -30.0f, 30.0f, "%.2f°");
+        // Les commandes partent de l'état affiché et ne sont envoyées à simulate() que si elles changent.
+        CarControls controls = car_.getControls();
+        bool areControlsChanged = false;
+        areControlsChanged |= ImGui::SliderFloat("Car Speed", &controls.speed, -10.0f, 10.0f, "%.2f m/s");
+        areControlsChanged |= ImGui::SliderFloat("Steering Angle", &controls.steeringAngle, -30.0f, 30.0f, "%.2f°");
         if (ImGui::Button("Reset Steering"))
-            car_.steeringAngle = 0.f;
-        ImGui::Checkbox("Headlight", &car_.isHeadlightOn);
-        ImGui::Checkbox("Left Blinker", &car_.isLeftBlinkerActivated);
-        ImGui::Checkbox("Right Blinker", &car_.isRightBlinkerActivated);
-        ImGui::Checkbox("Brake", &car_.isBraking);
+        {
+            controls.steeringAngle = 0.f;
+            areControlsChanged = true;
+        }
+        areControlsChanged |= ImGui::Checkbox("Headlight", &controls.isHeadlightOn);
+        areControlsChanged |= ImGui::Checkbox("Left Blinker", &controls.isLeftBlinkerActivated);
+        areControlsChanged |= ImGui::Checkbox("Right Blinker", &controls.isRightBlinkerActivated);
+        areControlsChanged |= ImGui::Checkbox("Brake", &controls.isBraking);
+        if (areControlsChanged)
+        {
+            car_.setControls(controls);
+            carControls_.getWriteBuffer() = controls;
+            carControls_.publish();
+        }
+        ImGui::Checkbox("GPU Grass", &isGpuGrassEnabled_);
+        ImGui::Checkbox("Particles Geometry Shader", &particles_.isGeometryShaderEnabled);
+        ImGui::Checkbox("Streetlight Smoke", &isStreetlightSmokeEnabled_);
+        ImGui::Checkbox("Sort Particles", &particles_.isSortEnabled);
+        ImGui::SameLine();
+        if (ImGui::Button("Benchmark Sort"))
+            particles_.benchmarkSort(getViewMatrix());
+        ImGui::SliderFloat("Exhaust Spawn Rate", &particles_.getEmitter(exhaustEmitter_).spawnRate, 0.0f, 1000000.0f, "%.0f /s", ImGuiSliderFlags_Logarithmic);
+        ImGui::InputInt("Particle Capacity", &requestedParticleCapacity_);
+        if (ImGui::Button("Apply Capacity") && requestedParticleCapacity_ > 0)
+            particles_.setCapacity(static_cast<GLuint>(requestedParticleCapacity_));
+        if (!isGpuGrassEnabled_)
+        {
+            ImGui::Text("Grass tiles drawn: %u / %u", nGrassTilesDrawn_, static_cast<unsigned int>(grassTiles_.size()));
+            if (isPipelineStatisticsSupported_)
+            {
+                ImGui::Text("TCS patches: %llu", static_cast<unsigned long long>(grassTcsPatches_));
+                ImGui::Text("TES invocations: %llu", static_cast<unsigned long long>(grassTesInvocations_));
+            }
+        }
         ImGui::End();
 
 
         if (isAnimatingCamera)
         {
-            if (cameraAnimation == 0.f)
+            if (cameraRailDistance_ < cameraRail_.getLength())
             {
-                vec3 resetCameraPosition = cameraPosition_;
-            }
-            if (cameraAnimation < nPoints)
-            {
-                unsigned int animationIndex = (unsigned int)floor(cameraAnimation);
-                float localT = cameraAnimation - animationIndex;
+                // Vitesse constante: on avance d'une distance et non d'un paramètre t.
+                CameraRailFrame frame = cameraRail_.getFrame(cameraRailDistance_);
+                cameraPosition_ = frame.position;
+                glm::vec3 direction = isCameraFollowingRail_ ? frame.tangent : car_.position - cameraPosition_;
 
-                cameraPosition_ = casteljauPoints(curves[animationIndex], localT);
-                glm::vec3 directionToCar = car_.position - cameraPosition_;
+                cameraOrientation_.y = M_PI + atan2(direction.x, direction.z);
 
-                cameraOrientation_.y = M_PI + atan2(directionToCar.x, directionToCar.z);
+                float horizontalDistance = sqrt(direction.x * direction.x + direction.z * direction.z);
+                cameraOrientation_.x = atan2(direction.y, horizontalDistance);
 
-                float horizontalDistance = sqrt(directionToCar.x * directionToCar.x + directionToCar.z * directionToCar.z);
-                cameraOrientation_.x = atan2(directionToCar.y, horizontalDistance);
-
-                cameraAnimation += deltaTime_ / 3.0;
+                cameraRailDistance_ += cameraRailSpeed_ * deltaTime_;
             }
             else
             {
@@ -1211,16 +1681,29 @@ struct App : public OpenGLApplication
                 float horizontalDistance = sqrt(diff.x * diff.x + diff.z * diff.z);
                 cameraOrientation_.x = atan2(diff.y, horizontalDistance);
 
-                cameraAnimation = 0.f;
+                cameraRailDistance_ = 0.f;
                 isAnimatingCamera = false;
                 cameraMode = 0;
             }
         }
-        updateCameraInput();
-        car_.update(deltaTime_);
+        if (isBenchmarking())
+        {
+            // Trajet scripté du banc d'essai: le rail parcouru une fois pendant la mesure, regard vers l'avant.
+            CameraRailFrame frame = cameraRail_.getFrame(getBenchmarkProgress() * cameraRail_.getLength());
+            cameraPosition_ = frame.position;
+            cameraOrientation_.y = M_PI + atan2(frame.tangent.x, frame.tangent.z);
+
+            float horizontalDistance = sqrt(frame.tangent.x * frame.tangent.x + frame.tangent.z * frame.tangent.z);
+            cameraOrientation_.x = atan2(frame.tangent.y, horizontalDistance);
+        }
+        else
+        {
+            updateCameraInput();
+        }
+        car_.interpolate(getInterpolationAlpha(snapshot.publishTime));
 
         updateCarLight();
-        lights_.updateData(&lightsData_.spotLights[N_STREETLIGHTS], sizeof(DirectionalLight) + N_STREETLIGHTS * sizeof(SpotLight), 4 * sizeof(SpotLight));
+        lights_.updateData(&lightsData_.spotLights[nLitStreetlights_], sizeof(DirectionalLight) + nLitStreetlights_ * sizeof(SpotLight), 4 * sizeof(SpotLight));
 
         glm::mat4 view = getViewMatrix();
         glm::mat4 proj = getPerspectiveProjectionMatrix();
@@ -1228,47 +1711,63 @@ struct App : public OpenGLApplication
 
         setMaterial(windowMat);
 
-        setMaterial(grassMat);
-        drawTrees(projView);
+        {
+            PROFILE_SCOPE("Trees");
+            setMaterial(grassMat);
+            drawTrees(projView);
+        }
 
-        drawGround(projView);
+        {
+            PROFILE_SCOPE("Ground");
+            drawGround(projView);
+        }
 
-        setMaterial(streetlightMat);
-        drawStreetlights(projView);
+        {
+            PROFILE_SCOPE("Streetlights");
+            setMaterial(streetlightMat);
+            drawStreetlights(projView);
+        }
 
         CHECK_GL_ERROR;
-        setMaterial(defaultMat);
-        drawCar(projView, view);
+        {
+            PROFILE_SCOPE("Car");
+            setMaterial(defaultMat);
+            drawCar(projView, view);
+        }
         CHECK_GL_ERROR;
 
-        bool hasNumberOfSidesChanged = bezierNPoints != oldBezierNPoints;
-        if (hasNumberOfSidesChanged)
         {
-            oldBezierNPoints = bezierNPoints;
-            buildAndUploadBezierMesh();
-        }
+            PROFILE_SCOPE("Bezier");
+            updateBezierMesh(proj, view);
 
-        setMaterial(bezierMat);
-        glDrawBezierLine(projView, view);
+            setMaterial(bezierMat);
+            glDrawBezierLine(projView, view);
+        }
         CHECK_GL_ERROR;
 
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 mvp = proj * view * model;
+        if (isGpuGrassEnabled_)
+        {
+            PROFILE_SCOPE("Grass");
+            generateGrassBlades(projView);
+            drawGrassBlades(projView);
+        }
+        else
+        {
+            PROFILE_SCOPE("Grass");
+            glm::mat4 model = glm::mat4(1.0f);
+            glm::mat4 mvp = proj * view * model;
 
-        grassShader_.use();
-        grassShader_.setMatrices(mvp, model);
-        grassShader_.setModelView(view * model);
-        drawGrass();
+            grassShader_.use();
+            grassShader_.setMatrices(mvp, model);
+            drawGrass(proj, view);
+        }
 
         // Particles
-        vec3 exhaustPos = vec3(2.0f, 0.24f, -0.43f);
-        vec3 exhaustDir = vec3(1.0f, 0.0f, 0.0f);
-        CHECK_GL_ERROR;
-        updateParticleCounters();
         CHECK_GL_ERROR;
-        updateParticles(exhaustPos, exhaustDir, car_.carModel);
-        CHECK_GL_ERROR;
-        drawParticles();
+        {
+            PROFILE_SCOPE("Particles Draw");
+            particles_.draw(view, proj);
+        }
         CHECK_GL_ERROR;
     }
 
@@ -1280,8 +1779,8 @@ private:
     Sky skyShader_;
     BasicShader bezierShader_;
     GrassShader grassShader_;
-    ParticlesShader particlesShader_;
-    ParticlesUpdateShader particlesUpdateShader_;
+    GrassGenerateShader grassGenerateShader_;
+    GrassBladeShader grassBladeShader_;
 
     // Textures
     Texture2D grassTexture_;
@@ -1299,17 +1798,17 @@ private:
     UniformBuffer material_;
     UniformBuffer lights_;
 
-    GLuint vaoParticles_;
     GLuint ssboRead, ssboWrite;
 
     float totalTime;
-    float timerParticles_;
 
-    static const unsigned int MAX_PARTICLES_ = 64;
-    unsigned int nParticles_;
+    static constexpr GLuint PARTICLE_CAPACITY = 1 << 16;
+    int requestedParticleCapacity_ = PARTICLE_CAPACITY;
+    bool isStreetlightSmokeEnabled_ = true;
 
-    // Ssbo
-    ShaderStorageBuffer particles_[2];
+    ParticleSystem particles_;
+    GLuint exhaustEmitter_ = 0;
+    ParticleEmitter streetlightSmoke_;
 
     struct {
         DirectionalLight dirLight;
@@ -1330,25 +1829,108 @@ private:
     GLuint vbo_, ebo_, vao_;
     GLuint bezierVAO_, bezierVBO_;
     size_t bezierVertexCount;
+    size_t bezierVertexCapacity_ = 0;
+    std::vector<GLint> bezierFirsts_;
+    std::vector<GLsizei> bezierCounts_;
+    bool isBezierAdaptive_ = true;
+    float bezierTolerancePixels_ = 0.5f;
+
+    // 3 s par courbe à vitesse constante, comme l'ancienne animation en t.
+    static constexpr float CAMERA_SECONDS_PER_CURVE = 3.0f;
+    CameraRail cameraRail_;
+    float cameraRailDistance_ = 0.f;
+    float cameraRailSpeed_ = 1.f;
+    bool isCameraFollowingRail_ = false;
     GLuint grassVAO = 0;
     GLuint grassVBO = 0;
     int grassVertexCount = 0;
 
+    static constexpr int DEFAULT_GRASS_GRID_X = 110;
+    static constexpr int DEFAULT_GRASS_GRID_Z = 55;
+    static constexpr float DEFAULT_GRASS_CELL_SIZE = 0.9f;
+    static constexpr GLuint GRASS_BLADE_VERTEX_COUNT = 7;
+    static constexpr GLuint DEFAULT_MAX_GRASS_BLADES = 1 << 18;
+    // Même étendue, plus ou moins de cellules selon la densité (setGrassDensity()).
+    int grassGridX_ = DEFAULT_GRASS_GRID_X;
+    int grassGridZ_ = DEFAULT_GRASS_GRID_Z;
+    float grassCellSize_ = DEFAULT_GRASS_CELL_SIZE;
+    GLuint maxGrassBlades_ = DEFAULT_MAX_GRASS_BLADES;
+
+    ShaderStorageBuffer grassBlades_;
+    ShaderStorageBuffer grassDrawCommand_;
+    GLuint grassBladeVAO_ = 0;
+    bool isGpuGrassEnabled_ = true;
+
+    static constexpr int GRASS_TILE_CELLS = 10;
+    static constexpr float GRASS_FADE_DISTANCE = 60.f;
+    static constexpr float GRASS_MAX_BLADE_HEIGHT = 0.8f;
+    static constexpr float GRASS_PIXELS_PER_TESS_LEVEL = 32.f;
+    // Tuiles par tâche d'élimination: assez pour amortir le coût d'une tâche.
+    static constexpr uint32_t GRASS_CULL_GRAIN = 64;
+    static constexpr uint32_t INSTANCE_MATRIX_GRAIN = 128;
+    static constexpr unsigned int GRASS_QUERY_LATENCY = 3;
+
+    struct GrassTile
+    {
+        GLint first;
+        GLsizei count;
+        glm::vec3 minCorner;
+        glm::vec3 maxCorner;
+    };
+    std::vector<GrassTile> grassTiles_;
+    // Niveau de tessellation de chaque tuile pour la trame courante, négatif si elle est éliminée.
+    std::vector<float> grassTileTessLevels_;
+    unsigned int nGrassTilesDrawn_ = 0;
+
+    bool isPipelineStatisticsSupported_ = false;
+    GLuint grassQueries_[GRASS_QUERY_LATENCY][2] = {};
+    bool isGrassQueryPending_[GRASS_QUERY_LATENCY] = {};
+    GLuint64 grassTcsPatches_ = 0;
+    GLuint64 grassTesInvocations_ = 0;
+
+    // Ce que le rendu lit de la simulation. Copié en entier à chaque pas: il ne contient que des valeurs.
+    struct SceneSnapshot
+    {
+        CarState car;
+        double publishTime = 0.0;
+    };
+
     Car car_;
+    CarState simulatedCar_; // Propriété de simulate().
+    TripleBuffer<SceneSnapshot> snapshots_;
+    TripleBuffer<CarControls> carControls_;
 
     glm::vec3 cameraPosition_;
     glm::vec2 cameraOrientation_;
 
-    static constexpr unsigned int N_TREES = 12;
-    static constexpr unsigned int N_STREETLIGHTS = 5;
-    glm::mat4 treeModelMatrices_[N_TREES];
-    glm::mat4 streetlightModelMatrices_[N_STREETLIGHTS];
-    glm::vec3 streetlightLightPositions[N_STREETLIGHTS];
+    static constexpr unsigned int DEFAULT_N_TREES = 12;
+    static constexpr unsigned int DEFAULT_N_STREETLIGHTS = 5;
+    // phong.fs.glsl a MAX_SPOT_LIGHTS (16) projecteurs, dont les 4 feux de l'auto: les autres lampadaires restent éteints.
+    static constexpr unsigned int MAX_LIT_STREETLIGHTS = 16 - 4;
+    static constexpr float ROADSIDE_ROW_SPACING = 2.5f;
+    unsigned int nTrees_ = DEFAULT_N_TREES;
+    unsigned int nStreetlights_ = DEFAULT_N_STREETLIGHTS;
+    unsigned int nLitStreetlights_ = DEFAULT_N_STREETLIGHTS;
+    std::vector<glm::mat4> streetlightModelMatrices_;
+    std::vector<glm::vec3> streetlightLightPositions;
+    std::vector<GLuint> streetlightSmokeEmitters_;
+
+    int exitCode_ = 0;
 
     std::vector<float> lightsPosition;
     std::vector<float> treesPosition;
     std::vector<float> treesOrientation;
     std::vector<float> treesScale;
+    std::vector<glm::mat4> treeModelMatrices_;
+
+    struct InstanceMatrices
+    {
+        glm::mat4 mvp;
+        glm::mat4 outlineModel;
+        glm::mat4 outlineMvp;
+    };
+    // Réutilisé par les lampadaires puis les arbres, sans réallocation une fois la taille atteinte.
+    std::vector<InstanceMatrices> instanceMatrices_;
 
     // Imgui var
     const char* const SCENE_NAMES[1] = {
@@ -1360,22 +1942,27 @@ private:
     bool isMouseMotionEnabled_;
     bool isQWERTY_;
 
-    // Ne pas modifier
-    struct Particle
+    // Même disposition que Blade dans grassGenerate.cs.glsl.
+    struct GrassBlade
     {
-        glm::vec3 position;
-        GLfloat zOrientation;
-        glm::vec4 velocity; // vec3, but padded
-        glm::vec4 color;
-        glm::vec2 size;
-        GLfloat timeToLive;
-        GLfloat maxTimeToLive;
+        glm::vec4 positionHeight;
+        glm::vec4 shape;
     };
 };
 
 
 int main(int argc, char* argv[])
 {
+    // Sans fenêtre ni contexte OpenGL.
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--particle-benchmark") == 0)
+        {
+            benchmarkParticleSimulator();
+            return 0;
+        }
+    }
+
     WindowSettings settings = {};
     settings.fps = 60;
     settings.context.depthBits = 24;
@@ -1386,4 +1973,5 @@ int main(int argc, char* argv[])
     settings.context.attributeFlags = sf::ContextSettings::Attribute::Core;
     App app;
     app.run(argc, argv, "Tp2", settings);
+    return app.getExitCode();
 }
@@ -4,6 +4,9 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include <inf2705/gl_debug.hpp>
+#include <inf2705/job_system.hpp>
+
 using namespace gl;
 
 struct PVertex {
@@ -12,40 +15,34 @@ struct PVertex {
 };
 
 
-struct PositionAttribute
-{
-    float x, y, z;
-};
-
-struct ColorUCharAttribute
-{
-    unsigned char r, g, b;
-};
-
-struct NormalAttribute
-{
-    float x, y, z;
-};
-
-struct TexCoordAttribute
-{
-    float s, t;
-};
-
-struct VertexModel
-{
-    PositionAttribute pos;
-    ColorUCharAttribute color;
-    NormalAttribute normal;
-    TexCoordAttribute texCoord;
-};
-
 const GLuint VERTEX_POSITION_INDEX = 0;
 const GLuint VERTEX_COLOR_INDEX = 1;
 const GLuint VERTEX_NORMAL_INDEX = 2;
 const GLuint VERTEX_TEXCOORDS_INDEX = 3;
 
 void Model::load(const char* path)
+{
+    upload(decode(path));
+    setLabel(path);
+}
+
+void Model::loadAll(Model* const* models, const char* const* paths, size_t count)
+{
+    std::vector<MeshData> meshes(count);
+    JobSystem::get().parallelFor(static_cast<uint32_t>(count), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+            meshes[i] = decode(paths[i]);
+    });
+
+    for (size_t i = 0; i < count; i++)
+    {
+        models[i]->upload(meshes[i]);
+        models[i]->setLabel(paths[i]);
+    }
+}
+
+MeshData Model::decode(const char* path)
 {
     happly::PLYData plyIn(path);
 
@@ -91,7 +88,13 @@ void Model::load(const char* path)
 
     std::vector<std::vector<unsigned int>> facesIndices = plyIn.getFaceIndices<unsigned int>();
 
-    std::vector<VertexModel> vPos(positionX.size());
+    MeshData mesh;
+    mesh.hasColor = !colorRed.empty();
+    mesh.hasNormal = !normalX.empty();
+    mesh.hasTexCoords = !texCoordsX.empty();
+
+    std::vector<VertexModel>& vPos = mesh.vertices;
+    vPos.resize(positionX.size());
     for (size_t i = 0; i < vPos.size(); i++)
     {
         vPos[i] = { 0 };
@@ -121,7 +124,8 @@ void Model::load(const char* path)
         }
     }
 
-    std::vector<unsigned int> elementsData(facesIndices.size() * 3);
+    std::vector<unsigned int>& elementsData = mesh.elements;
+    elementsData.resize(facesIndices.size() * 3);
     for (size_t i = 0; i < facesIndices.size(); i++)
     {
         for (size_t j = 0; j < facesIndices[i].size(); j++)
@@ -130,13 +134,33 @@ void Model::load(const char* path)
         }
     }
 
+    glm::vec3 minPos(FLT_MAX);
+    glm::vec3 maxPos(-FLT_MAX);
+
+    for (size_t i = 0; i < positionX.size(); i++)
+    {
+        minPos.x = std::min(minPos.x, positionX[i]);
+        minPos.y = std::min(minPos.y, positionY[i]);
+        minPos.z = std::min(minPos.z, positionZ[i]);
+
+        maxPos.x = std::max(maxPos.x, positionX[i]);
+        maxPos.y = std::max(maxPos.y, positionY[i]);
+        maxPos.z = std::max(maxPos.z, positionZ[i]);
+    }
+
+    mesh.center = (minPos + maxPos) * 0.5f;
+    return mesh;
+}
+
+void Model::upload(const MeshData& mesh)
+{
     glGenBuffers(1, &vbo_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, vPos.size() * sizeof(VertexModel), &vPos[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(VertexModel), mesh.vertices.data(), GL_STATIC_DRAW);
 
     glGenBuffers(1, &ebo_);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elementsData.size() * sizeof(unsigned int), &elementsData[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.elements.size() * sizeof(unsigned int), mesh.elements.data(), GL_STATIC_DRAW);
 
     glGenVertexArrays(1, &vao_);
     glBindVertexArray(vao_);
@@ -147,7 +171,7 @@ void Model::load(const char* path)
     glEnableVertexAttribArray(VERTEX_POSITION_INDEX);
     glVertexAttribPointer(VERTEX_POSITION_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, pos)));
 
-    if (!colorRed.empty())
+    if (mesh.hasColor)
     {
         glEnableVertexAttribArray(VERTEX_COLOR_INDEX);
         glVertexAttribPointer(VERTEX_COLOR_INDEX, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, color)));
@@ -155,7 +179,7 @@ void Model::load(const char* path)
     else
         glDisableVertexAttribArray(VERTEX_COLOR_INDEX);
 
-    if (!normalX.empty())
+    if (mesh.hasNormal)
     {
         glEnableVertexAttribArray(VERTEX_NORMAL_INDEX);
         glVertexAttribPointer(VERTEX_NORMAL_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, normal)));
@@ -163,7 +187,7 @@ void Model::load(const char* path)
     else
         glDisableVertexAttribArray(VERTEX_NORMAL_INDEX);
 
-    if (!texCoordsX.empty())
+    if (mesh.hasTexCoords)
     {
         glEnableVertexAttribArray(VERTEX_TEXCOORDS_INDEX);
         glVertexAttribPointer(VERTEX_TEXCOORDS_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(VertexModel), (GLvoid*)(offsetof(VertexModel, texCoord)));
@@ -173,23 +197,8 @@ void Model::load(const char* path)
 
     glBindVertexArray(0);
 
-    count_ = elementsData.size();
-
-    glm::vec3 minPos(FLT_MAX);
-    glm::vec3 maxPos(-FLT_MAX);
-
-    for (size_t i = 0; i < positionX.size(); i++)
-    {
-        minPos.x = std::min(minPos.x, positionX[i]);
-        minPos.y = std::min(minPos.y, positionY[i]);
-        minPos.z = std::min(minPos.z, positionZ[i]);
-
-        maxPos.x = std::max(maxPos.x, positionX[i]);
-        maxPos.y = std::max(maxPos.y, positionY[i]);
-        maxPos.z = std::max(maxPos.z, positionZ[i]);
-    }
-
-    center_ = (minPos + maxPos) * 0.5f;
+    count_ = mesh.elements.size();
+    center_ = mesh.center;
 }
 
 void Model::load(float* vertices, size_t verticesSize, unsigned int* elements, size_t elementsSize)
@@ -222,6 +231,12 @@ void Model::load(float* vertices, size_t verticesSize, unsigned int* elements, s
     count_ = elementsSize / sizeof(unsigned int);
 }
 
+void Model::setLabel(const char* label)
+{
+    GLDebug::label(GL_VERTEX_ARRAY, vao_, label);
+    GLDebug::label(GL_BUFFER, vbo_, label);
+    GLDebug::label(GL_BUFFER, ebo_, label);
+}
 
 Model::~Model()
 {
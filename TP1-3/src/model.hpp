@@ -1,15 +1,64 @@
 #pragma once
 
+#include <vector>
+
 #include <glbinding/gl/gl.h>
 #include <glm/glm.hpp>
 
 using namespace gl;
 
+struct PositionAttribute
+{
+    float x, y, z;
+};
+
+struct ColorUCharAttribute
+{
+    unsigned char r, g, b;
+};
+
+struct NormalAttribute
+{
+    float x, y, z;
+};
+
+struct TexCoordAttribute
+{
+    float s, t;
+};
+
+struct VertexModel
+{
+    PositionAttribute pos;
+    ColorUCharAttribute color;
+    NormalAttribute normal;
+    TexCoordAttribute texCoord;
+};
+
+// Contenu d'un fichier PLY prêt à téléverser.
+struct MeshData
+{
+    std::vector<VertexModel> vertices;
+    std::vector<unsigned int> elements;
+    bool hasColor = false;
+    bool hasNormal = false;
+    bool hasTexCoords = false;
+    glm::vec3 center = glm::vec3(0.0f);
+};
+
 class Model
 {
 public:
     void load(const char* path);   
+    // Décode les fichiers en parallèle (JobSystem), puis téléverse dans l'ordre sur le fil appelant.
+    static void loadAll(Model* const* models, const char* const* paths, size_t count);
+
+    // Aucun appel OpenGL: peut être appelée depuis n'importe quel fil.
+    static MeshData decode(const char* path);
+    void upload(const MeshData& mesh);
     void load(float* vertices, size_t verticesSize, unsigned int* elements, size_t elementsSize);
+    // Nom du VAO et des tampons dans les outils de débogage. load(path) utilise le chemin.
+    void setLabel(const char* label);
 
     
     ~Model();
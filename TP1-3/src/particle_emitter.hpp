@@ -0,0 +1,27 @@
+#ifndef PARTICLE_EMITTER_H
+#define PARTICLE_EMITTER_H
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+using namespace gl;
+
+// Description d'un émetteur. La position d'émission est l'origine de
+// transform et la vitesse est exprimée dans son repère. La couleur et la
+// taille sont interpolées linéairement entre Start et End sur la vie.
+struct ParticleEmitter
+{
+    glm::mat4 transform = glm::mat4(1.0f);
+    glm::vec3 velocity = glm::vec3(0.0f);
+    float velocitySpread = 0.0f;      // perturbation aléatoire, repère monde
+    float spawnRate = 0.0f;           // particules par seconde
+    glm::vec2 lifetime = glm::vec2(1.0f); // min, max en secondes
+    glm::vec4 colorStart = glm::vec4(1.0f);
+    glm::vec4 colorEnd = glm::vec4(1.0f);
+    glm::vec2 sizeStart = glm::vec2(0.5f);
+    glm::vec2 sizeEnd = glm::vec2(0.5f);
+    GLuint atlasSlot = 0;
+    bool isEnabled = true;
+};
+
+#endif // PARTICLE_EMITTER_H
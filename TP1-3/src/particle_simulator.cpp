@@ -0,0 +1,375 @@
+#include "particle_simulator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include <glm/gtc/packing.hpp>
+
+#include <inf2705/job_system.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLE_SIMULATOR_SSE2
+#endif
+
+namespace
+{
+    // Même hachage entier que particlesEmit.cs.glsl: mêmes valeurs bit à bit.
+    uint32_t hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15;
+        x *= 0x846CA68Bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    float rand01(float time, float seed, GLuint invocation)
+    {
+        uint32_t h = hash(std::bit_cast<uint32_t>(time) ^ hash(invocation * 4u + static_cast<uint32_t>(seed)));
+        return static_cast<float>(h >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float roundToHalf(float value)
+    {
+        return glm::unpackHalf1x16(glm::packHalf1x16(value));
+    }
+
+    struct IntegrateSpan
+    {
+        float* positionX;
+        float* positionY;
+        float* positionZ;
+        float* timeToLive;
+        const float* velocityX;
+        const float* velocityY;
+        const float* velocityZ;
+    };
+
+    // Ajoute à died les indices dont les bits sont à 1 dans mask.
+    void appendDied(int mask, GLuint base, std::vector<GLuint>& died)
+    {
+        unsigned int bits = static_cast<unsigned int>(mask);
+        while (bits != 0)
+        {
+            died.push_back(base + std::countr_zero(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    // Comme particlesUpdate.cs.glsl: une particule qui meurt garde sa
+    // position; seule timeToLive est écrite pour la marquer morte.
+    void integrateRange(const IntegrateSpan& s, GLuint begin, GLuint end, float deltaTime, std::vector<GLuint>& died)
+    {
+        GLuint i = begin;
+
+#if defined(__AVX2__)
+        const __m256 dt = _mm256_set1_ps(deltaTime);
+        const __m256 zero = _mm256_setzero_ps();
+        for (; i + 8 <= end; i += 8)
+        {
+            __m256 ttl = _mm256_loadu_ps(s.timeToLive + i);
+            __m256 alive = _mm256_cmp_ps(ttl, zero, _CMP_GT_OQ);
+            if (_mm256_movemask_ps(alive) == 0)
+                continue;
+
+            __m256 next = _mm256_sub_ps(ttl, dt);
+            __m256 survives = _mm256_and_ps(alive, _mm256_cmp_ps(next, zero, _CMP_GT_OQ));
+
+            __m256 x = _mm256_loadu_ps(s.positionX + i);
+            __m256 y = _mm256_loadu_ps(s.positionY + i);
+            __m256 z = _mm256_loadu_ps(s.positionZ + i);
+            x = _mm256_blendv_ps(x, _mm256_add_ps(x, _mm256_mul_ps(_mm256_loadu_ps(s.velocityX + i), dt)), survives);
+            y = _mm256_blendv_ps(y, _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(s.velocityY + i), dt)), survives);
+            z = _mm256_blendv_ps(z, _mm256_add_ps(z, _mm256_mul_ps(_mm256_loadu_ps(s.velocityZ + i), dt)), survives);
+            _mm256_storeu_ps(s.positionX + i, x);
+            _mm256_storeu_ps(s.positionY + i, y);
+            _mm256_storeu_ps(s.positionZ + i, z);
+            _mm256_storeu_ps(s.timeToLive + i, _mm256_blendv_ps(ttl, next, alive));
+
+            appendDied(_mm256_movemask_ps(_mm256_andnot_ps(survives, alive)), i, died);
+        }
+#elif defined(PARTICLE_SIMULATOR_SSE2)
+        // SSE2 seulement: le mélange se fait avec and/andnot/or.
+        const __m128 dt = _mm_set1_ps(deltaTime);
+        const __m128 zero = _mm_setzero_ps();
+        auto select = [](__m128 a, __m128 b, __m128 mask) { return _mm_or_ps(_mm_andnot_ps(mask, a), _mm_and_ps(mask, b)); };
+        for (; i + 4 <= end; i += 4)
+        {
+            __m128 ttl = _mm_loadu_ps(s.timeToLive + i);
+            __m128 alive = _mm_cmpgt_ps(ttl, zero);
+            if (_mm_movemask_ps(alive) == 0)
+                continue;
+
+            __m128 next = _mm_sub_ps(ttl, dt);
+            __m128 survives = _mm_and_ps(alive, _mm_cmpgt_ps(next, zero));
+
+            __m128 x = _mm_loadu_ps(s.positionX + i);
+            __m128 y = _mm_loadu_ps(s.positionY + i);
+            __m128 z = _mm_loadu_ps(s.positionZ + i);
+            x = select(x, _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(s.velocityX + i), dt)), survives);
+            y = select(y, _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(s.velocityY + i), dt)), survives);
+            z = select(z, _mm_add_ps(z, _mm_mul_ps(_mm_loadu_ps(s.velocityZ + i), dt)), survives);
+            _mm_storeu_ps(s.positionX + i, x);
+            _mm_storeu_ps(s.positionY + i, y);
+            _mm_storeu_ps(s.positionZ + i, z);
+            _mm_storeu_ps(s.timeToLive + i, select(ttl, next, alive));
+
+            appendDied(_mm_movemask_ps(_mm_andnot_ps(survives, alive)), i, died);
+        }
+#endif
+
+        for (; i < end; i++)
+        {
+            float ttl = s.timeToLive[i];
+            if (ttl <= 0.0f)
+                continue;
+
+            float next = ttl - deltaTime;
+            s.timeToLive[i] = next;
+            if (next <= 0.0f)
+            {
+                died.push_back(i);
+                continue;
+            }
+
+            s.positionX[i] += s.velocityX[i] * deltaTime;
+            s.positionY[i] += s.velocityY[i] * deltaTime;
+            s.positionZ[i] += s.velocityZ[i] * deltaTime;
+        }
+    }
+}
+
+void ParticleSimulator::init(GLuint capacity, unsigned int nThreads)
+{
+    capacity_ = capacity;
+    nThreads_ = nThreads != 0 ? nThreads : std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (std::vector<float>* array : { &particles_.positionX, &particles_.positionY, &particles_.positionZ,
+        &particles_.timeToLive, &particles_.velocityX, &particles_.velocityY, &particles_.velocityZ,
+        &particles_.zOrientation, &particles_.maxTimeToLive })
+        array->assign(capacity_, 0.0f);
+    particles_.emitterIndex.assign(capacity_, 0);
+    particles_.color.assign(capacity_, glm::vec4(0.0f));
+    particles_.size.assign(capacity_, glm::vec2(0.0f));
+
+    // Même ordre initial que ParticleSystem: l'indice 0 est dépilé en premier.
+    deadList_.resize(capacity_);
+    for (GLuint i = 0; i < capacity_; i++)
+        deadList_[i] = capacity_ - 1 - i;
+
+    diedPerThread_.assign(nThreads_, {});
+    std::fill(spawnAccumulators_.begin(), spawnAccumulators_.end(), 0.0f);
+}
+
+GLuint ParticleSimulator::addEmitter(const ParticleEmitter& emitter)
+{
+    emitters_.push_back(emitter);
+    spawnAccumulators_.push_back(0.0f);
+    return static_cast<GLuint>(emitters_.size() - 1);
+}
+
+ParticleEmitter& ParticleSimulator::getEmitter(GLuint index)
+{
+    return emitters_[index];
+}
+
+const std::vector<ParticleEmitter>& ParticleSimulator::getEmitters() const
+{
+    return emitters_;
+}
+
+void ParticleSimulator::update(float time, float deltaTime)
+{
+    emit(time, deltaTime);
+    integrate(deltaTime);
+}
+
+// Même budget que ParticleSystem::uploadEmitters et même calcul que
+// particlesEmit.cs.glsl, invocation par invocation.
+void ParticleSimulator::emit(float time, float deltaTime)
+{
+    GLuint invocation = 0;
+
+    for (size_t e = 0; e < emitters_.size(); e++)
+    {
+        const ParticleEmitter& emitter = emitters_[e];
+
+        GLuint spawnCount = 0;
+        if (emitter.isEnabled)
+        {
+            spawnAccumulators_[e] += deltaTime * emitter.spawnRate;
+            spawnCount = static_cast<GLuint>(spawnAccumulators_[e]);
+            spawnAccumulators_[e] -= spawnCount;
+        }
+        spawnCount = std::min(spawnCount, capacity_ - invocation);
+
+        glm::mat3 rotation = glm::mat3(emitter.transform);
+        glm::vec3 origin = glm::vec3(emitter.transform[3]);
+
+        for (GLuint n = 0; n < spawnCount; n++, invocation++)
+        {
+            if (deadList_.empty())
+                return;
+            GLuint id = deadList_.back();
+            deadList_.pop_back();
+
+            float r = rand01(time, 0.0f, invocation);
+            glm::vec3 jitter = glm::vec3(rand01(time, 1.0f, invocation), rand01(time, 2.0f, invocation), rand01(time, 3.0f, invocation)) * 2.0f - 1.0f;
+            glm::vec3 velocity = rotation * emitter.velocity + jitter * emitter.velocitySpread;
+            float maxTimeToLive = glm::mix(emitter.lifetime.x, emitter.lifetime.y, r);
+
+            particles_.positionX[id] = origin.x;
+            particles_.positionY[id] = origin.y;
+            particles_.positionZ[id] = origin.z;
+            particles_.timeToLive[id] = maxTimeToLive;
+            particles_.velocityX[id] = roundToHalf(velocity.x);
+            particles_.velocityY[id] = roundToHalf(velocity.y);
+            particles_.velocityZ[id] = roundToHalf(velocity.z);
+            particles_.zOrientation[id] = roundToHalf(r * 6.2831853f);
+            particles_.maxTimeToLive[id] = roundToHalf(maxTimeToLive);
+            particles_.emitterIndex[id] = static_cast<GLuint>(e);
+        }
+    }
+}
+
+void ParticleSimulator::integrate(float deltaTime)
+{
+    IntegrateSpan span = {
+        particles_.positionX.data(), particles_.positionY.data(), particles_.positionZ.data(),
+        particles_.timeToLive.data(),
+        particles_.velocityX.data(), particles_.velocityY.data(), particles_.velocityZ.data()
+    };
+
+    forEachChunk([&](GLuint begin, GLuint end, unsigned int thread)
+    {
+        diedPerThread_[thread].clear();
+        integrateRange(span, begin, end, deltaTime, diedPerThread_[thread]);
+    });
+
+    // Ordre déterministe: tranche par tranche.
+    for (const std::vector<GLuint>& died : diedPerThread_)
+        deadList_.insert(deadList_.end(), died.begin(), died.end());
+}
+
+void ParticleSimulator::computeAppearance()
+{
+    forEachChunk([&](GLuint begin, GLuint end, unsigned int)
+    {
+        for (GLuint i = begin; i < end; i++)
+        {
+            if (particles_.timeToLive[i] <= 0.0f)
+            {
+                particles_.color[i] = glm::vec4(0.0f);
+                particles_.size[i] = glm::vec2(0.0f);
+                continue;
+            }
+
+            const ParticleEmitter& emitter = emitters_[particles_.emitterIndex[i]];
+            float life01 = 1.0f - particles_.timeToLive[i] / particles_.maxTimeToLive[i];
+            particles_.color[i] = glm::mix(emitter.colorStart, emitter.colorEnd, life01);
+            particles_.size[i] = glm::mix(emitter.sizeStart, emitter.sizeEnd, life01);
+        }
+    });
+}
+
+// Tranches multiples de 8 pour que seule la dernière ait un reste scalaire.
+// Une tâche du JobSystem par tranche: plus de création de fils à chaque pas.
+template<typename Function>
+void ParticleSimulator::forEachChunk(Function function)
+{
+    GLuint chunkSize = ((capacity_ + nThreads_ - 1) / nThreads_ + 7) & ~7u;
+
+    JobSystem::get().parallelFor(nThreads_, 1, [&](uint32_t first, uint32_t last)
+    {
+        for (unsigned int t = first; t < last; t++)
+        {
+            GLuint begin = std::min(t * chunkSize, capacity_);
+            GLuint end = std::min(begin + chunkSize, capacity_);
+            function(begin, end, t);
+        }
+    });
+}
+
+GLuint ParticleSimulator::getCapacity() const
+{
+    return capacity_;
+}
+
+GLuint ParticleSimulator::getAliveCount() const
+{
+    return capacity_ - static_cast<GLuint>(deadList_.size());
+}
+
+unsigned int ParticleSimulator::getThreadCount() const
+{
+    return nThreads_;
+}
+
+const ParticleArrays& ParticleSimulator::getParticles() const
+{
+    return particles_;
+}
+
+const std::vector<GLuint>& ParticleSimulator::getDeadList() const
+{
+    return deadList_;
+}
+
+const char* ParticleSimulator::getKernelName()
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(PARTICLE_SIMULATOR_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void benchmarkParticleSimulator()
+{
+    const GLuint N_PARTICLES = 1 << 20;
+    const int N_STEPS = 100;
+    const float DELTA_TIME = 1.0f / 60.0f;
+
+    std::cout << "Particle simulator benchmark (" << ParticleSimulator::getKernelName() << ", "
+        << N_PARTICLES << " particles, " << N_STEPS << " steps)" << std::endl;
+
+    unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned int nThreads = 1; ; nThreads = std::min(nThreads * 2, maxThreads))
+    {
+        ParticleSimulator simulator;
+        simulator.init(N_PARTICLES, nThreads);
+
+        // Toutes les particules émises d'un coup, avec une vie plus longue
+        // que la mesure: seule l'intégration est chronométrée.
+        ParticleEmitter emitter;
+        emitter.velocity = glm::vec3(0.3f, 0.2f, 0.0f);
+        emitter.velocitySpread = 0.1f;
+        emitter.lifetime = glm::vec2(N_STEPS * DELTA_TIME * 2.0f, N_STEPS * DELTA_TIME * 3.0f);
+        emitter.spawnRate = static_cast<float>(N_PARTICLES);
+        GLuint emitterIndex = simulator.addEmitter(emitter);
+        simulator.update(0.0f, 1.0f);
+        simulator.getEmitter(emitterIndex).isEnabled = false;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < N_STEPS; step++)
+            simulator.update(step * DELTA_TIME, DELTA_TIME);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double particlesPerSecond = static_cast<double>(N_PARTICLES) * N_STEPS / elapsed.count();
+        std::cout << "  " << nThreads << " thread(s): " << particlesPerSecond / 1e6 << " M particles/s, "
+            << particlesPerSecond / 1e6 / nThreads << " M particles/s per core" << std::endl;
+
+        if (nThreads == maxThreads)
+            break;
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef PARTICLE_SIMULATOR_H
+#define PARTICLE_SIMULATOR_H
+
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "particle_emitter.hpp"
+
+using namespace gl;
+
+// Particules en SoA. Une particule est vivante si timeToLive > 0. Les valeurs
+// stockées en demi-flottants sur le GPU (vitesse, orientation, maxTimeToLive)
+// sont arrondies de la même façon.
+struct ParticleArrays
+{
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> timeToLive;
+    std::vector<float> velocityX, velocityY, velocityZ;
+    std::vector<float> zOrientation;
+    std::vector<float> maxTimeToLive;
+    std::vector<GLuint> emitterIndex;
+
+    // Remplis par ParticleSimulator::computeAppearance().
+    std::vector<glm::vec4> color;
+    std::vector<glm::vec2> size;
+};
+
+// Équivalent CPU de ParticleSystem (particlesEmit.cs.glsl puis
+// particlesUpdate.cs.glsl), pour exécuter et mesurer la logique des
+// particules sans GPU. La mise à jour est vectorisée (AVX2, SSE ou scalaire
+// selon la compilation) et répartie en tranches sur plusieurs fils.
+class ParticleSimulator
+{
+public:
+    // Nombre de tranches exécutées en parallèle par le JobSystem; 0: un par cœur.
+    void init(GLuint capacity, unsigned int nThreads = 0);
+
+    GLuint addEmitter(const ParticleEmitter& emitter);
+    ParticleEmitter& getEmitter(GLuint index);
+    const std::vector<ParticleEmitter>& getEmitters() const;
+
+    // Même ordre que ParticleSystem::update: émission puis intégration.
+    void update(float time, float deltaTime);
+
+    // Couleur et taille interpolées sur la vie, comme les nuanceurs de dessin.
+    void computeAppearance();
+
+    GLuint getCapacity() const;
+    GLuint getAliveCount() const;
+    unsigned int getThreadCount() const;
+    const ParticleArrays& getParticles() const;
+    const std::vector<GLuint>& getDeadList() const;
+
+    static const char* getKernelName();
+
+private:
+    void emit(float time, float deltaTime);
+    void integrate(float deltaTime);
+
+    template<typename Function>
+    void forEachChunk(Function function);
+
+    ParticleArrays particles_;
+    // Pile des indices libres, dépilée par la fin comme sur le GPU.
+    std::vector<GLuint> deadList_;
+    std::vector<std::vector<GLuint>> diedPerThread_;
+
+    std::vector<ParticleEmitter> emitters_;
+    std::vector<float> spawnAccumulators_;
+
+    GLuint capacity_ = 0;
+    unsigned int nThreads_ = 1;
+};
+
+// Mesure l'intégration pour 1, 2, 4... fils et affiche le débit par cœur.
+void benchmarkParticleSimulator();
+
+#endif // PARTICLE_SIMULATOR_H
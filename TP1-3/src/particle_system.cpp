@@ -0,0 +1,409 @@
+#include "particle_system.hpp"
+#include "particle_simulator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+void ParticleSystem::init(GLuint capacity, const std::string& shaderDirectory)
+{
+    drawShader_.shaderDirectory = shaderDirectory;
+    billboardShader_.shaderDirectory = shaderDirectory;
+    emitShader_.shaderDirectory = shaderDirectory;
+    prepareShader_.shaderDirectory = shaderDirectory;
+    updateShader_.shaderDirectory = shaderDirectory;
+    sortShader_.shaderDirectory = shaderDirectory;
+
+    drawShader_.create();
+    billboardShader_.create();
+    emitShader_.create();
+    prepareShader_.create();
+    updateShader_.create();
+    sortShader_.create();
+
+    // Aucun attribut: les nuanceurs de dessin lisent les particules dans les SSBO.
+    glGenVertexArrays(1, &vao_);
+
+    emitterTable_.allocate(nullptr, MAX_EMITTERS * sizeof(EmitterData), GL_DYNAMIC_DRAW);
+
+    capacity_ = capacity;
+    allocate();
+
+    // Les réallocations de allocate() gardent les mêmes noms de tampons, donc les étiquettes.
+    emitterTable_.setLabel("Particle Emitters");
+    positions_.setLabel("Particle Positions");
+    velocities_.setLabel("Particle Velocities");
+    coldData_.setLabel("Particle Cold Data");
+    deadList_.setLabel("Particle Dead List");
+    aliveLists_[0].setLabel("Particle Alive List 0");
+    aliveLists_[1].setLabel("Particle Alive List 1");
+    counters_.setLabel("Particle Counters");
+    sortEntries_.setLabel("Particle Sort Entries");
+}
+
+void ParticleSystem::reloadShaders()
+{
+    drawShader_.reload();
+    billboardShader_.reload();
+    emitShader_.reload();
+    prepareShader_.reload();
+    updateShader_.reload();
+    sortShader_.reload();
+}
+
+void ParticleSystem::setCapacity(GLuint capacity)
+{
+    capacity_ = capacity;
+    allocate();
+}
+
+GLuint ParticleSystem::getCapacity() const
+{
+    return capacity_;
+}
+
+GLuint ParticleSystem::addEmitter(const ParticleEmitter& emitter)
+{
+    if (emitters_.size() >= MAX_EMITTERS)
+    {
+        std::cerr << "ParticleSystem: plus de " << MAX_EMITTERS << " emetteurs, ajout refuse" << std::endl;
+        return INVALID_EMITTER;
+    }
+
+    emitters_.push_back(emitter);
+    emitterData_.emplace_back();
+    spawnAccumulators_.push_back(0.0f);
+    return static_cast<GLuint>(emitters_.size() - 1);
+}
+
+ParticleEmitter& ParticleSystem::getEmitter(GLuint index)
+{
+    return emitters_[index];
+}
+
+GLuint ParticleSystem::getEmitterCount() const
+{
+    return static_cast<GLuint>(emitters_.size());
+}
+
+void ParticleSystem::setAtlas(GLuint texture, GLuint columns, GLuint rows)
+{
+    atlasTexture_ = texture;
+    atlasColumns_ = std::max(columns, 1u);
+    atlasRows_ = std::max(rows, 1u);
+}
+
+// (Ré)alloue les tampons pour capacity_ particules, toutes mortes.
+void ParticleSystem::allocate()
+{
+    std::vector<GLuint> deadList(capacity_);
+    for (GLuint i = 0; i < capacity_; i++)
+        deadList[i] = capacity_ - 1 - i;
+
+    ParticleCounters counters = {};
+    counters.deadCount = static_cast<GLint>(capacity_);
+    counters.update = { 0, 1, 1 };
+    counters.drawPoints = { 0, 1, 0, 0 };
+    counters.drawQuads = { 4, 0, 0, 0 };
+    counters.sort = { 1, 1, 1 };
+    counters.sortSize = 1;
+
+    // Le tri bitonique a besoin d'une puissance de 2.
+    sortCapacity_ = 1;
+    while (sortCapacity_ < capacity_)
+        sortCapacity_ <<= 1;
+
+    positions_.allocate(nullptr, capacity_ * POSITION_TTL_SIZE, GL_DYNAMIC_COPY);
+    velocities_.allocate(nullptr, capacity_ * VELOCITY_ROTATION_SIZE, GL_DYNAMIC_COPY);
+    coldData_.allocate(nullptr, capacity_ * COLD_SIZE, GL_DYNAMIC_COPY);
+    deadList_.allocate(deadList.data(), capacity_ * sizeof(GLuint), GL_DYNAMIC_COPY);
+    aliveLists_[0].allocate(nullptr, capacity_ * sizeof(GLuint), GL_DYNAMIC_COPY);
+    aliveLists_[1].allocate(nullptr, capacity_ * sizeof(GLuint), GL_DYNAMIC_COPY);
+    counters_.allocate(&counters, sizeof(counters), GL_DYNAMIC_COPY);
+    sortEntries_.allocate(nullptr, sortCapacity_ * 2 * sizeof(GLuint), GL_DYNAMIC_COPY);
+
+    currentAliveList_ = 0;
+    std::fill(spawnAccumulators_.begin(), spawnAccumulators_.end(), 0.0f);
+}
+
+void ParticleSystem::bindBuffers()
+{
+    positions_.setBindingIndex(0);
+    velocities_.setBindingIndex(1);
+    coldData_.setBindingIndex(2);
+    deadList_.setBindingIndex(3);
+    aliveLists_[currentAliveList_].setBindingIndex(4);
+    aliveLists_[1 - currentAliveList_].setBindingIndex(5);
+    counters_.setBindingIndex(6);
+    emitterTable_.setBindingIndex(7);
+    sortEntries_.setBindingIndex(8);
+}
+
+// Seul le budget d'émission est calculé sur le CPU. Chaque émetteur reçoit une
+// plage contiguë d'invocations; particlesEmit.cs.glsl retrouve l'émetteur
+// d'une invocation par recherche binaire sur spawnOffset.
+GLuint ParticleSystem::uploadEmitters(float deltaTime)
+{
+    GLuint totalSpawnCount = 0;
+
+    for (size_t i = 0; i < emitters_.size(); i++)
+    {
+        const ParticleEmitter& emitter = emitters_[i];
+
+        GLuint spawnCount = 0;
+        if (emitter.isEnabled)
+        {
+            spawnAccumulators_[i] += deltaTime * emitter.spawnRate;
+            spawnCount = static_cast<GLuint>(spawnAccumulators_[i]);
+            spawnAccumulators_[i] -= spawnCount;
+        }
+        spawnCount = std::min(spawnCount, capacity_ - totalSpawnCount);
+
+        EmitterData& data = emitterData_[i];
+        data.transform = emitter.transform;
+        data.colorStart = emitter.colorStart;
+        data.colorEnd = emitter.colorEnd;
+        data.velocity = emitter.velocity;
+        data.velocitySpread = emitter.velocitySpread;
+        data.sizeStart = emitter.sizeStart;
+        data.sizeEnd = emitter.sizeEnd;
+        data.lifetime = emitter.lifetime;
+        data.atlasSlot = emitter.atlasSlot;
+        data.spawnOffset = totalSpawnCount;
+        data.spawnCount = spawnCount;
+
+        totalSpawnCount += spawnCount;
+    }
+
+    if (!emitterData_.empty())
+        emitterTable_.updateData(emitterData_.data(), 0, emitterData_.size() * sizeof(EmitterData));
+
+    return totalSpawnCount;
+}
+
+void ParticleSystem::update(float time, float deltaTime)
+{
+    GLuint spawnCount = uploadEmitters(deltaTime);
+    bindBuffers();
+
+    if (spawnCount > 0)
+    {
+        emitShader_.use();
+        glUniform1ui(emitShader_.spawnCountULoc, spawnCount);
+        glUniform1ui(emitShader_.emitterCountULoc, getEmitterCount());
+        glUniform1ui(emitShader_.currentListULoc, currentAliveList_);
+        glUniform1f(emitShader_.timeULoc, time);
+
+        glDispatchCompute((spawnCount + EMIT_GROUP_SIZE - 1) / EMIT_GROUP_SIZE, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    prepareShader_.use();
+    glUniform1ui(prepareShader_.currentListULoc, currentAliveList_);
+    glUniform1ui(prepareShader_.stageULoc, 0);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    updateShader_.use();
+    glUniform1f(updateShader_.deltaTimeULoc, deltaTime);
+    glUniform1ui(updateShader_.currentListULoc, currentAliveList_);
+
+    counters_.bindAsDispatchIndirect();
+    glDispatchComputeIndirect(static_cast<GLintptr>(offsetof(ParticleCounters, update)));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    prepareShader_.use();
+    glUniform1ui(prepareShader_.stageULoc, 1);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    currentAliveList_ = 1 - currentAliveList_;
+}
+
+void ParticleSystem::draw(const glm::mat4& view, const glm::mat4& projection)
+{
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+
+    ParticlesShader& shader = isGeometryShaderEnabled ? drawShader_ : billboardShader_;
+    shader.use();
+    glBindVertexArray(vao_);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture_);
+
+    glm::vec3 cameraRight = glm::normalize(glm::vec3(view[0][0], view[1][0], view[2][0]));
+    glm::vec3 cameraUp = glm::normalize(glm::vec3(view[0][1], view[1][1], view[2][1]));
+
+    glUniformMatrix4fv(shader.viewULoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniform2ui(shader.atlasGridULoc, atlasColumns_, atlasRows_);
+    shader.setMatrices(view, projection, cameraRight, cameraUp);
+
+    bindBuffers();
+
+    if (isSortEnabled)
+    {
+        sort(view);
+        shader.use();
+    }
+
+    // Le nombre de particules vivantes n'est connu que du GPU.
+    counters_.bindAsDrawIndirect();
+    if (isGeometryShaderEnabled)
+        glDrawArraysIndirect(GL_POINTS, (void*)offsetof(ParticleCounters, drawPoints));
+    else
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, (void*)offsetof(ParticleCounters, drawQuads));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
+
+void ParticleSystem::dispatchSort(GLuint stage, GLuint k, GLuint j)
+{
+    glUniform1ui(sortShader_.stageULoc, stage);
+    glUniform1ui(sortShader_.kULoc, k);
+    glUniform1ui(sortShader_.jULoc, j);
+    glDispatchComputeIndirect(static_cast<GLintptr>(offsetof(ParticleCounters, sort)));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+// Tri bitonique de la liste des vivantes courante. Le nombre d'étapes dépend
+// de la capacité puisque le CPU ne connaît pas le nombre de particules; les
+// étapes plus grandes que sortSize sortent immédiatement sur le GPU.
+void ParticleSystem::sort(const glm::mat4& view)
+{
+    sortShader_.use();
+    glUniform1ui(sortShader_.currentListULoc, currentAliveList_);
+    glUniformMatrix4fv(sortShader_.viewULoc, 1, GL_FALSE, glm::value_ptr(view));
+
+    counters_.bindAsDispatchIndirect();
+
+    dispatchSort(0, 0, 0);
+    dispatchSort(1, 0, 0);
+    for (GLuint k = 2 * SORT_BLOCK_SIZE; k <= sortCapacity_; k <<= 1)
+    {
+        for (GLuint j = k / 2; j >= SORT_BLOCK_SIZE; j >>= 1)
+            dispatchSort(2, k, j);
+        dispatchSort(3, k, 0);
+    }
+    dispatchSort(4, 0, 0);
+}
+
+void ParticleSystem::benchmarkSort(const glm::mat4& view)
+{
+    const GLuint savedCapacity = capacity_;
+    const int N_REPETITIONS = 10;
+
+    GLuint query;
+    glGenQueries(1, &query);
+
+    std::cout << "Particle sort benchmark, GPU time per sort:" << std::endl;
+    for (GLuint n = 64; n <= (1u << 20); n *= 4)
+    {
+        capacity_ = n;
+        allocate();
+
+        // Toutes les particules vivantes, dispersées devant la caméra.
+        std::vector<glm::vec4> positions(n);
+        std::vector<GLuint> alive(n);
+        for (GLuint i = 0; i < n; i++)
+        {
+            positions[i] = glm::vec4(
+                (rand() % 2000) / 100.0f - 10.0f,
+                (rand() % 2000) / 100.0f - 10.0f,
+                (rand() % 2000) / 100.0f - 10.0f,
+                1.0f);
+            alive[i] = i;
+        }
+        positions_.updateData(positions.data(), 0, n * POSITION_TTL_SIZE);
+        aliveLists_[0].updateData(alive.data(), 0, n * sizeof(GLuint));
+
+        ParticleCounters counters = {};
+        counters.aliveCount[0] = n;
+        counters.sort = { std::max(n / SORT_BLOCK_SIZE, 1u), 1, 1 };
+        counters.sortSize = n;
+        counters_.updateData(&counters, 0, sizeof(counters));
+
+        currentAliveList_ = 0;
+        bindBuffers();
+
+        // Le tri ne dépend pas des données: les répétitions coûtent autant.
+        glFinish();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (int i = 0; i < N_REPETITIONS; i++)
+            sort(view);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        std::cout << "  " << n << " particles: " << elapsed / 1e6 / N_REPETITIONS << " ms" << std::endl;
+    }
+
+    glDeleteQueries(1, &query);
+
+    capacity_ = savedCapacity;
+    allocate();
+}
+
+void ParticleSystem::uploadState(const ParticleSimulator& simulator)
+{
+    capacity_ = simulator.getCapacity();
+    allocate();
+
+    const ParticleArrays& particles = simulator.getParticles();
+    const std::vector<GLuint>& deadList = simulator.getDeadList();
+
+    std::vector<glm::vec4> positionTtl(capacity_);
+    std::vector<GLuint> velocityRotation(2 * capacity_);
+    std::vector<GLuint> cold(capacity_);
+    std::vector<GLuint> alive;
+    for (GLuint i = 0; i < capacity_; i++)
+    {
+        positionTtl[i] = glm::vec4(particles.positionX[i], particles.positionY[i], particles.positionZ[i], particles.timeToLive[i]);
+        velocityRotation[2 * i] = glm::packHalf2x16(glm::vec2(particles.velocityX[i], particles.velocityY[i]));
+        velocityRotation[2 * i + 1] = glm::packHalf2x16(glm::vec2(particles.velocityZ[i], particles.zOrientation[i]));
+        cold[i] = glm::packHalf1x16(particles.maxTimeToLive[i]) | (particles.emitterIndex[i] << 16);
+        if (particles.timeToLive[i] > 0.0f)
+            alive.push_back(i);
+    }
+
+    positions_.updateData(positionTtl.data(), 0, capacity_ * POSITION_TTL_SIZE);
+    velocities_.updateData(velocityRotation.data(), 0, capacity_ * VELOCITY_ROTATION_SIZE);
+    coldData_.updateData(cold.data(), 0, capacity_ * COLD_SIZE);
+    if (!deadList.empty())
+        deadList_.updateData(deadList.data(), 0, deadList.size() * sizeof(GLuint));
+    if (!alive.empty())
+        aliveLists_[0].updateData(alive.data(), 0, alive.size() * sizeof(GLuint));
+
+    ParticleCounters counters = {};
+    counters.deadCount = static_cast<GLint>(deadList.size());
+    counters.aliveCount[0] = static_cast<GLuint>(alive.size());
+    counters.update = { 0, 1, 1 };
+    counters.drawPoints = { 0, 1, 0, 0 };
+    counters.drawQuads = { 4, 0, 0, 0 };
+    counters.sort = { 1, 1, 1 };
+    counters.sortSize = 1;
+    counters_.updateData(&counters, 0, sizeof(counters));
+
+    currentAliveList_ = 0;
+}
+
+void ParticleSystem::downloadState(std::vector<glm::vec4>& positionTtl, GLuint& aliveCount)
+{
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    positionTtl.resize(capacity_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, positions_.getID());
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, capacity_ * POSITION_TTL_SIZE, positionTtl.data());
+
+    ParticleCounters counters;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counters_.getID());
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), &counters);
+    aliveCount = counters.aliveCount[currentAliveList_];
+}
@@ -0,0 +1,139 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <string>
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <glm/glm.hpp>
+
+#include "particle_emitter.hpp"
+#include "shaders.hpp"
+#include "shader_storage_buffer.hpp"
+
+using namespace gl;
+
+class ParticleSimulator;
+
+// Particules de tous les émetteurs dans les mêmes tampons: une seule
+// répartition d'émission, une seule mise à jour et un seul dessin par trame,
+// peu importe le nombre d'émetteurs.
+class ParticleSystem
+{
+public:
+    // L'indice d'émetteur est conservé sur 16 bits avec chaque particule.
+    static constexpr GLuint MAX_EMITTERS = 1024;
+    // Retourné par addEmitter() quand la table est pleine.
+    static constexpr GLuint INVALID_EMITTER = ~0u;
+
+    // shaderDirectory permet à TP4 de charger les nuanceurs de TP1-3.
+    void init(GLuint capacity, const std::string& shaderDirectory = "./shaders/");
+    void reloadShaders();
+
+    void setCapacity(GLuint capacity);
+    GLuint getCapacity() const;
+
+    GLuint addEmitter(const ParticleEmitter& emitter);
+    ParticleEmitter& getEmitter(GLuint index);
+    GLuint getEmitterCount() const;
+
+    // Atlas de columns x rows cases; atlasSlot choisit la case d'un émetteur.
+    void setAtlas(GLuint texture, GLuint columns, GLuint rows);
+
+    void update(float time, float deltaTime);
+    void draw(const glm::mat4& view, const glm::mat4& projection);
+
+    // Temps GPU du tri seul, de 64 à 1M particules, affiché dans la console.
+    // Les particules en cours sont perdues.
+    void benchmarkSort(const glm::mat4& view);
+
+    // Copie l'état d'un ParticleSimulator de même capacité (sans ses
+    // émetteurs) et relit les particules, pour comparer les deux chemins.
+    void uploadState(const ParticleSimulator& simulator);
+    void downloadState(std::vector<glm::vec4>& positionTtl, GLuint& aliveCount);
+
+    bool isGeometryShaderEnabled = false;
+    // Trie de l'arrière vers l'avant avant le dessin (voir particlesSort.cs.glsl).
+    bool isSortEnabled = false;
+
+private:
+    void allocate();
+    void bindBuffers();
+    void sort(const glm::mat4& view);
+    void dispatchSort(GLuint stage, GLuint k, GLuint j);
+    GLuint uploadEmitters(float deltaTime);
+
+    // Même disposition que Emitter dans les nuanceurs de particules.
+    struct EmitterData
+    {
+        glm::mat4 transform;
+        glm::vec4 colorStart;
+        glm::vec4 colorEnd;
+        glm::vec3 velocity;
+        GLfloat velocitySpread;
+        glm::vec2 sizeStart;
+        glm::vec2 sizeEnd;
+        glm::vec2 lifetime;
+        GLuint atlasSlot;
+        GLuint spawnOffset;
+        GLuint spawnCount;
+        GLuint padding[3];
+    };
+
+    // Même disposition que ParticleCountersBlock dans les nuanceurs de particules.
+    struct ParticleCounters
+    {
+        GLint deadCount;
+        GLuint aliveCount[2];
+        GLuint padding0;
+        DispatchIndirectCommand update;
+        GLuint padding1;
+        DrawArraysIndirectCommand drawPoints;
+        DrawArraysIndirectCommand drawQuads;
+        DispatchIndirectCommand sort;
+        GLuint sortSize;
+    };
+
+    // Doit correspondre à local_size_x de particlesEmit.cs.glsl.
+    static constexpr GLuint EMIT_GROUP_SIZE = 64;
+    // Doit correspondre à BLOCK_SIZE de particlesSort.cs.glsl.
+    static constexpr GLuint SORT_BLOCK_SIZE = 512;
+
+    // Particules en SoA std430, mises à jour sur place (voir particlesUpdate.cs.glsl).
+    // Chaud, lu et écrit à chaque trame: position + timeToLive, vitesse en demi-flottants.
+    // Froid, écrit à l'émission et lu au dessin: maxTimeToLive en demi-flottant + indice d'émetteur.
+    static constexpr GLsizeiptr POSITION_TTL_SIZE = 4 * sizeof(GLfloat);
+    static constexpr GLsizeiptr VELOCITY_ROTATION_SIZE = 2 * sizeof(GLuint);
+    static constexpr GLsizeiptr COLD_SIZE = sizeof(GLuint);
+
+    ParticlesShader drawShader_;
+    ParticlesBillboardShader billboardShader_;
+    ParticlesEmitShader emitShader_;
+    ParticlesPrepareShader prepareShader_;
+    ParticlesUpdateShader updateShader_;
+    ParticlesSortShader sortShader_;
+
+    ShaderStorageBuffer positions_;
+    ShaderStorageBuffer velocities_;
+    ShaderStorageBuffer coldData_;
+    ShaderStorageBuffer deadList_;
+    ShaderStorageBuffer aliveLists_[2];
+    ShaderStorageBuffer counters_;
+    ShaderStorageBuffer emitterTable_;
+    ShaderStorageBuffer sortEntries_;
+
+    std::vector<ParticleEmitter> emitters_;
+    std::vector<EmitterData> emitterData_;
+    std::vector<float> spawnAccumulators_;
+
+    GLuint vao_ = 0;
+    GLuint capacity_ = 0;
+    GLuint sortCapacity_ = 1;
+    GLuint currentAliveList_ = 0;
+
+    GLuint atlasTexture_ = 0;
+    GLuint atlasColumns_ = 1;
+    GLuint atlasRows_ = 1;
+};
+
+#endif // PARTICLE_SYSTEM_H
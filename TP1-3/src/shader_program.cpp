@@ -2,6 +2,7 @@
 
 #include <iostream>
 
+#include "inf2705/gl_debug.hpp"
 #include "inf2705/utils.hpp"
 
 
@@ -57,6 +58,7 @@ void ShaderProgram::create()
 {
     id_ = glCreateProgram();
     load();
+    GLDebug::label(GL_PROGRAM, id_, name_);
 }
 
 void ShaderProgram::reload()
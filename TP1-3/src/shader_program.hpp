@@ -1,3 +1,6 @@
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
 #include <glbinding/gl/gl.h>
 using namespace gl;
 
@@ -31,3 +34,4 @@ protected:
     std::unordered_map<std::string, GLuint> shaderSourcesCompiled_;
 };
 
+#endif // SHADER_PROGRAM_H
@@ -1,6 +1,9 @@
 #include "shader_storage_buffer.hpp"
 
+#include <inf2705/gl_debug.hpp>
+
 ShaderStorageBuffer::ShaderStorageBuffer()
+    : id_(0)
 {
 }
 
@@ -18,11 +21,18 @@ ShaderStorageBuffer::~ShaderStorageBuffer()
 
 void ShaderStorageBuffer::allocate(const void* data, GLsizeiptr byteSize, GLenum usage)
 {
-    glGenBuffers(1, &id_);
+    // Une réallocation réutilise le même nom de tampon.
+    if (id_ == 0)
+        glGenBuffers(1, &id_);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, id_);
     glBufferData(GL_SHADER_STORAGE_BUFFER, byteSize, data, usage);
 }
 
+void ShaderStorageBuffer::setLabel(const char* label)
+{
+    GLDebug::label(GL_BUFFER, id_, label);
+}
+
 void ShaderStorageBuffer::setBindingIndex(GLuint index)
 {
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, id_);
@@ -39,6 +49,16 @@ void ShaderStorageBuffer::bindAsArray()
     glBindBuffer(GL_ARRAY_BUFFER, id_);
 }
 
+void ShaderStorageBuffer::bindAsDrawIndirect()
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, id_);
+}
+
+void ShaderStorageBuffer::bindAsDispatchIndirect()
+{
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, id_);
+}
+
 ShaderStorageBuffer& ShaderStorageBuffer::operator=(ShaderStorageBuffer&& other)
 {
     id_ = other.id_;
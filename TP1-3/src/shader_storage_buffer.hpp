@@ -5,6 +5,24 @@
 
 using namespace gl;
 
+// Disposition imposée par glDrawArraysIndirect. Les nuanceurs de calcul qui
+// remplissent une commande doivent déclarer les mêmes champs dans cet ordre.
+struct DrawArraysIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+// Disposition imposée par glDispatchComputeIndirect.
+struct DispatchIndirectCommand
+{
+    GLuint numGroupsX;
+    GLuint numGroupsY;
+    GLuint numGroupsZ;
+};
+
 class ShaderStorageBuffer
 {
 public:
@@ -13,12 +31,18 @@ public:
     ~ShaderStorageBuffer();
     
     void allocate(const void* data, GLsizeiptr byteSize, GLenum usage);
+    // Nom affiché par les outils de débogage, après allocate(). Gardé par les réallocations.
+    void setLabel(const char* label);
     
     void setBindingIndex(GLuint index);
 
     void updateData(const void* data, GLintptr offset, GLsizeiptr byteSize);
     
     void bindAsArray();
+
+    void bindAsDrawIndirect();
+
+    void bindAsDispatchIndirect();
     
     ShaderStorageBuffer& operator=(ShaderStorageBuffer&& other);
     GLuint getID() const;
@@ -110,8 +110,10 @@ void GrassShader::load()
 void GrassShader::getAllUniformLocations()
 {
     mvpULoc = glGetUniformLocation(id_, "mvp");
-    modelViewULoc = glGetUniformLocation(id_, "modelView");
-
+    modelULoc = glGetUniformLocation(id_, "model");
+    tileTessLevelULoc = glGetUniformLocation(id_, "tileTessLevel");
+    cameraPositionULoc = glGetUniformLocation(id_, "cameraPosition");
+    fadeDistanceULoc = glGetUniformLocation(id_, "fadeDistance");
 }
 
 void GrassShader::setMatrices(glm::mat4& mvp, glm::mat4& model)
@@ -120,25 +122,57 @@ void GrassShader::setMatrices(glm::mat4& mvp, glm::mat4& model)
     glUniformMatrix4fv(modelULoc, 1, GL_FALSE, glm::value_ptr(model));
 }
 
-void GrassShader::setModelView(const glm::mat4& mv)
+void GrassGenerateShader::load()
 {
-    glUniformMatrix4fv(modelViewULoc, 1, GL_FALSE, glm::value_ptr(mv));
+    const char* COMPUTE_SRC_PATH = "./shaders/grassGenerate.cs.glsl";
+
+    name_ = "GrassGenerate";
+
+    loadShaderSource(GL_COMPUTE_SHADER, COMPUTE_SRC_PATH);
+    link();
 }
 
-void ParticlesShader::load()
+void GrassGenerateShader::getAllUniformLocations()
 {
-    const char* VERTEX_SRC_PATH = "./shaders/particlesDraw.vs.glsl";
-    const char* GEOMETRY_SRC_PATH = "./shaders/particlesDraw.gs.glsl";
-    const char* FRAGMENT_SRC_PATH = "./shaders/particlesDraw.fs.glsl";
+    gridSizeULoc = glGetUniformLocation(id_, "gridSize");
+    gridStartULoc = glGetUniformLocation(id_, "gridStart");
+    cellSizeULoc = glGetUniformLocation(id_, "cellSize");
+    maxBladesULoc = glGetUniformLocation(id_, "maxBlades");
+    cameraPositionULoc = glGetUniformLocation(id_, "cameraPosition");
+    frustumPlanesULoc = glGetUniformLocation(id_, "frustumPlanes");
+}
 
-    name_ = "Particles";
+void GrassBladeShader::load()
+{
+    const char* VERTEX_SRC_PATH = "./shaders/grassBlade.vs.glsl";
+    const char* FRAGMENT_SRC_PATH = "./shaders/grass.fs.glsl";
+
+    name_ = "GrassBlade";
 
     loadShaderSource(GL_VERTEX_SHADER, VERTEX_SRC_PATH);
-    loadShaderSource(GL_GEOMETRY_SHADER, GEOMETRY_SRC_PATH);
     loadShaderSource(GL_FRAGMENT_SHADER, FRAGMENT_SRC_PATH);
     link();
 }
 
+void GrassBladeShader::getAllUniformLocations()
+{
+    mvpULoc = glGetUniformLocation(id_, "mvp");
+}
+
+void ParticlesShader::load()
+{
+    const std::string VERTEX_SRC_PATH = shaderDirectory + "particlesDraw.vs.glsl";
+    const std::string GEOMETRY_SRC_PATH = shaderDirectory + "particlesDraw.gs.glsl";
+    const std::string FRAGMENT_SRC_PATH = shaderDirectory + "particlesDraw.fs.glsl";
+
+    name_ = "Particles";
+
+    loadShaderSource(GL_VERTEX_SHADER, VERTEX_SRC_PATH.c_str());
+    loadShaderSource(GL_GEOMETRY_SHADER, GEOMETRY_SRC_PATH.c_str());
+    loadShaderSource(GL_FRAGMENT_SHADER, FRAGMENT_SRC_PATH.c_str());
+    link();
+}
+
 void ParticlesShader::getAllUniformLocations()
 {
     viewULoc = glGetUniformLocation(id_, "view");
@@ -147,6 +181,7 @@ void ParticlesShader::getAllUniformLocations()
     texSamplerULoc = glGetUniformLocation(id_, "textureSampler");
     cameraRightULoc = glGetUniformLocation(id_, "cameraRight");
     cameraUpULoc = glGetUniformLocation(id_, "cameraUp");
+    atlasGridULoc = glGetUniformLocation(id_, "atlasGrid");
 }
 
 void ParticlesShader::setMatrices(const glm::mat4& modelView,
@@ -160,14 +195,26 @@ void ParticlesShader::setMatrices(const glm::mat4& modelView,
     glUniform3fv(cameraUpULoc, 1, glm::value_ptr(cameraUp));
 }
 
+void ParticlesBillboardShader::load()
+{
+    const std::string VERTEX_SRC_PATH = shaderDirectory + "particlesBillboard.vs.glsl";
+    const std::string FRAGMENT_SRC_PATH = shaderDirectory + "particlesDraw.fs.glsl";
+
+    name_ = "ParticlesBillboard";
+
+    loadShaderSource(GL_VERTEX_SHADER, VERTEX_SRC_PATH.c_str());
+    loadShaderSource(GL_FRAGMENT_SHADER, FRAGMENT_SRC_PATH.c_str());
+    link();
+}
+
 void ParticlesUpdateShader::load()
 {
-    const char* COMPUTE_SRC_PATH = "./shaders/particlesUpdate.cs.glsl";
+    const std::string COMPUTE_SRC_PATH = shaderDirectory + "particlesUpdate.cs.glsl";
 
     name_ = "ParticlesUpdate";
     std::cout << "Loading compute shader: " << COMPUTE_SRC_PATH << std::endl;
 
-    loadShaderSource(GL_COMPUTE_SHADER, COMPUTE_SRC_PATH);
+    loadShaderSource(GL_COMPUTE_SHADER, COMPUTE_SRC_PATH.c_str());
     link();
 
     std::cout << "Compute shader loaded with ID: " << id_ << std::endl;
@@ -175,8 +222,59 @@ void ParticlesUpdateShader::load()
 
 void ParticlesUpdateShader::getAllUniformLocations()
 {
-    timeULoc = glGetUniformLocation(id_, "time");
     deltaTimeULoc = glGetUniformLocation(id_, "deltaTime");
-    emitterPosULoc = glGetUniformLocation(id_, "emitterPosition");
-    emitterDirULoc = glGetUniformLocation(id_, "emitterDirection");
-}
\ No newline at end of file
+    currentListULoc = glGetUniformLocation(id_, "currentList");
+}
+
+void ParticlesEmitShader::load()
+{
+    const std::string COMPUTE_SRC_PATH = shaderDirectory + "particlesEmit.cs.glsl";
+
+    name_ = "ParticlesEmit";
+
+    loadShaderSource(GL_COMPUTE_SHADER, COMPUTE_SRC_PATH.c_str());
+    link();
+}
+
+void ParticlesEmitShader::getAllUniformLocations()
+{
+    spawnCountULoc = glGetUniformLocation(id_, "spawnCount");
+    emitterCountULoc = glGetUniformLocation(id_, "emitterCount");
+    currentListULoc = glGetUniformLocation(id_, "currentList");
+    timeULoc = glGetUniformLocation(id_, "time");
+}
+
+void ParticlesPrepareShader::load()
+{
+    const std::string COMPUTE_SRC_PATH = shaderDirectory + "particlesPrepare.cs.glsl";
+
+    name_ = "ParticlesPrepare";
+
+    loadShaderSource(GL_COMPUTE_SHADER, COMPUTE_SRC_PATH.c_str());
+    link();
+}
+
+void ParticlesPrepareShader::getAllUniformLocations()
+{
+    stageULoc = glGetUniformLocation(id_, "stage");
+    currentListULoc = glGetUniformLocation(id_, "currentList");
+}
+
+void ParticlesSortShader::load()
+{
+    const std::string COMPUTE_SRC_PATH = shaderDirectory + "particlesSort.cs.glsl";
+
+    name_ = "ParticlesSort";
+
+    loadShaderSource(GL_COMPUTE_SHADER, COMPUTE_SRC_PATH.c_str());
+    link();
+}
+
+void ParticlesSortShader::getAllUniformLocations()
+{
+    stageULoc = glGetUniformLocation(id_, "stage");
+    currentListULoc = glGetUniformLocation(id_, "currentList");
+    kULoc = glGetUniformLocation(id_, "k");
+    jULoc = glGetUniformLocation(id_, "j");
+    viewULoc = glGetUniformLocation(id_, "view");
+}
@@ -1,7 +1,12 @@
+#ifndef SHADERS_H
+#define SHADERS_H
+
 #include "shader_program.hpp"
 
 #include <glm/glm.hpp>
 
+#include <string>
+
 // Implémentation de vos shaders ici.
 // Ils doivent hérité de ShaderProgram et implémenter les méthodes virtuelles pures
 // load() et getAllUniformLocations().
@@ -82,19 +87,53 @@ public:
     GLuint mvpULoc = 0;
     GLuint modelULoc = 0;
     GLuint timeULoc = 0;
-    GLint modelViewULoc;
+    GLuint tileTessLevelULoc = 0;
+    GLuint cameraPositionULoc = 0;
+    GLuint fadeDistanceULoc = 0;
 
     inline void use() { glUseProgram(id_); }
 
     void setMatrices(glm::mat4& mvp, glm::mat4& model);
-    void setModelView(const glm::mat4& mv);
 
 protected:
     virtual void load() override;
     virtual void getAllUniformLocations() override;
 };
 
-class ParticlesShader : public ShaderProgram
+class GrassGenerateShader : public ShaderProgram
+{
+public:
+    GLuint gridSizeULoc = 0;
+    GLuint gridStartULoc = 0;
+    GLuint cellSizeULoc = 0;
+    GLuint maxBladesULoc = 0;
+    GLuint cameraPositionULoc = 0;
+    GLuint frustumPlanesULoc = 0;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class GrassBladeShader : public ShaderProgram
+{
+public:
+    GLuint mvpULoc = 0;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+// Nuanceurs de ParticleSystem. Le répertoire des sources est configurable
+// pour que TP4 puisse charger ceux de TP1-3.
+class ParticlesProgram : public ShaderProgram
+{
+public:
+    std::string shaderDirectory = "./shaders/";
+};
+
+class ParticlesShader : public ParticlesProgram
 {
 public:
     GLuint viewULoc = 0;
@@ -103,6 +142,7 @@ public:
     GLuint texSamplerULoc = 0;
     GLuint cameraRightULoc = 0;
     GLuint cameraUpULoc = 0;
+    GLuint atlasGridULoc = 0;
 
     void setMatrices(const glm::mat4& modelView, const glm::mat4& projection, const glm::vec3& cameraRight, const glm::vec3& cameraUp);
 
@@ -111,13 +151,58 @@ protected:
     virtual void getAllUniformLocations() override;
 };
 
-class ParticlesUpdateShader : public ShaderProgram
+// Même interface que ParticlesShader, mais le quad est construit dans le
+// nuanceur de sommets (une instance par particule) plutôt que par un
+// nuanceur de géométrie.
+class ParticlesBillboardShader : public ParticlesShader
+{
+protected:
+    virtual void load() override;
+};
+
+class ParticlesEmitShader : public ParticlesProgram
+{
+public:
+    GLuint spawnCountULoc = 0;
+    GLuint emitterCountULoc = 0;
+    GLuint currentListULoc = 0;
+    GLuint timeULoc = 0;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class ParticlesPrepareShader : public ParticlesProgram
+{
+public:
+    GLuint stageULoc = 0;
+    GLuint currentListULoc = 0;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class ParticlesSortShader : public ParticlesProgram
+{
+public:
+    GLuint stageULoc = 0;
+    GLuint currentListULoc = 0;
+    GLuint kULoc = 0;
+    GLuint jULoc = 0;
+    GLuint viewULoc = 0;
+
+protected:
+    virtual void load() override;
+    virtual void getAllUniformLocations() override;
+};
+
+class ParticlesUpdateShader : public ParticlesProgram
 {
 public:
-    GLuint timeULoc;
     GLuint deltaTimeULoc;
-    GLuint emitterPosULoc;
-    GLuint emitterDirULoc;
+    GLuint currentListULoc;
 
 protected:
     // Load shader and link
@@ -125,4 +210,6 @@ protected:
 
     // Get uniform locations after linking
     virtual void getAllUniformLocations() override;
-};
\ No newline at end of file
+};
+
+#endif // SHADERS_H
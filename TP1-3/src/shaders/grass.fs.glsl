@@ -1,6 +1,6 @@
 #version 330 core
 
-in ATTRIBS_GS_OUT
+in ATTRIBS_BLADE_OUT
 {
     float heightRatio;
 } attribsIn;
@@ -8,13 +8,15 @@ in ATTRIBS_TES_OUT
     vec3 worldPos;
 } attribsIn[];
 
-out ATTRIBS_GS_OUT
+out ATTRIBS_BLADE_OUT
 {
     float heightRatio;
 } attribsOut;
 
 
 uniform mat4 mvp;
+uniform vec3 cameraPosition;
+uniform float fadeDistance;
 
 // Fonction pseudo aléatoire, utiliser le paramètre co pour avoir une valeur différente en sortie
 float rand(vec2 co){
@@ -35,6 +37,9 @@ void main()
     const float varHeight  = 0.4;
     float height = baseHeight + varHeight * r;
 
+    // Les brins rapetissent à l'approche de la distance où les tuiles sont ignorées.
+    height *= 1.0 - smoothstep(0.8 * fadeDistance, fadeDistance, distance(base, cameraPosition));
+
     float angleY = r * 6.28318;      // 0..2π
     float angleX = r * 0.1 * 3.1415; // courbure
 
@@ -0,0 +1,66 @@
+#version 430 core
+
+// Aucun attribut de sommet: le brin est lu par gl_InstanceID dans les données
+// écrites par grassGenerate.cs.glsl et le sommet est choisi par gl_VertexID.
+
+struct Blade
+{
+    vec4 positionHeight; // xyz: base du brin, w: hauteur
+    vec4 shape;          // x: demi-largeur, y: courbure, z: orientation
+};
+
+layout(std430, binding = 0) readonly restrict buffer BladesBlock
+{
+    Blade blades[];
+};
+
+// Bande de triangles qui s'amincit vers la pointe: x dans [-1, 1] sur la
+// largeur, y dans [0, 1] sur la hauteur.
+const vec2 BLADE_VERTICES[7] = vec2[](
+    vec2(-1.0, 0.0),       vec2(1.0, 0.0),
+    vec2(-1.0, 1.0 / 3.0), vec2(1.0, 1.0 / 3.0),
+    vec2(-1.0, 2.0 / 3.0), vec2(1.0, 2.0 / 3.0),
+    vec2(0.0, 1.0)
+);
+
+out ATTRIBS_BLADE_OUT
+{
+    float heightRatio;
+} attribsOut;
+
+uniform mat4 mvp;
+
+void main()
+{
+    Blade blade = blades[gl_InstanceID];
+    vec2 bladeVertex = BLADE_VERTICES[gl_VertexID];
+
+    vec3 base = blade.positionHeight.xyz;
+    float height = blade.positionHeight.w;
+    float width = blade.shape.x;
+    float angleX = blade.shape.y;
+    float angleY = blade.shape.z;
+
+    mat3 rotY = mat3(
+        cos(angleY), 0, sin(angleY),
+        0, 1, 0,
+       -sin(angleY), 0, cos(angleY)
+    );
+    
+    mat3 rotX = mat3(
+        1, 0, 0,
+        0, cos(angleX), -sin(angleX),
+        0, sin(angleX), cos(angleX)
+    );
+
+    vec3 vertical = vec3(0, height, 0);
+    vec3 up = rotY * (rotX * vertical);
+    vec3 right = rotY * vec3(width, 0, 0);
+
+    // La courbure s'accentue vers la pointe; la largeur s'amincit.
+    float t = bladeVertex.y;
+    vec3 pos = base + mix(vertical, up, t) * t + right * bladeVertex.x * (1.0 - t);
+
+    attribsOut.heightRatio = t;
+    gl_Position = mvp * vec4(pos, 1.0);
+}
@@ -0,0 +1,124 @@
+#version 430 core
+
+// Une invocation par cellule de la grille de gazon. Les cellules hors du
+// frustum ou au-delà de CULL_DIST ne produisent aucun brin; les autres en
+// produisent de moins en moins avec la distance.
+layout(local_size_x = 64) in;
+
+struct Blade
+{
+    vec4 positionHeight; // xyz: base du brin, w: hauteur
+    vec4 shape;          // x: demi-largeur, y: courbure, z: orientation
+};
+
+layout(std430, binding = 0) writeonly restrict buffer BladesBlock
+{
+    Blade blades[];
+};
+
+// Même disposition que DrawArraysIndirectCommand.
+layout(std430, binding = 1) restrict buffer DrawCommandBlock
+{
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint baseInstance;
+};
+
+uniform ivec2 gridSize;
+uniform vec2 gridStart;
+uniform float cellSize;
+uniform uint maxBlades;
+
+uniform vec3 cameraPosition;
+uniform vec4 frustumPlanes[6];
+
+// Mêmes distances que grass.tcs.glsl.
+const float MIN_DIST = 10.0;
+const float MAX_DIST = 40.0;
+const float CULL_DIST = 60.0;
+
+const int MAX_BLADES_PER_SIDE = 12;
+const int MIN_BLADES_PER_SIDE = 2;
+
+const float MAX_BLADE_HEIGHT = 0.8;
+
+// Fonction pseudo aléatoire, utiliser le paramètre co pour avoir une valeur différente en sortie
+float rand(vec2 co){
+    return fract(sin(dot(co, vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+bool isBoxVisible(vec3 minCorner, vec3 maxCorner)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        vec3 positive = mix(minCorner, maxCorner, step(0.0, frustumPlanes[i].xyz));
+        if (dot(frustumPlanes[i].xyz, positive) + frustumPlanes[i].w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+void main()
+{
+    uint cell = gl_GlobalInvocationID.x;
+    if (cell >= uint(gridSize.x * gridSize.y))
+        return;
+
+    int x = int(cell) / gridSize.y;
+    int z = int(cell) % gridSize.y;
+    vec3 origin = vec3(gridStart.x + x * cellSize, 0.0, gridStart.y + z * cellSize);
+
+    // La route
+    if (origin.z > -3.0 && origin.z < 2.0)
+        return;
+
+    vec3 center = origin + vec3(0.5 * cellSize, 0.0, 0.5 * cellSize);
+    float dist = distance(cameraPosition, center);
+    if (dist > CULL_DIST)
+        return;
+
+    // Les brins peuvent dépasser de la cellule une fois inclinés.
+    vec3 margin = vec3(MAX_BLADE_HEIGHT, 0.0, MAX_BLADE_HEIGHT);
+    vec3 minCorner = origin - margin;
+    vec3 maxCorner = origin + vec3(cellSize, MAX_BLADE_HEIGHT, cellSize) + margin;
+    if (!isBoxVisible(minCorner, maxCorner))
+        return;
+
+    float f = clamp((dist - MIN_DIST) / (MAX_DIST - MIN_DIST), 0.0, 1.0);
+    int side = int(round(mix(float(MAX_BLADES_PER_SIDE), float(MIN_BLADES_PER_SIDE), f)));
+    uint nBlades = uint(side * side);
+
+    uint first = atomicAdd(instanceCount, nBlades);
+    if (first + nBlades > maxBlades)
+    {
+        // Garde instanceCount borné; les brins en trop sont abandonnés.
+        atomicMin(instanceCount, maxBlades);
+        if (first >= maxBlades)
+            return;
+        nBlades = maxBlades - first;
+    }
+
+    for (uint i = 0u; i < nBlades; ++i)
+    {
+        vec2 slot = vec2(i % uint(side), i / uint(side));
+        vec2 jitter = vec2(rand(origin.xz + slot), rand(origin.zx - slot));
+        vec3 base = origin + vec3((slot.x + jitter.x) / float(side), 0.0, (slot.y + jitter.y) / float(side)) * cellSize;
+
+        float r = rand(base.xz);
+
+        const float baseWidth = 0.05;
+        const float varWidth  = 0.04;
+        float width  = baseWidth + varWidth * r;
+
+        const float baseHeight = 0.4;
+        const float varHeight  = 0.4;
+        float height = baseHeight + varHeight * r;
+
+        float angleY = r * 6.28318;      // 0..2π
+        float angleX = r * 0.1 * 3.1415; // courbure
+
+        blades[first + i].positionHeight = vec4(base, height);
+        blades[first + i].shape = vec4(width, angleX, angleY, 0.0);
+    }
+}
@@ -0,0 +1,85 @@
+#version 430 core
+
+// Équivalent de particlesDraw.vs.glsl + particlesDraw.gs.glsl sans nuanceur de
+// géométrie: dessiné avec 4 sommets par instance, une instance par particule.
+
+// Voir particlesUpdate.cs.glsl pour la disposition des données.
+layout(std430, binding = 0) readonly buffer PositionTtlBlock
+{
+    vec4 positionTtl[];
+};
+
+layout(std430, binding = 2) readonly buffer ColdBlock
+{
+    uint cold[];
+};
+
+layout(std430, binding = 4) readonly buffer AliveListBlock
+{
+    uint aliveList[];
+};
+
+// Même disposition que ParticleSystem::EmitterData côté C++.
+struct Emitter
+{
+    mat4 transform;
+    vec4 colorStart;
+    vec4 colorEnd;
+    vec3 velocity;
+    float velocitySpread;
+    vec2 sizeStart;
+    vec2 sizeEnd;
+    vec2 lifetime;
+    uint atlasSlot;
+    uint spawnOffset;
+    uint spawnCount;
+};
+
+layout(std430, binding = 7) readonly buffer EmitterBlock
+{
+    Emitter emitters[];
+};
+
+// Nombre de colonnes et de lignes de l'atlas de textures.
+uniform uvec2 atlasGrid;
+
+out vec2 texCoord;
+out vec4 color;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraRight;
+uniform vec3 cameraUp;
+
+// Même ordre de sommets que la bande émise par particlesDraw.gs.glsl.
+const vec2 CORNERS[4] = vec2[](
+    vec2(-1.0, -1.0),
+    vec2( 1.0, -1.0),
+    vec2(-1.0,  1.0),
+    vec2( 1.0,  1.0)
+);
+
+void main()
+{
+    uint id = aliveList[gl_InstanceID];
+    vec4 p = positionTtl[id];
+    uint c = cold[id];
+
+    float maxTimeToLive = unpackHalf2x16(c).x;
+    uint emitterIndex = c >> 16;
+    float life01 = 1.0 - p.w / maxTimeToLive;
+
+    vec2 corner = CORNERS[gl_VertexID];
+    vec2 halfSize = mix(emitters[emitterIndex].sizeStart, emitters[emitterIndex].sizeEnd, life01) * 0.5;
+
+    vec3 position = p.xyz
+        + cameraRight * halfSize.x * corner.x
+        + cameraUp * halfSize.y * corner.y;
+
+    uint slot = emitters[emitterIndex].atlasSlot;
+    vec2 cell = vec2(slot % atlasGrid.x, slot / atlasGrid.x);
+
+    texCoord = (cell + corner * 0.5 + 0.5) / vec2(atlasGrid);
+    color = mix(emitters[emitterIndex].colorStart, emitters[emitterIndex].colorEnd, life01);
+    gl_Position = projection * view * vec4(position, 1.0);
+}
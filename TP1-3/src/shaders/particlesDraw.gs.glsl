@@ -8,6 +8,7 @@ in VS_OUT {
     float zOrientation;
     vec4 color;
     vec2 size;
+    vec4 atlasRect;
 } gsIn[];
 
 out vec2 texCoord;
@@ -28,19 +29,23 @@ void main()
 
     color = gsIn[0].color;
 
-    texCoord = vec2(0.0, 0.0);
+    // Case de l'atlas: xy coin, zw taille.
+    vec2 atlasOffset = gsIn[0].atlasRect.xy;
+    vec2 atlasScale = gsIn[0].atlasRect.zw;
+
+    texCoord = atlasOffset + vec2(0.0, 0.0) * atlasScale;
     gl_Position = projection * view * vec4(center - right - up, 1.0);
     EmitVertex();
 
-    texCoord = vec2(1.0, 0.0);
+    texCoord = atlasOffset + vec2(1.0, 0.0) * atlasScale;
     gl_Position = projection * view * vec4(center + right - up, 1.0);
     EmitVertex();
 
-    texCoord = vec2(0.0, 1.0);
+    texCoord = atlasOffset + vec2(0.0, 1.0) * atlasScale;
     gl_Position = projection * view * vec4(center - right + up, 1.0);
     EmitVertex();
 
-    texCoord = vec2(1.0, 1.0);
+    texCoord = atlasOffset + vec2(1.0, 1.0) * atlasScale;
     gl_Position = projection * view * vec4(center + right + up, 1.0);
     EmitVertex();
 
@@ -5,28 +5,71 @@ out VS_OUT {
     float zOrientation;
     vec4 color;
     vec2 size;
+    vec4 atlasRect;
 } vsOut;
 
-layout(std430, binding = 0) readonly buffer ParticlesInputBlock
+// Voir particlesUpdate.cs.glsl pour la disposition des données.
+layout(std430, binding = 0) readonly buffer PositionTtlBlock
 {
-    struct Particle
-    {
-        vec3 position;
-        float zOrientation;
-        vec3 velocity;
-        vec4 color;
-        vec2 size;
-        float timeToLive;
-        float maxTimeToLive;
-    } particles[];
+    vec4 positionTtl[];
 };
 
+layout(std430, binding = 1) readonly buffer VelocityRotationBlock
+{
+    uvec2 velocityRotation[];
+};
+
+layout(std430, binding = 2) readonly buffer ColdBlock
+{
+    uint cold[];
+};
+
+layout(std430, binding = 4) readonly buffer AliveListBlock
+{
+    uint aliveList[];
+};
+
+// Même disposition que ParticleSystem::EmitterData côté C++.
+struct Emitter
+{
+    mat4 transform;
+    vec4 colorStart;
+    vec4 colorEnd;
+    vec3 velocity;
+    float velocitySpread;
+    vec2 sizeStart;
+    vec2 sizeEnd;
+    vec2 lifetime;
+    uint atlasSlot;
+    uint spawnOffset;
+    uint spawnCount;
+};
+
+layout(std430, binding = 7) readonly buffer EmitterBlock
+{
+    Emitter emitters[];
+};
+
+// Nombre de colonnes et de lignes de l'atlas de textures.
+uniform uvec2 atlasGrid;
+
 void main()
 {
-    Particle p = particles[gl_VertexID];
+    uint id = aliveList[gl_VertexID];
+    vec4 p = positionTtl[id];
+    uint c = cold[id];
+
+    float maxTimeToLive = unpackHalf2x16(c).x;
+    uint emitterIndex = c >> 16;
+    float age = maxTimeToLive - p.w;
+    float life01 = 1.0 - p.w / maxTimeToLive;
+
+    uint slot = emitters[emitterIndex].atlasSlot;
+    vec2 cellSize = 1.0 / vec2(atlasGrid);
 
-    vsOut.position     = p.position;
-    vsOut.zOrientation = p.zOrientation;
-    vsOut.color        = p.color;
-    vsOut.size         = p.size;
+    vsOut.position     = p.xyz;
+    vsOut.zOrientation = unpackHalf2x16(velocityRotation[id].y).y + 0.5 * age;
+    vsOut.color        = mix(emitters[emitterIndex].colorStart, emitters[emitterIndex].colorEnd, life01);
+    vsOut.size         = mix(emitters[emitterIndex].sizeStart, emitters[emitterIndex].sizeEnd, life01);
+    vsOut.atlasRect    = vec4(vec2(slot % atlasGrid.x, slot / atlasGrid.x) * cellSize, cellSize);
 }
@@ -0,0 +1,147 @@
+#version 430 core
+
+// Une invocation par particule à créer, tous émetteurs confondus. Chaque
+// émetteur reçoit une plage [spawnOffset, spawnOffset + spawnCount) calculée
+// sur le CPU. Les indices libres sont dépilés de la liste des mortes et
+// ajoutés à la liste des vivantes courante.
+// Voir particlesUpdate.cs.glsl pour la disposition des données.
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) writeonly restrict buffer PositionTtlBlock
+{
+    vec4 positionTtl[];
+};
+
+layout(std430, binding = 1) writeonly restrict buffer VelocityRotationBlock
+{
+    uvec2 velocityRotation[];
+};
+
+layout(std430, binding = 2) writeonly restrict buffer ColdBlock
+{
+    uint cold[];
+};
+
+layout(std430, binding = 3) readonly restrict buffer DeadListBlock
+{
+    uint deadList[];
+};
+
+layout(std430, binding = 4) writeonly restrict buffer AliveListBlock
+{
+    uint aliveList[];
+};
+
+// Même disposition que ParticleCounters côté C++.
+layout(std430, binding = 6) restrict buffer ParticleCountersBlock
+{
+    int deadCount;
+    uint aliveCount[2];
+    uint padding0;
+    uint updateGroupsX, updateGroupsY, updateGroupsZ;
+    uint padding1;
+    uint pointsCount, pointsInstanceCount, pointsFirst, pointsBaseInstance;
+    uint quadsCount, quadsInstanceCount, quadsFirst, quadsBaseInstance;
+    uint sortGroupsX, sortGroupsY, sortGroupsZ;
+    uint sortSize;
+};
+
+// Même disposition que ParticleSystem::EmitterData côté C++.
+struct Emitter
+{
+    mat4 transform;
+    vec4 colorStart;
+    vec4 colorEnd;
+    vec3 velocity;
+    float velocitySpread;
+    vec2 sizeStart;
+    vec2 sizeEnd;
+    vec2 lifetime;
+    uint atlasSlot;
+    uint spawnOffset;
+    uint spawnCount;
+};
+
+layout(std430, binding = 7) readonly restrict buffer EmitterBlock
+{
+    Emitter emitters[];
+};
+
+uniform uint spawnCount;
+uniform uint emitterCount;
+uniform uint currentList;
+uniform float time;
+
+// Hachage entier plutôt que fract(sin(...)): le sinus du GPU n'est pas exact
+// pour de grands arguments, alors que ces opérations donnent les mêmes bits
+// que ParticleSimulator sur le CPU.
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float rand01(float seed)
+{
+    uint h = hash(floatBitsToUint(time) ^ hash(gl_GlobalInvocationID.x * 4u + uint(seed)));
+    return float(h >> 8) * (1.0 / 16777216.0);
+}
+
+// Dernier émetteur dont la plage commence avant index. Les émetteurs sans
+// particule cette trame partagent le début de plage du suivant.
+uint findEmitter(uint index)
+{
+    uint low = 0u;
+    uint high = emitterCount - 1u;
+    while (low < high)
+    {
+        uint mid = (low + high + 1u) / 2u;
+        if (emitters[mid].spawnOffset <= index)
+            low = mid;
+        else
+            high = mid - 1u;
+    }
+    return low;
+}
+
+uint packCold(float maxTimeToLive, uint emitterIndex)
+{
+    return (packHalf2x16(vec2(maxTimeToLive, 0.0)) & 0xFFFFu) | (emitterIndex << 16);
+}
+
+void main()
+{
+    if (gl_GlobalInvocationID.x >= spawnCount)
+        return;
+
+    int slot = atomicAdd(deadCount, -1) - 1;
+    if (slot < 0)
+    {
+        // Plus aucune particule libre.
+        atomicAdd(deadCount, 1);
+        return;
+    }
+    uint id = deadList[slot];
+
+    uint emitterIndex = findEmitter(gl_GlobalInvocationID.x);
+    mat4 transform = emitters[emitterIndex].transform;
+
+    float r = rand01(0.0);
+    vec3 jitter = vec3(rand01(1.0), rand01(2.0), rand01(3.0)) * 2.0 - 1.0;
+
+    vec3 velocity = mat3(transform) * emitters[emitterIndex].velocity
+        + jitter * emitters[emitterIndex].velocitySpread;
+    float zOrientation = r * 6.2831853;
+    vec2 lifetime = emitters[emitterIndex].lifetime;
+    float maxTimeToLive = mix(lifetime.x, lifetime.y, r);
+
+    positionTtl[id] = vec4(transform[3].xyz, maxTimeToLive);
+    velocityRotation[id] = uvec2(packHalf2x16(velocity.xy), packHalf2x16(vec2(velocity.z, zOrientation)));
+    cold[id] = packCold(maxTimeToLive, emitterIndex);
+
+    aliveList[atomicAdd(aliveCount[currentList], 1u)] = id;
+}
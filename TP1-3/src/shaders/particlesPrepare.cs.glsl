@@ -0,0 +1,64 @@
+#version 430 core
+
+// Prépare les commandes indirectes à partir des compteurs, sans lecture côté CPU.
+// stage 0: avant la mise à jour, une invocation par particule vivante.
+// stage 1: après la mise à jour, dessin et tri des particules survivantes.
+layout(local_size_x = 1) in;
+
+// Même disposition que ParticleCounters côté C++.
+layout(std430, binding = 6) restrict buffer ParticleCountersBlock
+{
+    int deadCount;
+    uint aliveCount[2];
+    uint padding0;
+    uint updateGroupsX, updateGroupsY, updateGroupsZ;
+    uint padding1;
+    uint pointsCount, pointsInstanceCount, pointsFirst, pointsBaseInstance;
+    uint quadsCount, quadsInstanceCount, quadsFirst, quadsBaseInstance;
+    uint sortGroupsX, sortGroupsY, sortGroupsZ;
+    uint sortSize;
+};
+
+uniform uint stage;
+uniform uint currentList;
+
+// Doit correspondre à local_size_x de particlesUpdate.cs.glsl.
+const uint UPDATE_GROUP_SIZE = 256u;
+
+// Éléments par groupe dans particlesSort.cs.glsl.
+const uint SORT_BLOCK_SIZE = 512u;
+
+void main()
+{
+    uint nextList = 1u - currentList;
+
+    if (stage == 0u)
+    {
+        updateGroupsX = (aliveCount[currentList] + UPDATE_GROUP_SIZE - 1u) / UPDATE_GROUP_SIZE;
+        updateGroupsY = 1u;
+        updateGroupsZ = 1u;
+        aliveCount[nextList] = 0u;
+    }
+    else
+    {
+        uint nAlive = aliveCount[nextList];
+
+        pointsCount = nAlive;
+        pointsInstanceCount = 1u;
+        pointsFirst = 0u;
+        pointsBaseInstance = 0u;
+
+        quadsCount = 4u;
+        quadsInstanceCount = nAlive;
+        quadsFirst = 0u;
+        quadsBaseInstance = 0u;
+
+        // Le tri bitonique travaille sur la puissance de 2 suivante.
+        sortSize = nAlive > 1u ? 1u << (findMSB(nAlive - 1u) + 1) : 1u;
+        sortGroupsX = (sortSize + SORT_BLOCK_SIZE - 1u) / SORT_BLOCK_SIZE;
+        sortGroupsY = 1u;
+        sortGroupsZ = 1u;
+
+        aliveCount[currentList] = 0u;
+    }
+}
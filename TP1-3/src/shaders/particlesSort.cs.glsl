@@ -0,0 +1,165 @@
+#version 430 core
+
+// Tri bitonique des particules vivantes par profondeur de vue, de la plus
+// éloignée à la plus proche, pour un mélange alpha correct.
+// Clé = z de vue (croissant = arrière vers avant), valeur = indice de particule.
+// Le tableau est complété jusqu'à sortSize (puissance de 2) avec des clés +inf.
+// Chaque invocation traite une paire d'éléments; un groupe couvre 512 éléments.
+//
+// stage 0: génère les paires (clé, indice) depuis la liste des vivantes.
+// stage 1: trie chaque bloc de 512 en mémoire partagée (k <= 512).
+// stage 2: une étape globale (k, j) avec j >= 512.
+// stage 3: termine l'étape k en mémoire partagée (j <= 256).
+// stage 4: réécrit la liste des vivantes dans l'ordre trié.
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) readonly restrict buffer PositionTtlBlock
+{
+    vec4 positionTtl[];
+};
+
+layout(std430, binding = 4) restrict buffer AliveListBlock
+{
+    uint aliveList[];
+};
+
+// Même disposition que ParticleCounters côté C++.
+layout(std430, binding = 6) readonly restrict buffer ParticleCountersBlock
+{
+    int deadCount;
+    uint aliveCount[2];
+    uint padding0;
+    uint updateGroupsX, updateGroupsY, updateGroupsZ;
+    uint padding1;
+    uint pointsCount, pointsInstanceCount, pointsFirst, pointsBaseInstance;
+    uint quadsCount, quadsInstanceCount, quadsFirst, quadsBaseInstance;
+    uint sortGroupsX, sortGroupsY, sortGroupsZ;
+    uint sortSize;
+};
+
+// x = bits de la clé flottante, y = indice de particule.
+layout(std430, binding = 8) restrict buffer SortBlock
+{
+    uvec2 entries[];
+};
+
+uniform uint stage;
+uniform uint currentList;
+uniform uint k;
+uniform uint j;
+uniform mat4 view;
+
+const uint BLOCK_SIZE = 512u;
+const uint PADDING_KEY = 0x7F800000u; // +inf
+
+shared uvec2 block[BLOCK_SIZE];
+
+void compareAndSwap(inout uvec2 a, inout uvec2 b, bool ascending)
+{
+    if ((uintBitsToFloat(a.x) > uintBitsToFloat(b.x)) == ascending)
+    {
+        uvec2 tmp = a;
+        a = b;
+        b = tmp;
+    }
+}
+
+// Indices de la paire traitée par l'invocation t pour une distance j.
+uvec2 pairIndices(uint t, uint distance)
+{
+    uint i = 2u * distance * (t / distance) + t % distance;
+    return uvec2(i, i + distance);
+}
+
+void loadBlock(uint base, uint t)
+{
+    for (uint e = t; e < BLOCK_SIZE; e += gl_WorkGroupSize.x)
+        block[e] = base + e < sortSize ? entries[base + e] : uvec2(PADDING_KEY, 0u);
+    barrier();
+}
+
+void storeBlock(uint base, uint t)
+{
+    barrier();
+    for (uint e = t; e < BLOCK_SIZE; e += gl_WorkGroupSize.x)
+    {
+        if (base + e < sortSize)
+            entries[base + e] = block[e];
+    }
+}
+
+void mergeBlock(uint base, uint t, uint size, uint distance)
+{
+    for (; distance > 0u; distance >>= 1)
+    {
+        uvec2 pair = pairIndices(t, distance);
+        bool ascending = ((base + pair.x) & size) == 0u;
+        uvec2 a = block[pair.x];
+        uvec2 b = block[pair.y];
+        compareAndSwap(a, b, ascending);
+        block[pair.x] = a;
+        block[pair.y] = b;
+        barrier();
+    }
+}
+
+void main()
+{
+    uint t = gl_LocalInvocationID.x;
+    uint base = gl_WorkGroupID.x * BLOCK_SIZE;
+    uint nAlive = aliveCount[currentList];
+
+    if (stage == 0u)
+    {
+        for (uint e = 2u * gl_GlobalInvocationID.x; e < 2u * gl_GlobalInvocationID.x + 2u; e++)
+        {
+            if (e < nAlive)
+            {
+                uint id = aliveList[e];
+                float depth = dot(vec4(view[0][2], view[1][2], view[2][2], view[3][2]), vec4(positionTtl[id].xyz, 1.0));
+                entries[e] = uvec2(floatBitsToUint(depth), id);
+            }
+            else if (e < sortSize)
+            {
+                entries[e] = uvec2(PADDING_KEY, 0u);
+            }
+        }
+    }
+    else if (stage == 1u)
+    {
+        loadBlock(base, t);
+        for (uint size = 2u; size <= BLOCK_SIZE; size <<= 1)
+            mergeBlock(base, t, size, size / 2u);
+        storeBlock(base, t);
+    }
+    else if (stage == 2u)
+    {
+        // Les étapes au-delà de la taille à trier ne changent rien.
+        if (k > sortSize || gl_GlobalInvocationID.x >= sortSize / 2u)
+            return;
+
+        uvec2 pair = pairIndices(gl_GlobalInvocationID.x, j);
+        uvec2 a = entries[pair.x];
+        uvec2 b = entries[pair.y];
+        compareAndSwap(a, b, (pair.x & k) == 0u);
+        entries[pair.x] = a;
+        entries[pair.y] = b;
+    }
+    else if (stage == 3u)
+    {
+        if (k > sortSize)
+            return;
+
+        loadBlock(base, t);
+        mergeBlock(base, t, k, BLOCK_SIZE / 2u);
+        storeBlock(base, t);
+    }
+    else
+    {
+        for (uint e = 2u * gl_GlobalInvocationID.x; e < 2u * gl_GlobalInvocationID.x + 2u; e++)
+        {
+            if (e < nAlive)
+                aliveList[e] = entries[e].y;
+        }
+    }
+}
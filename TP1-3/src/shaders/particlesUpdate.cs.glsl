@@ -1,74 +1,87 @@
 #version 430 core
 
-layout(local_size_x = 1) in;
-
-struct Particle
+// Une invocation par particule vivante (dispatch indirect préparé par
+// particlesPrepare.cs.glsl). Les particules sont mises à jour sur place; les
+// survivantes sont ajoutées à la prochaine liste des vivantes et les autres
+// retournent dans la liste des mortes.
+//
+// Données en SoA std430:
+//   0 positionTtl      vec4   16 o  chaud: position, w = timeToLive
+//   1 velocityRotation uvec2   8 o  chaud: half(vx, vy), half(vz, zOrientation initiale)
+//   2 cold             uint    4 o  froid: half maxTimeToLive | indice d'émetteur << 16
+// La couleur, la taille et l'orientation ne dépendent que de la vie écoulée et
+// des courbes de l'émetteur; elles sont évaluées au dessin plutôt que stockées.
+//
+// Octets par particule vivante et par trame:
+//   mise à jour: 4 (liste) + 16 + 8 lus, 16 + 4 (liste) écrits = 48
+//   dessin:      4 (liste) + 16 + 4 lus                        = 24
+// contre 64 lus + 64 écrits (+ 64 au dessin) avec l'ancienne structure std140.
+//
+// Autres liaisons: 3 liste des mortes, 4 liste des vivantes courante,
+// 5 prochaine liste des vivantes, 6 compteurs, 7 table des émetteurs.
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) restrict buffer PositionTtlBlock
 {
-    vec3 position;
-    float zOrientation;
-    vec3 velocity;
-    vec4 color;
-    vec2 size;
-    float timeToLive;
-    float maxTimeToLive;
+    vec4 positionTtl[];
 };
 
-layout(std140, binding = 0) readonly restrict buffer ParticlesInputBlock
+layout(std430, binding = 1) readonly restrict buffer VelocityRotationBlock
 {
-    Particle particles[];
-} dataIn;
+    uvec2 velocityRotation[];
+};
 
-layout(std140, binding = 1) writeonly restrict buffer ParticlesOutputBlock
+layout(std430, binding = 3) writeonly restrict buffer DeadListBlock
 {
-    Particle particles[];
-} dataOut;
+    uint deadList[];
+};
 
-uniform float time;
-uniform float deltaTime;
-uniform vec3 emitterPosition;
-uniform vec3 emitterDirection;
+layout(std430, binding = 4) readonly restrict buffer AliveListInputBlock
+{
+    uint aliveIn[];
+};
 
-float rand01()
+layout(std430, binding = 5) writeonly restrict buffer AliveListOutputBlock
 {
-    return fract(sin(dot(vec2(time*100, gl_GlobalInvocationID.x), vec2(12.9898, 78.233))) * 43758.5453);
-}
+    uint aliveOut[];
+};
 
-void main()
+// Même disposition que ParticleCounters côté C++.
+layout(std430, binding = 6) restrict buffer ParticleCountersBlock
 {
-    uint id = gl_GlobalInvocationID.x;
+    int deadCount;
+    uint aliveCount[2];
+    uint padding0;
+    uint updateGroupsX, updateGroupsY, updateGroupsZ;
+    uint padding1;
+    uint pointsCount, pointsInstanceCount, pointsFirst, pointsBaseInstance;
+    uint quadsCount, quadsInstanceCount, quadsFirst, quadsBaseInstance;
+    uint sortGroupsX, sortGroupsY, sortGroupsZ;
+    uint sortSize;
+};
 
-    Particle p = dataIn.particles[id];
+uniform float deltaTime;
+uniform uint currentList;
 
-    if (p.timeToLive <= 0.0)
-    {
-        float r = rand01();
+void main()
+{
+    if (gl_GlobalInvocationID.x >= aliveCount[currentList])
+        return;
 
-        p.position = emitterPosition;
-        p.zOrientation = r * 6.2831853;
-        p.velocity = emitterDirection * 0.3 + vec3(0, 0.2, 0);
-        p.color = vec4(0.5, 0.5, 0.5, 0.2);
-        p.size = vec2(0.2, 0.2);
+    uint id = aliveIn[gl_GlobalInvocationID.x];
+    vec4 p = positionTtl[id];
 
-        p.maxTimeToLive = 1.5 + r * 0.5;
-        p.timeToLive = p.maxTimeToLive;
+    float timeToLive = p.w - deltaTime;
 
-        dataOut.particles[id] = p;
+    if (timeToLive <= 0.0)
+    {
+        deadList[atomicAdd(deadCount, 1)] = id;
         return;
     }
 
-    p.timeToLive -= deltaTime;
-
-   float life01 = 1 - (p.timeToLive / p.maxTimeToLive);
-
-    p.position += p.velocity * deltaTime;
-    p.zOrientation += 0.5 * deltaTime;
-
-    p.color.rgb = mix(vec3(1.0), vec3(0.5), life01);
-
-    float s = smoothstep(0.0, 1.0, life01);
-
-    p.size = mix(vec2(0.5), vec2(0.2), life01);
-
-    dataOut.particles[id] = p;
+    uvec2 packedVelocity = velocityRotation[id];
+    vec3 velocity = vec3(unpackHalf2x16(packedVelocity.x), unpackHalf2x16(packedVelocity.y).x);
 
+    positionTtl[id] = vec4(p.xyz + velocity * deltaTime, timeToLive);
+    aliveOut[atomicAdd(aliveCount[1u - currentList], 1u)] = id;
 }
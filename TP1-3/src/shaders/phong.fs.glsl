@@ -1,6 +1,7 @@
 #version 330 core
 
-#define MAX_SPOT_LIGHTS 8
+// Doit correspondre à la taille de lightsData_.spotLights côté C++.
+#define MAX_SPOT_LIGHTS 16
 #define MAX_POINT_LIGHTS 4
 
 in ATTRIBS_VS_OUT
@@ -8,16 +9,8 @@ in ATTRIBS_VS_OUT
     vec2 texCoords;
     vec3 normal;
     vec3 color;
-} attribsIn;
-
-in LIGHTS_VS_OUT
-{
     vec3 obsPos;
-    vec3 dirLightDir;
-    
-    vec3 spotLightsDir[MAX_SPOT_LIGHTS];
-    vec3 spotLightsSpotDir[MAX_SPOT_LIGHTS];
-} lightsIn;
+} attribsIn;
 
 
 struct Material
@@ -50,6 +43,8 @@ struct SpotLight
     float openingAngle;
 };
 
+uniform mat4 view;
+
 uniform int nSpotLights;
 
 uniform vec3 globalAmbient;
@@ -73,7 +68,10 @@ out vec4 FragColor;
 float computeSpot(in float openingAngle, in float exponent, in vec3 spotDir, in vec3 lightDir, in vec3 normal)
 {
     float spotFactor = 0.0;
-    
+    float cosGamma = dot(-lightDir, spotDir);
+    float cosDelta = cos(radians(openingAngle));
+    if (cosGamma > cosDelta && dot(normal, lightDir) > 0.0)
+        spotFactor = pow(cosGamma, exponent);
     return spotFactor;
 }
 
@@ -89,10 +87,28 @@ void main()
 
         
     // Spot light
+    // Les vecteurs sont dérivés ici des données du LightingBlock plutôt que
+    // d'être interpolés depuis le nuanceur de sommets.
+    vec3 n = normalize(attribsIn.normal);
+    vec3 obsDir = normalize(-attribsIn.obsPos);
     
-    for(int i = 0; i < nSpotLights; i++)
+    for(int i = 0; i < min(nSpotLights, MAX_SPOT_LIGHTS); i++)
     {
-       
+        vec3 lightPos = (view * vec4(spotLights[i].position, 1.0)).xyz;
+        vec3 lightDir = normalize(lightPos - attribsIn.obsPos);
+        vec3 spotDir = normalize(mat3(view) * spotLights[i].direction);
+        
+        ambient += spotLights[i].ambient * mat.ambient;
+        
+        float spotFactor = computeSpot(spotLights[i].openingAngle, spotLights[i].exponent, spotDir, lightDir, n);
+        if (spotFactor <= 0.0)
+            continue;
+        
+        float NdotL = max(dot(n, lightDir), 0.0);
+        float NdotH = max(dot(n, normalize(lightDir + obsDir)), 0.0);
+        
+        diffuse += spotFactor * NdotL * spotLights[i].diffuse * mat.diffuse;
+        specular += spotFactor * pow(NdotH, mat.shininess) * spotLights[i].specular * mat.specular;
     }
 
     
@@ -5,73 +5,22 @@ layout (location = 1) in vec3 color;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec2 texCoords;
 
-#define MAX_SPOT_LIGHTS 8
-#define MAX_POINT_LIGHTS 4
-
+// Seules la position et la normale (repère de la caméra) sont interpolées.
+// Les vecteurs vers les lumières sont calculés dans le nuanceur de fragments
+// à partir du LightingBlock, le nombre de lumières n'influence donc pas le
+// nombre de varyings.
 out ATTRIBS_VS_OUT
 {
     vec2 texCoords;
     vec3 normal;
     vec3 color;
-} attribsOut;
-
-out LIGHTS_VS_OUT
-{
     vec3 obsPos;
-    vec3 dirLightDir;
-    
-    vec3 spotLightsDir[MAX_SPOT_LIGHTS];
-    vec3 spotLightsSpotDir[MAX_SPOT_LIGHTS];
-} lightsOut;
+} attribsOut;
 
 uniform mat4 mvp;
-uniform mat4 view;
 uniform mat4 modelView;
 uniform mat3 normalMatrix;
 
-struct Material
-{
-    vec3 emission;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float shininess;
-};
-
-struct DirectionalLight
-{
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    
-    vec3 direction;
-};
-
-struct SpotLight
-{
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    
-    vec3 position;
-    vec3 direction;
-    float exponent;
-    float openingAngle;
-};
-
-uniform int nSpotLights;
-
-layout (std140) uniform MaterialBlock
-{
-    Material mat;
-};
-
-layout (std140) uniform LightingBlock
-{
-    DirectionalLight dirLight;
-    SpotLight spotLights[MAX_SPOT_LIGHTS];
-};
-
 void main()
 {
     // Attribs
@@ -84,12 +33,8 @@ void main()
         n = vec3(0.0, 1.0, 0.0); // si normale nulle, vers le haut
     attribsOut.normal = normalize(n);
 
-
-    // Lights
     vec4 posView = modelView * vec4(position, 1.0);
-    lightsOut.obsPos = posView.xyz;
-
-    lightsOut.dirLightDir = normalize(mat3(view) * (-dirLight.direction));
+    attribsOut.obsPos = posView.xyz;
     
     gl_Position = mvp * vec4(position, 1.0);
 }
@@ -5,6 +5,8 @@
 
 #include <iostream>
 
+#include <inf2705/gl_debug.hpp>
+
 Texture2D::Texture2D()
 : m_id(0)
 {
@@ -22,6 +24,7 @@ void Texture2D::load(const char* path)
 
     glGenTextures(1, &m_id);
     glBindTexture(GL_TEXTURE_2D, m_id);
+    GLDebug::label(GL_TEXTURE, m_id, path);
     GLenum format;
     if (nChannels == 3) {
         format = GL_RGB;
@@ -78,6 +81,11 @@ void Texture2D::use()
     glBindTexture(GL_TEXTURE_2D, m_id);
 }
 
+GLuint Texture2D::getID() const
+{
+    return m_id;
+}
+
 //
 // Cubemap
 //
@@ -20,6 +20,8 @@ public:
 
 	void use();
 
+	GLuint getID() const;
+
 private:
 	GLuint m_id;
 };
@@ -1,5 +1,7 @@
 #include "uniform_buffer.hpp"
 
+#include <inf2705/gl_debug.hpp>
+
 UniformBuffer::UniformBuffer()
 {
 }
@@ -17,6 +19,11 @@ void UniformBuffer::allocate(const void* data, GLsizeiptr byteSize)
     glBufferData(GL_UNIFORM_BUFFER, byteSize, data, GL_DYNAMIC_DRAW);
 }
 
+void UniformBuffer::setLabel(const char* label)
+{
+    GLDebug::label(GL_BUFFER, id_, label);
+}
+
 void UniformBuffer::setBindingIndex(GLuint index)
 {
     glBindBufferBase(GL_UNIFORM_BUFFER, index, id_);
@@ -12,6 +12,8 @@ public:
     ~UniformBuffer();
     
     void allocate(const void* data, GLsizeiptr byteSize);
+    // Nom affiché par les outils de débogage, après allocate().
+    void setLabel(const char* label);
     
     void setBindingIndex(GLuint index);
 
@@ -4,9 +4,15 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
 //#include <format>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <memory>
@@ -16,6 +22,7 @@
 #include <chrono>
 #include <unordered_map>
 #include <thread>
+#include <vector>
 
 #ifdef _WIN32
 	#include <Windows.h>
@@ -31,8 +38,18 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_opengl3.h>
 
+#include <inf2705/allocation_counter.hpp>
+#include <inf2705/benchmark.hpp>
+#include <inf2705/frame_arena.hpp>
+#include <inf2705/frame_capture.hpp>
+#include <inf2705/gl_debug.hpp>
+#include <inf2705/input_recorder.hpp>
+#include <inf2705/job_system.hpp>
+#include <inf2705/profiler.hpp>
 #include <inf2705/sfml_utils.hpp>
+#include <inf2705/triple_buffer.hpp>
 #include <inf2705/utils.hpp>
+#include <inf2705/window.hpp>
 
 
 using namespace gl;
@@ -43,6 +60,43 @@ struct WindowSettings
 	sf::VideoMode videoMode = sf::VideoMode({600, 600});
 	int fps = 30;
 	sf::ContextSettings context = sf::ContextSettings(24, 8);
+
+	// Pas de temps de fixedUpdate(). Au-delà de maxFixedStepsPerFrame pas dans une trame, le retard est abandonné
+	// plutôt que rattrapé, pour qu'une trame lente ne rende pas les suivantes encore plus lentes.
+	float fixedDeltaTime = 1.0f / 60.0f;
+	int maxFixedStepsPerFrame = 8;
+	// Rendu sans limite de FPS ni synchronisation verticale (--uncapped), la simulation restant à pas fixe.
+	bool uncapped = false;
+	// simulate() tourne sur son propre fil (--sim-thread) et publie des instantanés que le rendu consomme.
+	// Ignoré en mode sans affichage, où les pas doivent suivre le temps simulé des trames pour être reproductibles.
+	bool simulationThread = false;
+
+	// Mode sans affichage (--headless) : rendu dans un FBO de la taille de videoMode, nombre de trames fixe
+	// avec un pas de temps simulé fixe (0 = 1/fps). Modifiable par --frames N, --size LxH et --dt secondes.
+	// --record chemin enregistre chaque trame dans un fichier .y4m ou un dossier d'images PNG.
+	bool headless = false;
+	int headlessFrameCount = 300;
+	float headlessDeltaTime = 0.0f;
+
+	// Rapport des erreurs OpenGL par KHR_debug (--gl-debug off|async|sync). Synchrone en débogage, asynchrone en
+	// release. Le mode synchrone demande un contexte de débogage.
+	GLDebugMode glDebugMode = DEFAULT_GL_DEBUG_MODE;
+
+	// Banc d'essai (--benchmark fichier|configurations) : chaque configuration de stress est mesurée sur
+	// benchmarkFrames trames (--bench-frames) après benchmarkWarmupFrames trames de réchauffement (--bench-warmup),
+	// avec le pas de temps simulé fixe du mode sans affichage. Le rapport JSON va dans --bench-out.
+	// --stress « clé=valeur ... » applique une seule configuration sans mesurer.
+	int benchmarkFrames = 600;
+	int benchmarkWarmupFrames = 60;
+	std::string benchmarkOutput = "benchmark.json";
+
+	// Journal des entrées (--record-input fichier) et rejeu exact (--replay-input fichier), voir InputRecorder.
+	// Les deux utilisent le pas de temps simulé fixe du mode sans affichage, sans fil de simulation ni imgui.ini.
+	// Le rejeu reprend la taille de fenêtre du journal et tourne sans limite de FPS. --frame-times fichier écrit le
+	// temps réel de chaque trame (sans affichage ou rejeu) pour comparer deux versions trame par trame.
+	std::string recordInputPath;
+	std::string replayInputPath;
+	std::string frameTimesPath;
 };
 
 // Classe de base pour les application OpenGL. Fait pour nous la création de fenêtre et la gestion des événements.
@@ -59,24 +113,68 @@ public:
 		argv_ = argv;
 
 		settings_ = settings;
+		parseCommandLineArguments();
+		if (not settings_.replayInputPath.empty() and inputRecorder_.startReplay(settings_.replayInputPath)) {
+			const InputRecorder::Header& header = inputRecorder_.getHeader();
+			settings_.videoMode.size = {header.width, header.height};
+			settings_.headlessDeltaTime = header.deltaTime;
+			settings_.uncapped = true;
+		}
+		if (settings_.glDebugMode == GLDebugMode::Synchronous)
+			settings_.context.attributeFlags |= sf::ContextSettings::Attribute::Debug;
 
 		// Créer la fenêtre et afficher les infos du contexte OpenGL.
-		createWindowAndContext(title);
+		if (not createWindowAndContext(title))
+			return;
+		GLDebug::enable(settings_.glDebugMode);
 		printGLInfo();
 		std::cout << std::endl;
 
+		if (not settings_.recordInputPath.empty() and not inputRecorder_.isReplaying()) {
+			auto size = window_.getSize();
+			uint32_t seed = (uint32_t)std::time(nullptr);
+			inputRecorder_.startRecording(settings_.recordInputPath, { size.x, size.y, getFixedFrameDeltaTime(), seed });
+		}
+		if (inputRecorder_.isActive()) {
+			// Même disposition des fenêtres ImGui d'une exécution à l'autre, pour que les clics tombent aux mêmes endroits.
+			ImGui::GetIO().IniFilename = nullptr;
+			std::srand(inputRecorder_.getHeader().seed);
+		}
+
+		steadyStartTime_ = std::chrono::steady_clock::now();
 		init(); // À surcharger
 
+		// Le banc d'essai demande des trames reproductibles : pas de fil de simulation, pas de temps fixe.
+		if (not benchmarkSource_.empty() and benchmark_.load(benchmarkSource_)) {
+			benchmark_.warmupFrames = settings_.benchmarkWarmupFrames;
+			benchmark_.measuredFrames = settings_.benchmarkFrames;
+			benchmark_.start();
+			stressConfig_ = benchmark_.getCurrentConfig();
+		}
+		if (not stressConfig_.isEmpty())
+			applyStressConfig(stressConfig_); // À surcharger
+
+		if (settings_.simulationThread and not settings_.headless and not benchmark_.isActive() and not inputRecorder_.isActive())
+			simulationThread_ = std::jthread([this](std::stop_token stopToken) { runSimulationThread(stopToken); });
+
+		if (not recordingPath_.empty())
+			startRecording(recordingPath_);
+
 		// Commencer le chronomètre qui mesure le temps des trames. C'est des fois plus pratique d'avoir le temps depuis la dernière trame que le numéro de trame.
 		startTime_ = std::chrono::system_clock::now();
 		lastFrameTime_ = std::chrono::high_resolution_clock::now();
 		deltaTime_ = 1.0f / settings_.fps;
 
 		// État initial de la souris avant la première trame.
-		currentMouseState_ = lastMouseState_ = getMouseState(window_);
+		if (not settings_.headless and not inputRecorder_.isReplaying())
+			currentMouseState_ = lastMouseState_ = getMouseState(window_);
 
 		// Compteur de trames effectuées.
 		frame_ = 0;
+		if (settings_.headless)
+			headlessFrameTimes_.reserve(settings_.headlessFrameCount + 1);
+		if (inputRecorder_.isReplaying())
+			headlessFrameTimes_.reserve(1 << 16);
 
 		printKeybinds();
 		
@@ -87,14 +185,38 @@ public:
 
 		// Tant que la fenêtre est ouverte (mis à jour dans la gestion d'événements) :
 		while (window_.isOpen()) {			
-			drawFrame(); // À surcharger
-			
-			ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			beginFrameMemory();
+			Profiler::get().beginFrame(frame_);
+			{
+				PROFILE_SCOPE("Fixed Update");
+				runFixedUpdates();
+			}
+			{
+				PROFILE_SCOPE("Draw");
+				drawFrame(); // À surcharger
+			}
+
+			Profiler::get().drawImGui();
+			JobSystem::get().drawImGui();
+			drawMemoryImGui();
+			{
+				PROFILE_SCOPE("ImGui");
+				ImGui::Render();
+				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+			}
+			{
+				PROFILE_SCOPE("Capture");
+				frameCapture_.endFrame(window_.getSize(), window_.getBackBuffer());
+			}
 
 			// SFML fait le rafraîchissement de la fenêtre ainsi que le contrôle du framerate pour nous.
 			// La fonction display fait le buffer swap (comme glutSwapBuffers) et attend à la prochaine trame selon le FPS qu'on a spécifié avec setFramerateLimit.
-			window_.display();
+			{
+				PROFILE_SCOPE("Display");
+				window_.display();
+			}
+			// La gestion d'événements peut fermer la fenêtre et son contexte, donc hors des mesures.
+			Profiler::get().endFrame();
             
             handleEvents();
 			updateDeltaTime();
@@ -102,13 +224,37 @@ public:
             ImGui::NewFrame();
 
 			frame_++;
+
+			if (benchmark_.isActive() and window_.isOpen()) {
+				advanceBenchmark();
+			} else if (settings_.headless and frame_ >= settings_.headlessFrameCount) {
+				glFinish();
+				onClose(); // À surcharger
+				finishCaptures();
+				window_.close();
+			}
+		}
+		// Arrêter le fil avant que l'application dérivée (qui possède l'état simulé) ne soit détruite.
+		if (simulationThread_.joinable()) {
+			simulationThread_.request_stop();
+			simulationThread_.join();
 		}
+
+		// Si la fenêtre a été fermée directement (sans événement Closed), le contexte n'existe plus.
+		frameCapture_.finish();
+
+		bool wasReplaying = inputRecorder_.isReplaying();
+		inputRecorder_.finish();
+		if (settings_.headless or wasReplaying)
+			printHeadlessStats(wasReplaying ? "Replay" : "Headless");
+		if (not settings_.frameTimesPath.empty())
+			writeFrameTimes(settings_.frameTimesPath);
 		
 		ImGui_ImplOpenGL3_Shutdown();
         ImGui::DestroyContext();
 	}
 
-	const sf::Window& getWindow() const { return window_; }
+	const ApplicationWindow& getWindow() const { return window_; }
 
 	// État de la souris (mis à jour une fois par trame avant la gestion d'événements).
 	const MouseState& getMouse() const {
@@ -125,6 +271,77 @@ public:
 		return deltaTime_;
 	}
 
+	// Pas de temps de fixedUpdate().
+	float getFixedDeltaTime() const {
+		return settings_.fixedDeltaTime;
+	}
+
+	// Temps simulé, somme des pas fixes effectués.
+	double getSimulationTime() const {
+		return simulationTime_;
+	}
+
+	// Fraction du prochain pas fixe déjà écoulée, dans [0, 1[. Sert à interpoler entre les deux derniers états simulés au rendu.
+	float getInterpolationAlpha() const {
+		return interpolationAlpha_;
+	}
+
+	// Même chose pour un instantané publié par simulate() au temps publishTime (getElapsedTime()). Avec le fil de
+	// simulation, les pas ne sont pas alignés sur les trames : la fraction vient de l'horloge.
+	float getInterpolationAlpha(double publishTime) const {
+		if (not isSimulationThreaded())
+			return interpolationAlpha_;
+		float alpha = float((getElapsedTime() - publishTime) / settings_.fixedDeltaTime);
+		return std::clamp(alpha, 0.0f, 1.0f);
+	}
+
+	bool isSimulationThreaded() const {
+		return simulationThread_.joinable();
+	}
+
+	// Secondes écoulées depuis init() selon une horloge monotone. Peut être appelée depuis le fil de simulation.
+	double getElapsedTime() const {
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - steadyStartTime_).count();
+	}
+
+	// À utiliser au lieu de sf::Keyboard::isKeyPressed() et window_.hasFocus() pour que l'état interrogé soit
+	// enregistré avec --record-input et rejoué avec --replay-input.
+	bool isKeyPressed(sf::Keyboard::Key key) {
+		if (inputRecorder_.isReplaying())
+			return inputRecorder_.isKeyPressed(key);
+		bool isPressed = sf::Keyboard::isKeyPressed(key);
+		if (inputRecorder_.isRecording())
+			isPressed = inputRecorder_.recordKey(key, isPressed);
+		return isPressed;
+	}
+
+	bool hasFocus() const {
+		return inputRecorder_.isActive() ? hasFocus_ : window_.hasFocus();
+	}
+
+	bool isReplayingInput() const {
+		return inputRecorder_.isReplaying();
+	}
+
+	// Configuration de stress appliquée (vide si ni --stress ni --benchmark).
+	const StressConfig& getStressConfig() const {
+		return stressConfig_;
+	}
+
+	bool isBenchmarking() const {
+		return benchmark_.isActive();
+	}
+
+	// Avancement du trajet de caméra scripté du banc d'essai, dans [0, 1].
+	float getBenchmarkProgress() const {
+		return benchmark_.getProgress();
+	}
+
+	// Mémoire des données temporaires de la trame courante, libérée au début de la suivante. Fil de rendu seulement.
+	FrameArena& getFrameArena() {
+		return frameArena_;
+	}
+
 	// Ratio des dimensions de la fenêtre (x/y).
 	float getWindowAspect() const {
 		auto windowSize = window_.getSize();
@@ -170,9 +387,15 @@ public:
 		printf("SFML Context   %i.%i\n", sfmlSettings.majorVersion, sfmlSettings.minorVersion);
 		printf("Depth bits     %i\n", sfmlSettings.depthBits);
 		printf("Stencil bits   %i\n", sfmlSettings.stencilBits);
+		const char* debugModes[] = { "off", "asynchronous", "synchronous" };
+		printf("Debug output   %s\n", debugModes[(int)GLDebug::mode]);
 	}
 
 	sf::Image captureCurrentFrame(GLenum buffer = GL_FRONT) {
+		// Sans affichage, il n'y a pas de tampon avant : la trame est dans le FBO.
+		if (buffer == GL_FRONT)
+			buffer = window_.getFrontBuffer();
+
 		// Les dimensions de la fenêtre.
 		auto windowSize = window_.getSize();
 		size_t numPixels = windowSize.x * windowSize.y;
@@ -195,15 +418,13 @@ public:
 		return img;
 	}
 
+	// La capture est faite à la fin de la trame courante et l'image est écrite en arrière-plan (voir FrameCapture).
 	std::string saveScreenshot(const std::string& folder = "screenshots", const std::string& filename = "") {
 		using namespace std::filesystem;
 
 		path trimmedFilename = trim(filename);
 		path trimmedFolder = trim(folder);
 
-		// Capturer la trame actuelle.
-		sf::Image frameImage = captureCurrentFrame();
-
 		// Si le dossier cible n'existe pas, le créer.
 		if (not trimmedFolder.empty())
 			create_directory(trimmedFolder);
@@ -220,27 +441,47 @@ public:
 			path execName = path(execFilename).stem();
 			std::stringstream ss;
 			std::string outputName = (trimmedFolder / execName).make_preferred().string();
-			ss << outputName << "_" << dateTimeStr << "_" << frameNumber;
+			ss << outputName << "_" << dateTimeStr << "_" << frameNumber << ".png";
 			filePathStr = ss.str();
 		}
 
-		// Faire l'écriture dans le fichier dans un fil parallèle pour moins ralentir le fil principal avec une écriture sur le disque. La capture (avec glReadPixels) doit être faite dans le fil principal, mais l'écriture sur le disque peut être faite en parallèle sans causer de problème de synchronisation. On remarque la capture par copie.
-		std::thread savingThread([=]() {
-			bool ok = frameImage.saveToFile(filePathStr);
-			if (not ok)
-			    std::cerr << "Could not write image to disk" << "\n";
-		});
-		// Détacher le fil pour qu'il se gère tout seul, donc pas besoin de join() ou de garder la variable vivante.
-		savingThread.detach();
-
+		frameCapture_.requestScreenshot(filePathStr);
 		return filePathStr;
 	}
 
+	// Enregistre chaque trame jusqu'à stopRecording() : un fichier .y4m, sinon un dossier d'images PNG.
+	void startRecording(const std::string& path) {
+		bool isY4m = std::filesystem::path(path).extension() == ".y4m";
+		int fps = settings_.headless and settings_.headlessDeltaTime > 0.0f ? (int)std::lround(1.0f / settings_.headlessDeltaTime) : settings_.fps;
+		frameCapture_.startRecording(path, isY4m ? FrameCapture::Format::Y4m : FrameCapture::Format::Png, fps);
+	}
+
+	void stopRecording() {
+		frameCapture_.stopRecording();
+	}
+
+	bool isRecording() const {
+		return frameCapture_.isRecording();
+	}
+
 	// Les méthodes virtuelles suivantes sont à surcharger.
 
 	// Appelée avant la première trame.
 	virtual void init() { }
 
+	// Appelée après init() avec --stress, puis au début de chaque configuration du banc d'essai. Les clés absentes
+	// de config remettent la valeur par défaut de l'application.
+	virtual void applyStressConfig(const StressConfig& config) { }
+
+	// Avance l'état purement CPU d'un pas fixe et le publie (voir TripleBuffer). Aucun appel OpenGL, ImGui ni
+	// PROFILE_SCOPE : avec settings.simulationThread, elle tourne sur son propre fil, en parallèle de drawFrame().
+	// Sinon, elle est appelée juste avant chaque fixedUpdate().
+	virtual void simulate(float fixedDeltaTime) { }
+
+	// Appelée zéro, une ou plusieurs fois avant chaque trame avec un pas de temps constant. La simulation qui doit être
+	// indépendante du FPS va ici, le rendu dans drawFrame() avec getInterpolationAlpha().
+	virtual void fixedUpdate(float fixedDeltaTime) { }
+
 	// Appelée à chaque trame. Le buffer swap est fait juste après.
 	virtual void drawFrame() { }
 
@@ -274,50 +515,79 @@ public:
 protected:
 	void handleEvents() {
 		lastMouseState_ = currentMouseState_;
-		currentMouseState_ = getMouseState(window_);
 		ImGuiIO& io = ImGui::GetIO();
 
+		// Les événements de la trame viennent de la fenêtre, ou du journal en rejeu.
+		frameEvents_.clear();
+		if (inputRecorder_.isReplaying()) {
+			// Les événements réels sont vidés sans être traités, sauf la fermeture qui interrompt le rejeu.
+			bool isClosing = false;
+			while (auto event = window_.pollEvent())
+				isClosing = isClosing or event->is<sf::Event::Closed>();
+			bool isLogFinished = not inputRecorder_.readFrame(frameEvents_);
+			bool hasClosedEvent = std::any_of(frameEvents_.begin(), frameEvents_.end(), [](const sf::Event& e) { return e.is<sf::Event::Closed>(); });
+			if ((isLogFinished or isClosing) and not hasClosedEvent)
+				frameEvents_.push_back(sf::Event::Closed{});
+			currentMouseState_ = inputRecorder_.getMouse();
+			hasFocus_ = inputRecorder_.hasFocus();
+			// L'état initial de la souris n'est pas enregistré : pas de déplacement à la première trame.
+			if (frame_ == 0)
+				lastMouseState_ = currentMouseState_;
+		} else {
+			if (not settings_.headless)
+				currentMouseState_ = getMouseState(window_);
+			while (auto event = window_.pollEvent())
+				frameEvents_.push_back(*event);
+			if (inputRecorder_.isRecording()) {
+				hasFocus_ = window_.hasFocus();
+				inputRecorder_.beginRecordedFrame(currentMouseState_, hasFocus_);
+				for (const sf::Event& event : frameEvents_)
+					inputRecorder_.recordEvent(event);
+			}
+		}
+
 		// Traiter les événements survenus depuis la dernière trame.
-		while (auto event = window_.pollEvent()) {
+		for (const sf::Event& event : frameEvents_) {
 			// N'importe quel événement.
-			onEvent(*event); // À surcharger
+			onEvent(event); // À surcharger
 
 			// L'utilisateur a voulu fermer la fenêtre (le X de la fenêtre, Alt+F4 sur Windows, etc.).
-			if (event->is<sf::Event::Closed>()) {
+			if (event.is<sf::Event::Closed>()) {
 				glFinish();
 				onClose(); // À surcharger
+				finishCaptures();
 				glFinish();
 				window_.close();
 			// Redimensionnement de la fenêtre.
-			} else if (auto* e = event->getIf<sf::Event::Resized>()) {
+			} else if (auto* e = event.getIf<sf::Event::Resized>()) {
 				glViewport(0, 0, e->size.x, e->size.y);
                 io.DisplaySize.x = e->size.x;
                 io.DisplaySize.y = e->size.y;
 				onResize(*e); // À surcharger
 				lastResize_ = *e;
 			// Touche appuyée.
-			} else if (auto* e = event->getIf<sf::Event::KeyPressed>()) {
+			} else if (auto* e = event.getIf<sf::Event::KeyPressed>()) {
 				onKeyPress(*e); // À surcharger
 			// Touche relâchée.
-			} else if (auto* e = event->getIf<sf::Event::KeyReleased>()) {
+			} else if (auto* e = event.getIf<sf::Event::KeyReleased>()) {
 				onKeyRelease(*e); // À surcharger
 			// Bouton appuyé.
-			} else if (auto* e = event->getIf<sf::Event::MouseButtonPressed>()) {
+			} else if (auto* e = event.getIf<sf::Event::MouseButtonPressed>()) {
 			    io.AddMouseButtonEvent((int)e->button, true);
 				onMouseButtonPress(*e); // À surcharger
 			// Bouton relâché.
-			} else if (auto* e = event->getIf<sf::Event::MouseButtonReleased>()) {
+			} else if (auto* e = event.getIf<sf::Event::MouseButtonReleased>()) {
 			    io.AddMouseButtonEvent((int)e->button, false);
 				onMouseButtonRelease(*e); // À surcharger
 			// Souris bougée.
-			} else if (auto* e = event->getIf<sf::Event::MouseMoved>()) {
+			} else if (auto* e = event.getIf<sf::Event::MouseMoved>()) {
 			    io.AddMousePosEvent(e->position.x, e->position.y);
 				onMouseMove({{
 					e->position.x - lastMouseState_.relative.x,
 					e->position.y - lastMouseState_.relative.y
 				}});
 			// Souris défilée
-			} else if (auto* e = event->getIf<sf::Event::MouseWheelScrolled>()) {
+			} else if (auto* e = event.getIf<sf::Event::MouseWheelScrolled>()) {
 			    if (e->wheel == sf::Mouse::Wheel::Vertical)
     				io.AddMouseWheelEvent(0, e->delta);
 				else
@@ -327,13 +597,22 @@ protected:
 		}
 	}
 
-	void createWindowAndContext(std::string_view title) {
+	bool createWindowAndContext(std::string_view title) {
 		#ifdef _WIN32
 			// Juste pour s'assurer d'avoir le codepage UTF-8 sur Windows avec Visual Studio.
 			SetConsoleOutputCP(65001);
 			SetConsoleCP(65001);
 		#endif
 
+		if (settings_.headless) {
+			// La liaison de glbinding est faite par createHeadless avec eglGetProcAddress.
+			if (not window_.createHeadless(settings_.videoMode.size, settings_.context))
+				return false;
+			lastResize_ = {{window_.getSize().x, window_.getSize().y}};
+			initImGui();
+			return true;
+		}
+
 		window_.create(
 			settings_.videoMode, // Dimensions de fenêtre.
 			sfStr(title), // Titre.
@@ -341,7 +620,9 @@ protected:
 			sf::State::Windowed,
 			settings_.context
 		);
-		window_.setFramerateLimit(settings_.fps);
+		window_.setFramerateLimit(settings_.uncapped ? 0 : settings_.fps);
+		if (settings_.uncapped)
+			window_.setVerticalSyncEnabled(false);
 		bool ok = window_.setActive(true);
 		if (not ok)
 			std::cerr << "Could not activate created window" << "\n";
@@ -350,6 +631,11 @@ protected:
 		// On peut donner une « GetProcAddress » venant d'une autre librairie à glbinding.
 		// Si on met nullptr, glbinding se débrouille avec sa propre implémentation.
 		glbinding::Binding::initialize(nullptr);
+		initImGui();
+		return true;
+	}
+
+	void initImGui() {
 		ImGui::CreateContext();
         ImGui_ImplOpenGL3_Init();
 		// Cette étape semble nécessaire sur Windows.
@@ -361,17 +647,217 @@ protected:
 		using namespace std::chrono;
 		auto t = high_resolution_clock::now();
 		duration<float> dt = t - lastFrameTime_;
-		deltaTime_ = dt.count();
 		lastFrameTime_ = t;
+		realDeltaTime_ = dt.count();
+		if (settings_.headless or benchmark_.isActive() or inputRecorder_.isActive()) {
+			// Pas de temps simulé fixe pour des trames reproductibles, le temps réel ne sert qu'aux statistiques.
+			if (settings_.headless or inputRecorder_.isReplaying())
+				headlessFrameTimes_.push_back(dt.count());
+			deltaTime_ = getFixedFrameDeltaTime();
+		} else {
+			deltaTime_ = dt.count();
+		}
 		ImGui::GetIO().DeltaTime = deltaTime_;
 	}
 
-	sf::RenderWindow window_;
+	// Pas de temps simulé des trames sans affichage, du banc d'essai et du journal des entrées.
+	float getFixedFrameDeltaTime() const {
+		return settings_.headlessDeltaTime > 0.0f ? settings_.headlessDeltaTime : 1.0f / settings_.fps;
+	}
+
+	void runFixedUpdates() {
+		float step = settings_.fixedDeltaTime;
+		fixedTimeAccumulator_ += deltaTime_;
+		float maxAccumulated = step * settings_.maxFixedStepsPerFrame;
+		if (fixedTimeAccumulator_ > maxAccumulated)
+			fixedTimeAccumulator_ = maxAccumulated;
+
+		while (fixedTimeAccumulator_ >= step) {
+			if (not isSimulationThreaded())
+				simulate(step); // À surcharger
+			fixedUpdate(step); // À surcharger
+			simulationTime_ += step;
+			fixedTimeAccumulator_ -= step;
+		}
+		interpolationAlpha_ = fixedTimeAccumulator_ / step;
+	}
+
+	// Boucle du fil de simulation : un pas toutes les fixedDeltaTime secondes. Comme dans runFixedUpdates(), un retard
+	// de plus de maxFixedStepsPerFrame pas est abandonné plutôt que rattrapé.
+	void runSimulationThread(std::stop_token stopToken) {
+		using namespace std::chrono;
+		float step = settings_.fixedDeltaTime;
+		auto stepDuration = duration_cast<steady_clock::duration>(duration<float>(step));
+		auto maxDelay = stepDuration * settings_.maxFixedStepsPerFrame;
+		auto nextStep = steady_clock::now();
+		while (not stopToken.stop_requested()) {
+			simulate(step); // À surcharger
+			nextStep += stepDuration;
+			auto now = steady_clock::now();
+			if (now - nextStep > maxDelay)
+				nextStep = now;
+			std::this_thread::sleep_until(nextStep);
+		}
+	}
+
+	// Libère l'arène de la trame précédente et note les allocations qu'elle a faites sur le tas.
+	void beginFrameMemory() {
+		uint64_t count = AllocationCounter::getCount();
+		uint64_t threadCount = AllocationCounter::getThreadCount();
+		lastFrameAllocations_ = count - frameStartAllocations_;
+		lastFrameThreadAllocations_ = threadCount - frameStartThreadAllocations_;
+		frameStartAllocations_ = count;
+		frameStartThreadAllocations_ = threadCount;
+		frameArena_.reset();
+	}
+
+	void drawMemoryImGui() {
+		if (not ImGui::Begin("Profiler")) {
+			ImGui::End();
+			return;
+		}
+		if (ImGui::CollapsingHeader("Memory")) {
+			if (AllocationCounter::isEnabled()) {
+				// Les allocations restantes sont à chasser : l'objectif est zéro en régime permanent.
+				ImVec4 color = lastFrameAllocations_ == 0 ? ImVec4(0.5f, 1.0f, 0.5f, 1.0f) : ImVec4(1.0f, 0.6f, 0.3f, 1.0f);
+				ImGui::TextColored(color, "Heap allocations: %llu per frame (%llu on render thread)",
+					(unsigned long long)lastFrameAllocations_, (unsigned long long)lastFrameThreadAllocations_);
+			} else {
+				ImGui::TextDisabled("Heap allocations: counter not compiled in");
+			}
+			ImGui::Text("Frame arena: %.1f / %.1f KiB, peak %.1f KiB, %d block(s)",
+				frameArena_.getLastFrameBytes() / 1024.0f, frameArena_.getCapacity() / 1024.0f,
+				frameArena_.getHighWater() / 1024.0f, frameArena_.getBlockCount());
+		}
+		ImGui::End();
+	}
+
+	// Fin de trame du banc d'essai : passe à la configuration suivante ou écrit le rapport et ferme.
+	void advanceBenchmark() {
+		Benchmark::FrameSample sample = { realDeltaTime_ * 1000.0f, AllocationCounter::getCount(), frameArena_.getUsedBytes() };
+		switch (benchmark_.endFrame(frame_ - 1, sample)) {
+		case Benchmark::Event::NextConfig:
+			stressConfig_ = benchmark_.getCurrentConfig();
+			applyStressConfig(stressConfig_); // À surcharger
+			break;
+		case Benchmark::Event::Finished:
+			benchmark_.printSummary();
+			benchmark_.writeJson(settings_.benchmarkOutput, reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+			                     window_.getSize().x, window_.getSize().y);
+			glFinish();
+			onClose(); // À surcharger
+			finishCaptures();
+			window_.close();
+			break;
+		case Benchmark::Event::None:
+			break;
+		}
+	}
+
+	// Termine les captures en cours tant que le contexte OpenGL existe encore.
+	void finishCaptures() {
+		frameCapture_.flush();
+		frameCapture_.stopRecording();
+	}
+
+	void parseCommandLineArguments() {
+		for (int i = 1; i < argc_; i++) {
+			std::string_view arg = argv_[i];
+			bool hasValue = i + 1 < argc_;
+			if (arg == "--headless") {
+				settings_.headless = true;
+			} else if (arg == "--uncapped") {
+				settings_.uncapped = true;
+			} else if (arg == "--sim-thread") {
+				settings_.simulationThread = true;
+			} else if (arg == "--gl-debug" and hasValue) {
+				std::string_view value = argv_[++i];
+				if (value == "off")
+					settings_.glDebugMode = GLDebugMode::Off;
+				else if (value == "async")
+					settings_.glDebugMode = GLDebugMode::Asynchronous;
+				else if (value == "sync")
+					settings_.glDebugMode = GLDebugMode::Synchronous;
+			} else if (arg == "--benchmark" and hasValue) {
+				benchmarkSource_ = argv_[++i];
+				// Mesurer ce que la machine peut faire, pas la limite de FPS.
+				settings_.uncapped = true;
+			} else if (arg == "--bench-out" and hasValue) {
+				settings_.benchmarkOutput = argv_[++i];
+			} else if (arg == "--bench-frames" and hasValue) {
+				settings_.benchmarkFrames = std::max(1, std::atoi(argv_[++i]));
+			} else if (arg == "--bench-warmup" and hasValue) {
+				settings_.benchmarkWarmupFrames = std::max(0, std::atoi(argv_[++i]));
+			} else if (arg == "--stress" and hasValue) {
+				if (auto config = StressConfig::parse(argv_[++i]))
+					stressConfig_ = *config;
+			} else if (arg == "--record-input" and hasValue) {
+				settings_.recordInputPath = argv_[++i];
+			} else if (arg == "--replay-input" and hasValue) {
+				settings_.replayInputPath = argv_[++i];
+			} else if (arg == "--frame-times" and hasValue) {
+				settings_.frameTimesPath = argv_[++i];
+			} else if (arg == "--frames" and hasValue) {
+				settings_.headlessFrameCount = std::max(1, std::atoi(argv_[++i]));
+			} else if (arg == "--dt" and hasValue) {
+				settings_.headlessDeltaTime = (float)std::atof(argv_[++i]);
+			} else if (arg == "--record" and hasValue) {
+				recordingPath_ = argv_[++i];
+			} else if (arg == "--size" and hasValue) {
+				unsigned int width = 0, height = 0;
+				if (std::sscanf(argv_[++i], "%ux%u", &width, &height) == 2 and width > 0 and height > 0)
+					settings_.videoMode.size = {width, height};
+			}
+		}
+	}
+
+	// Une ligne par trame, dans l'ordre : deux rejeux du même journal se comparent ligne à ligne.
+	bool writeFrameTimes(const std::string& filename) const {
+		std::ofstream file(filename);
+		if (not file) {
+			std::cerr << "Could not write frame times to \"" << filename << "\"" << "\n";
+			return false;
+		}
+		file << "frame,ms\n";
+		// Le premier intervalle couvre l'initialisation, pas une trame.
+		for (size_t i = 1; i < headlessFrameTimes_.size(); i++)
+			file << i - 1 << "," << headlessFrameTimes_[i] * 1000.0f << "\n";
+		std::cout << "Frame times written to \"" << filename << "\"" << std::endl;
+		return true;
+	}
+
+	// Temps réels des trames (CPU et GPU, display() attend le GPU en mode sans affichage).
+	void printHeadlessStats(const char* label) const {
+		// Le premier intervalle couvre l'initialisation, pas une trame.
+		std::vector<float> times(headlessFrameTimes_.begin() + std::min<size_t>(1, headlessFrameTimes_.size()), headlessFrameTimes_.end());
+		if (times.empty())
+			return;
+
+		double total = 0.0;
+		for (float t : times)
+			total += t;
+		std::sort(times.begin(), times.end());
+		auto percentile = [&](float p) { return times[std::min(times.size() - 1, size_t(times.size() * p))] * 1000.0f; };
+
+		auto size = window_.getSize();
+		printf("%-15s%i frames, %ux%u, dt %.4f s\n", label, (int)times.size(), size.x, size.y, deltaTime_);
+		printf("Total          %.3f s (%.1f fps)\n", total, times.size() / total);
+		printf("Frame ms       avg %.3f  min %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+		       total * 1000.0 / times.size(), times.front() * 1000.0f, percentile(0.5f), percentile(0.95f), percentile(0.99f), times.back() * 1000.0f);
+	}
+
+	ApplicationWindow window_;
 	sf::Event::Resized lastResize_ = {};
 	int frame_ = 0;
 	float deltaTime_ = 0.0f;
+	float realDeltaTime_ = 0.0f;
+	float fixedTimeAccumulator_ = 0.0f;
+	float interpolationAlpha_ = 0.0f;
+	double simulationTime_ = 0.0;
 	std::chrono::system_clock::time_point startTime_;
 	std::chrono::high_resolution_clock::time_point lastFrameTime_;
+	std::chrono::steady_clock::time_point steadyStartTime_;
+	std::jthread simulationThread_;
 	MouseState lastMouseState_ = {};
 	MouseState currentMouseState_ = {};
 
@@ -379,6 +865,23 @@ protected:
 	char** argv_ = nullptr;
 	WindowSettings settings_;
 	std::string keybindMessage_;
+	std::vector<float> headlessFrameTimes_;
+	FrameCapture frameCapture_;
+	std::string recordingPath_;
+
+	InputRecorder inputRecorder_;
+	std::vector<sf::Event> frameEvents_;
+	bool hasFocus_ = false;
+
+	Benchmark benchmark_;
+	std::string benchmarkSource_;
+	StressConfig stressConfig_;
+
+	FrameArena frameArena_;
+	uint64_t frameStartAllocations_ = 0;
+	uint64_t frameStartThreadAllocations_ = 0;
+	uint64_t lastFrameAllocations_ = 0;
+	uint64_t lastFrameThreadAllocations_ = 0;
 };
 
 
@@ -413,3 +916,12 @@ inline void printGLError(std::string_view sourceFile = "", int sourceLine = -1)
 	}
 }
 
+
+// Vérification ponctuelle avec glGetError, qui force un aller-retour avec le pilote. En débogage seulement, et
+// seulement si la couche KHR_debug n'est pas active (elle rapporte déjà les erreurs à l'appel fautif).
+// Ne génère aucun code en release.
+#ifdef NDEBUG
+	#define CHECK_GL_ERROR ((void)0)
+#else
+	#define CHECK_GL_ERROR (GLDebug::isActive() ? (void)0 : printGLError(__FILE__, __LINE__))
+#endif
@@ -0,0 +1,402 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <psapi.h>
+#else
+	#include <unistd.h>
+#endif
+
+#include <inf2705/profiler.hpp>
+
+
+// Paramètres d'une scène de stress : un nom et des valeurs clé=valeur que l'application interprète dans
+// applyStressConfig(). Les clés absentes gardent la valeur par défaut de l'application.
+struct StressConfig
+{
+	std::string name = "default";
+	std::vector<std::pair<std::string, float>> values;
+
+	bool isEmpty() const {
+		return values.empty();
+	}
+
+	float get(std::string_view key, float defaultValue) const {
+		for (auto& [k, v] : values)
+			if (k == key)
+				return v;
+		return defaultValue;
+	}
+
+	int getInt(std::string_view key, int defaultValue) const {
+		return (int)std::lround(get(key, (float)defaultValue));
+	}
+
+	// « nom clé=valeur clé=valeur ». Le nom est optionnel, les virgules valent des espaces.
+	static std::optional<StressConfig> parse(std::string_view text) {
+		std::string line(text);
+		std::replace(line.begin(), line.end(), ',', ' ');
+		std::istringstream tokens(line);
+
+		StressConfig config;
+		bool hasName = false;
+		std::string token;
+		while (tokens >> token) {
+			size_t equal = token.find('=');
+			if (equal == std::string::npos) {
+				config.name = token;
+				hasName = true;
+				continue;
+			}
+			char* end = nullptr;
+			std::string value = token.substr(equal + 1);
+			float number = std::strtof(value.c_str(), &end);
+			if (end == value.c_str()) {
+				std::cerr << "Invalid stress value \"" << token << "\"" << "\n";
+				continue;
+			}
+			config.values.emplace_back(token.substr(0, equal), number);
+		}
+		if (not hasName and config.values.empty())
+			return std::nullopt;
+		if (not hasName)
+			config.name = line.substr(line.find_first_not_of(" \t"));
+		return config;
+	}
+};
+
+
+// Mode banc d'essai (--benchmark) : chaque configuration de stress est appliquée à tour de rôle, réchauffée,
+// mesurée sur un nombre fixe de trames pendant que l'application suit un trajet de caméra scripté, puis résumée.
+// Les temps par passe viennent du Profiler (CPU et GPU), la mémoire du compteur d'allocations, de l'arène de trame
+// et de la mémoire résidente du processus. Le tout est écrit en JSON à la fin.
+class Benchmark
+{
+public:
+	enum class Event
+	{
+		None,
+		// La configuration courante a changé : l'application doit l'appliquer.
+		NextConfig,
+		// Toutes les configurations sont mesurées.
+		Finished,
+	};
+
+	// Ce que l'application mesure à la fin d'une trame.
+	struct FrameSample
+	{
+		float realFrameMs = 0.0f;
+		uint64_t allocationCount = 0;
+		size_t arenaBytes = 0;
+	};
+
+	int warmupFrames = 60;
+	int measuredFrames = 600;
+
+	// Un fichier (une configuration par ligne, # pour les commentaires) ou, si le fichier n'existe pas, des
+	// configurations séparées par des points-virgules.
+	bool load(const std::string& source) {
+		configs_.clear();
+		std::ifstream file(source);
+		std::string line;
+		if (file) {
+			while (std::getline(file, line))
+				addLine(line);
+		} else {
+			std::istringstream inline_(source);
+			while (std::getline(inline_, line, ';'))
+				addLine(line);
+		}
+		if (configs_.empty()) {
+			std::cerr << "No benchmark configuration in \"" << source << "\"" << "\n";
+			return false;
+		}
+		return true;
+	}
+
+	bool isActive() const {
+		return isRunning_;
+	}
+
+	void start() {
+		if (configs_.empty())
+			return;
+		isRunning_ = true;
+		currentConfig_ = 0;
+		beginConfig();
+		Profiler::get().isEnabled = true;
+		Profiler::get().listener = [this](const char* name, int depth, int frame, float cpuMs, float gpuMs) {
+			onScope(name, depth, frame, cpuMs, gpuMs);
+		};
+	}
+
+	const StressConfig& getCurrentConfig() const {
+		return configs_[currentConfig_];
+	}
+
+	int getConfigCount() const {
+		return (int)configs_.size();
+	}
+
+	// Avancement du trajet de caméra dans [0, 1] : 0 pendant le réchauffement, 1 une fois la mesure finie.
+	float getProgress() const {
+		return std::clamp(float(configFrame_ - warmupFrames) / std::max(measuredFrames, 1), 0.0f, 1.0f);
+	}
+
+	// Appelée après chaque trame complétée, frame étant son numéro.
+	Event endFrame(int frame, const FrameSample& sample) {
+		if (not isRunning_)
+			return Event::None;
+
+		uint64_t allocations = sample.allocationCount - lastAllocationCount_;
+		lastAllocationCount_ = sample.allocationCount;
+
+		if (configFrame_ == warmupFrames)
+			measureStartFrame_ = frame;
+		if (configFrame_ >= warmupFrames and configFrame_ < warmupFrames + measuredFrames) {
+			ConfigResult& result = results_.back();
+			result.frameMs.push_back(sample.realFrameMs);
+			result.allocations += allocations;
+			result.arenaPeakBytes = std::max(result.arenaPeakBytes, sample.arenaBytes);
+		}
+		configFrame_++;
+
+		// Les requêtes GPU sont lues quelques trames plus tard : on attend qu'elles soient toutes revenues.
+		if (configFrame_ < warmupFrames + measuredFrames + Profiler::N_FRAMES_IN_FLIGHT)
+			return Event::None;
+
+		finishConfig();
+		if (++currentConfig_ < (int)configs_.size()) {
+			beginConfig();
+			return Event::NextConfig;
+		}
+		isRunning_ = false;
+		Profiler::get().listener = nullptr;
+		return Event::Finished;
+	}
+
+	bool writeJson(const std::string& filename, std::string_view renderer, unsigned int width, unsigned int height) const {
+		std::ofstream file(filename);
+		if (not file) {
+			std::cerr << "Could not write benchmark to \"" << filename << "\"" << "\n";
+			return false;
+		}
+
+		file << "{\n";
+		file << "  \"renderer\": \"" << escape(renderer) << "\",\n";
+		file << "  \"resolution\": [" << width << ", " << height << "],\n";
+		file << "  \"warmup_frames\": " << warmupFrames << ",\n";
+		file << "  \"measured_frames\": " << measuredFrames << ",\n";
+		file << "  \"configurations\": [\n";
+		for (size_t i = 0; i < results_.size(); i++) {
+			const ConfigResult& result = results_[i];
+			Stats frame = Stats::of(result.frameMs);
+			Stats cpu = Stats::of(result.cpuMs);
+			Stats gpu = Stats::of(result.gpuMs);
+			size_t nFrames = std::max<size_t>(result.frameMs.size(), 1);
+
+			file << "    {\n";
+			file << "      \"name\": \"" << escape(result.config.name) << "\",\n";
+			file << "      \"parameters\": {";
+			for (size_t j = 0; j < result.config.values.size(); j++)
+				file << (j ? ", " : " ") << "\"" << escape(result.config.values[j].first) << "\": " << result.config.values[j].second;
+			file << (result.config.values.empty() ? "},\n" : " },\n");
+			file << "      \"frame_ms\": " << frame.toJson() << ",\n";
+			file << "      \"cpu_ms\": " << cpu.toJson() << ",\n";
+			file << "      \"gpu_ms\": " << gpu.toJson() << ",\n";
+			file << "      \"bound\": \"" << (gpu.p50 > cpu.p50 ? "gpu" : "cpu") << "\",\n";
+			file << "      \"memory\": { \"heap_allocations_per_frame\": " << double(result.allocations) / nFrames
+			     << ", \"frame_arena_peak_bytes\": " << result.arenaPeakBytes
+			     << ", \"resident_bytes\": " << result.residentBytes << " },\n";
+			file << "      \"passes\": [\n";
+			for (size_t j = 0; j < result.passes.size(); j++) {
+				const PassSamples& pass = result.passes[j];
+				file << "        { \"name\": \"" << escape(pass.name) << "\", \"depth\": " << pass.depth
+				     << ", \"cpu_ms\": " << Stats::of(pass.cpuMs).toJson()
+				     << ", \"gpu_ms\": " << Stats::of(pass.gpuMs).toJson() << " }"
+				     << (j + 1 < result.passes.size() ? ",\n" : "\n");
+			}
+			file << "      ]\n";
+			file << "    }" << (i + 1 < results_.size() ? ",\n" : "\n");
+		}
+		file << "  ]\n";
+		file << "}\n";
+
+		std::cout << "Benchmark written to \"" << filename << "\"" << std::endl;
+		return true;
+	}
+
+	// Résumé d'une ligne par configuration, pour la console.
+	void printSummary() const {
+		for (const ConfigResult& result : results_) {
+			Stats frame = Stats::of(result.frameMs);
+			Stats cpu = Stats::of(result.cpuMs);
+			Stats gpu = Stats::of(result.gpuMs);
+			printf("%-24s frame p50 %7.3f p99 %7.3f  cpu p50 %7.3f  gpu p50 %7.3f ms\n",
+			       result.config.name.c_str(), frame.p50, frame.p99, cpu.p50, gpu.p50);
+		}
+	}
+
+	// Mémoire résidente du processus, 0 si inconnue.
+	static size_t getResidentBytes() {
+	#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.WorkingSetSize;
+		return 0;
+	#else
+		std::ifstream statm("/proc/self/statm");
+		size_t totalPages = 0, residentPages = 0;
+		if (statm >> totalPages >> residentPages)
+			return residentPages * (size_t)sysconf(_SC_PAGESIZE);
+		return 0;
+	#endif
+	}
+
+private:
+	struct Stats
+	{
+		float average = 0.0f;
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+
+		static Stats of(std::vector<float> values) {
+			Stats stats;
+			if (values.empty())
+				return stats;
+			std::sort(values.begin(), values.end());
+			auto percentile = [&](float p) { return values[std::min(values.size() - 1, size_t(values.size() * p))]; };
+			for (float value : values)
+				stats.average += value;
+			stats.average /= values.size();
+			stats.p50 = percentile(0.5f);
+			stats.p95 = percentile(0.95f);
+			stats.p99 = percentile(0.99f);
+			stats.max = values.back();
+			return stats;
+		}
+
+		std::string toJson() const {
+			char buffer[160];
+			snprintf(buffer, sizeof(buffer), "{ \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+			         average, p50, p95, p99, max);
+			return buffer;
+		}
+	};
+
+	struct PassSamples
+	{
+		std::string name;
+		int depth = 0;
+		std::vector<float> cpuMs;
+		std::vector<float> gpuMs;
+	};
+
+	struct ConfigResult
+	{
+		StressConfig config;
+		std::vector<float> frameMs;
+		// Par trame mesurée : somme des passes de premier niveau. Le CPU exclut Display, qui attend le GPU.
+		std::vector<float> cpuMs;
+		std::vector<float> gpuMs;
+		std::vector<PassSamples> passes;
+		uint64_t allocations = 0;
+		size_t arenaPeakBytes = 0;
+		size_t residentBytes = 0;
+	};
+
+	void addLine(std::string_view line) {
+		size_t comment = line.find('#');
+		if (auto config = StressConfig::parse(line.substr(0, comment)))
+			configs_.push_back(*config);
+	}
+
+	void beginConfig() {
+		configFrame_ = 0;
+		measureStartFrame_ = -1;
+		results_.emplace_back();
+		ConfigResult& result = results_.back();
+		result.config = configs_[currentConfig_];
+		result.frameMs.reserve(measuredFrames);
+		result.cpuMs.assign(measuredFrames, 0.0f);
+		result.gpuMs.assign(measuredFrames, 0.0f);
+		std::cout << "Benchmark " << currentConfig_ + 1 << "/" << configs_.size() << ": " << result.config.name << std::endl;
+	}
+
+	void finishConfig() {
+		ConfigResult& result = results_.back();
+		result.residentBytes = getResidentBytes();
+		// Les trames dont les requêtes GPU n'étaient pas prêtes (abandonnées par le Profiler) n'ont pas de temps par passe.
+		size_t nResolved = 0;
+		for (size_t i = 0; i < result.cpuMs.size(); i++) {
+			if (result.cpuMs[i] == 0.0f and result.gpuMs[i] == 0.0f)
+				continue;
+			result.cpuMs[nResolved] = result.cpuMs[i];
+			result.gpuMs[nResolved] = result.gpuMs[i];
+			nResolved++;
+		}
+		result.cpuMs.resize(nResolved);
+		result.gpuMs.resize(nResolved);
+	}
+
+	void onScope(const char* name, int depth, int frame, float cpuMs, float gpuMs) {
+		ConfigResult& result = results_.back();
+		int index = frame - measureStartFrame_;
+		if (measureStartFrame_ < 0 or index < 0 or index >= measuredFrames)
+			return;
+
+		auto it = std::find_if(result.passes.begin(), result.passes.end(), [&](const PassSamples& pass) {
+			return pass.depth == depth and pass.name == name;
+		});
+		if (it == result.passes.end()) {
+			result.passes.push_back({ name, depth, {}, {} });
+			it = result.passes.end() - 1;
+		}
+		it->cpuMs.push_back(cpuMs);
+		it->gpuMs.push_back(gpuMs);
+
+		if (depth == 0) {
+			if (std::string_view(name) != "Display")
+				result.cpuMs[index] += cpuMs;
+			result.gpuMs[index] += gpuMs;
+		}
+	}
+
+	static std::string escape(std::string_view text) {
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' or c == '\\')
+				escaped += '\\';
+			if ((unsigned char)c >= 0x20)
+				escaped += c;
+		}
+		return escaped;
+	}
+
+	std::vector<StressConfig> configs_;
+	std::vector<ConfigResult> results_;
+	int currentConfig_ = 0;
+	int configFrame_ = 0;
+	int measureStartFrame_ = -1;
+	uint64_t lastAllocationCount_ = 0;
+	bool isRunning_ = false;
+};
@@ -0,0 +1,403 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glbinding/gl/gl.h>
+#include <SFML/Graphics.hpp>
+
+#include <inf2705/gl_debug.hpp>
+
+
+using namespace gl;
+
+
+// Capture asynchrone des trames. glReadPixels écrit dans un anneau de pixel buffer objects (PBO) protégés par
+// des fences, et les données sont récupérées deux ou trois trames plus tard quand le GPU a terminé. L'encodage
+// (PNG, ou Y4M pour une séquence) se fait dans un bassin borné de fils. Si l'encodage prend du retard, le fil
+// de rendu attend qu'un tampon se libère (contre-pression) plutôt que d'accumuler des trames en mémoire.
+class FrameCapture
+{
+public:
+	enum class Format { Png, Y4m };
+
+	static constexpr int N_PIXEL_BUFFERS = 3;
+
+	struct Statistics
+	{
+		int framesCaptured = 0;
+		int framesEncoded = 0;
+		// Nombre d'attentes du fil de rendu (PBO pas prêt ou bassin plein).
+		int stalls = 0;
+		// Temps passé dans endFrame() par le fil de rendu à la dernière trame.
+		float lastEndFrameMs = 0.0f;
+	};
+
+	explicit FrameCapture(unsigned int nThreads = 0) {
+		if (nThreads == 0)
+			nThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+		nThreads_ = nThreads;
+		maxBuffers_ = nThreads * 2;
+	}
+
+	~FrameCapture() {
+		finish();
+		{
+			std::lock_guard lock(mutex_);
+			isStopping_ = true;
+		}
+		jobsReady_.notify_all();
+		for (auto& thread : workers_)
+			thread.join();
+	}
+
+	// Capture la trame courante à la fin de celle-ci vers un PNG.
+	void requestScreenshot(const std::string& path) {
+		screenshotPaths_.push_back(path);
+	}
+
+	// path est un fichier .y4m (Format::Y4m) ou un dossier qui recevra une image PNG par trame.
+	void startRecording(const std::string& path, Format format, int fps) {
+		stopRecording();
+		recordingPath_ = path;
+		recordingFormat_ = format;
+		recordingFps_ = fps;
+		recordingSequence_ = 0;
+		nextWrittenSequence_ = 0;
+		y4mSize_ = {};
+		if (format == Format::Y4m) {
+			y4mFile_.open(path, std::ios::binary);
+			if (not y4mFile_) {
+				std::cerr << "Could not open \"" << path << "\" for recording" << "\n";
+				return;
+			}
+		} else {
+			std::filesystem::create_directories(path);
+		}
+		isRecording_ = true;
+	}
+
+	// Attend que les trames enregistrées soient lues et encodées. Le contexte OpenGL doit être actif.
+	void stopRecording() {
+		if (not isRecording_)
+			return;
+		isRecording_ = false;
+		flush();
+		y4mFile_.close();
+	}
+
+	bool isRecording() const { return isRecording_; }
+
+	Statistics getStatistics() const {
+		std::lock_guard lock(mutex_);
+		return statistics_;
+	}
+
+	// Appelée à la fin de chaque trame, avant l'échange des tampons. readBuffer est le tampon où la trame a été dessinée.
+	void endFrame(sf::Vector2u size, GLenum readBuffer) {
+		auto start = std::chrono::steady_clock::now();
+
+		retireCompleted(false);
+
+		while (not screenshotPaths_.empty()) {
+			readFrame(size, readBuffer, Format::Png, screenshotPaths_.front(), -1);
+			screenshotPaths_.pop_front();
+		}
+		if (isRecording_) {
+			int sequence = recordingSequence_++;
+			std::string path = recordingPath_;
+			if (recordingFormat_ == Format::Png) {
+				std::stringstream ss;
+				ss << std::setw(6) << std::setfill('0') << sequence << ".png";
+				path = (std::filesystem::path(recordingPath_) / ss.str()).string();
+			}
+			readFrame(size, readBuffer, recordingFormat_, path, sequence);
+		}
+
+		std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::lock_guard lock(mutex_);
+		statistics_.lastEndFrameMs = elapsed.count();
+	}
+
+	// Termine les lectures en cours et attend l'encodage de toutes les trames. Le contexte OpenGL doit être actif.
+	void flush() {
+		retireCompleted(true);
+		waitForEncoders();
+	}
+
+	// Comme flush(), mais sans contexte OpenGL (fenêtre déjà fermée) : les lectures pas encore récupérées sont perdues.
+	void finish() {
+		for (Slot& slot : slots_)
+			slot.isPending = false;
+		pendingSlots_.clear();
+		waitForEncoders();
+		isRecording_ = false;
+		y4mFile_.close();
+	}
+
+private:
+	struct Job
+	{
+		std::vector<uint8_t> pixels;
+		sf::Vector2u size;
+		Format format = Format::Png;
+		std::string path;
+		int sequence = -1;
+	};
+
+	struct Slot
+	{
+		GLuint pbo = 0;
+		size_t capacity = 0;
+		GLsync fence = nullptr;
+		bool isPending = false;
+		Job job;
+	};
+
+	void readFrame(sf::Vector2u size, GLenum readBuffer, Format format, const std::string& path, int sequence) {
+		// Tous les PBO sont en vol : attendre le plus ancien.
+		if (pendingSlots_.size() == N_PIXEL_BUFFERS) {
+			{
+				std::lock_guard lock(mutex_);
+				statistics_.stalls++;
+			}
+			while (not retireOldest(true)) { }
+		}
+
+		int index = 0;
+		while (slots_[index].isPending)
+			index++;
+		Slot& slot = slots_[index];
+
+		size_t nBytes = size_t(size.x) * size.y * 4;
+		if (slot.pbo == 0)
+			glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		if (slot.capacity < nBytes) {
+			glBufferData(GL_PIXEL_PACK_BUFFER, nBytes, nullptr, GL_STREAM_READ);
+			slot.capacity = nBytes;
+			GLDebug::label(GL_BUFFER, slot.pbo, "Frame Capture");
+		}
+
+		GLint previousReadBuffer;
+		glGetIntegerv(GL_READ_BUFFER, &previousReadBuffer);
+		glReadBuffer(readBuffer);
+		// Avec un PBO lié, glReadPixels retourne sans attendre le GPU.
+		glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glReadBuffer((GLenum)previousReadBuffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, GL_NONE_BIT);
+		slot.isPending = true;
+		slot.job.size = size;
+		slot.job.format = format;
+		slot.job.path = path;
+		slot.job.sequence = sequence;
+		pendingSlots_.push_back(index);
+		std::lock_guard lock(mutex_);
+		statistics_.framesCaptured++;
+	}
+
+	// Récupère les lectures terminées dans l'ordre d'émission.
+	void retireCompleted(bool shouldWait) {
+		while (not pendingSlots_.empty()) {
+			if (not retireOldest(shouldWait))
+				break;
+		}
+	}
+
+	bool retireOldest(bool shouldWait) {
+		Slot& slot = slots_[pendingSlots_.front()];
+		GLuint64 timeout = shouldWait ? 1'000'000'000ull : 0;
+		GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (status != GL_ALREADY_SIGNALED and status != GL_CONDITION_SATISFIED)
+			return false;
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+
+		Job job = std::move(slot.job);
+		job.pixels = acquireBuffer();
+		size_t nBytes = size_t(job.size.x) * job.size.y * 4;
+		job.pixels.resize(nBytes);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, nBytes, GL_MAP_READ_BIT);
+		if (data != nullptr)
+			std::memcpy(job.pixels.data(), data, nBytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.isPending = false;
+		pendingSlots_.pop_front();
+		submit(std::move(job));
+		return true;
+	}
+
+	std::vector<uint8_t> acquireBuffer() {
+		std::unique_lock lock(mutex_);
+		if (freeBuffers_.empty() and nBuffers_ == maxBuffers_) {
+			statistics_.stalls++;
+			buffersFree_.wait(lock, [&] { return not freeBuffers_.empty(); });
+		}
+		if (freeBuffers_.empty()) {
+			nBuffers_++;
+			return {};
+		}
+		std::vector<uint8_t> buffer = std::move(freeBuffers_.back());
+		freeBuffers_.pop_back();
+		return buffer;
+	}
+
+	void submit(Job&& job) {
+		{
+			std::lock_guard lock(mutex_);
+			if (workers_.empty()) {
+				for (unsigned int i = 0; i < nThreads_; i++)
+					workers_.emplace_back([this] { workerLoop(); });
+			}
+			jobs_.push_back(std::move(job));
+		}
+		jobsReady_.notify_one();
+	}
+
+	void waitForEncoders() {
+		std::unique_lock lock(mutex_);
+		idle_.wait(lock, [&] { return jobs_.empty() and nActiveJobs_ == 0; });
+	}
+
+	void workerLoop() {
+		while (true) {
+			Job job;
+			{
+				std::unique_lock lock(mutex_);
+				jobsReady_.wait(lock, [&] { return isStopping_ or not jobs_.empty(); });
+				if (jobs_.empty())
+					return;
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+				nActiveJobs_++;
+			}
+
+			if (job.format == Format::Png)
+				encodePng(job);
+			else
+				encodeY4m(job);
+
+			{
+				std::lock_guard lock(mutex_);
+				freeBuffers_.push_back(std::move(job.pixels));
+				nActiveJobs_--;
+				statistics_.framesEncoded++;
+			}
+			buffersFree_.notify_one();
+			idle_.notify_all();
+		}
+	}
+
+	static void encodePng(const Job& job) {
+		sf::Image image;
+		image.resize(job.size, job.pixels.data());
+		// L'origine OpenGL est en bas à gauche, celle des images SFML en haut à gauche.
+		image.flipVertically();
+		if (not image.saveToFile(job.path))
+			std::cerr << "Could not write image \"" << job.path << "\"" << "\n";
+	}
+
+	// YUV 4:2:0 pleine plage (BT.601, C420jpeg), les échantillons de chrominance moyennant des blocs 2x2.
+	void encodeY4m(const Job& job) {
+		unsigned int width = job.size.x, height = job.size.y;
+		unsigned int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+		std::vector<uint8_t> planes(size_t(width) * height + 2 * size_t(chromaWidth) * chromaHeight);
+		uint8_t* yPlane = planes.data();
+		uint8_t* uPlane = yPlane + size_t(width) * height;
+		uint8_t* vPlane = uPlane + size_t(chromaWidth) * chromaHeight;
+
+		auto pixel = [&](unsigned int x, unsigned int y) {
+			x = std::min(x, width - 1);
+			y = std::min(y, height - 1);
+			return &job.pixels[(size_t(height - 1 - y) * width + x) * 4];
+		};
+		for (unsigned int y = 0; y < height; y++) {
+			for (unsigned int x = 0; x < width; x++) {
+				const uint8_t* p = pixel(x, y);
+				yPlane[size_t(y) * width + x] = uint8_t(std::clamp(0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2] + 0.5f, 0.0f, 255.0f));
+			}
+		}
+		for (unsigned int y = 0; y < chromaHeight; y++) {
+			for (unsigned int x = 0; x < chromaWidth; x++) {
+				float r = 0.0f, g = 0.0f, b = 0.0f;
+				for (unsigned int i = 0; i < 4; i++) {
+					const uint8_t* p = pixel(2 * x + i % 2, 2 * y + i / 2);
+					r += p[0] * 0.25f;
+					g += p[1] * 0.25f;
+					b += p[2] * 0.25f;
+				}
+				uPlane[size_t(y) * chromaWidth + x] = uint8_t(std::clamp(128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b + 0.5f, 0.0f, 255.0f));
+				vPlane[size_t(y) * chromaWidth + x] = uint8_t(std::clamp(128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b + 0.5f, 0.0f, 255.0f));
+			}
+		}
+
+		// La conversion est parallèle, mais les trames sont écrites dans l'ordre.
+		std::unique_lock lock(mutex_);
+		writeTurn_.wait(lock, [&] { return nextWrittenSequence_ == job.sequence; });
+		if (y4mSize_.x == 0) {
+			y4mSize_ = job.size;
+			y4mFile_ << "YUV4MPEG2 W" << width << " H" << height << " F" << recordingFps_ << ":1 Ip A1:1 C420jpeg\n";
+		}
+		if (job.size.x == y4mSize_.x and job.size.y == y4mSize_.y) {
+			y4mFile_ << "FRAME\n";
+			y4mFile_.write((const char*)planes.data(), planes.size());
+		} else {
+			std::cerr << "Skipping frame " << job.sequence << ": size changed during recording" << "\n";
+		}
+		nextWrittenSequence_++;
+		lock.unlock();
+		writeTurn_.notify_all();
+	}
+
+	std::array<Slot, N_PIXEL_BUFFERS> slots_;
+	std::deque<int> pendingSlots_;
+	std::deque<std::string> screenshotPaths_;
+
+	bool isRecording_ = false;
+	std::string recordingPath_;
+	Format recordingFormat_ = Format::Png;
+	int recordingFps_ = 30;
+	int recordingSequence_ = 0;
+	std::ofstream y4mFile_;
+	sf::Vector2u y4mSize_ = {};
+
+	// Tout ce qui suit est partagé avec les fils d'encodage et protégé par mutex_.
+	mutable std::mutex mutex_;
+	std::condition_variable jobsReady_;
+	std::condition_variable buffersFree_;
+	std::condition_variable idle_;
+	std::condition_variable writeTurn_;
+	std::vector<std::thread> workers_;
+	std::deque<Job> jobs_;
+	std::vector<std::vector<uint8_t>> freeBuffers_;
+	unsigned int nThreads_ = 1;
+	unsigned int maxBuffers_ = 2;
+	unsigned int nBuffers_ = 0;
+	int nActiveJobs_ = 0;
+	int nextWrittenSequence_ = 0;
+	bool isStopping_ = false;
+	Statistics statistics_;
+};
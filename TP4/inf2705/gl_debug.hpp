@@ -0,0 +1,143 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <string_view>
+
+#include <glbinding/gl/gl.h>
+
+using namespace gl;
+
+
+// Comment les erreurs OpenGL sont rapportées (--gl-debug off|async|sync).
+enum class GLDebugMode
+{
+	// Rien : aucun rappel, aucune étiquette ni groupe.
+	Off,
+	// Le pilote appelle le rappel quand il veut, possiblement depuis un autre fil. Aucun coût sur le fil de rendu.
+	Asynchronous,
+	// Contexte de débogage, le rappel est appelé pendant l'appel fautif : un point d'arrêt dans messageCallback()
+	// donne la pile de l'appel. Plus lent, le pilote valide tout.
+	Synchronous,
+};
+
+#ifdef NDEBUG
+	inline constexpr GLDebugMode DEFAULT_GL_DEBUG_MODE = GLDebugMode::Asynchronous;
+#else
+	inline constexpr GLDebugMode DEFAULT_GL_DEBUG_MODE = GLDebugMode::Synchronous;
+#endif
+
+
+// Couche de débogage KHR_debug (cœur depuis OpenGL 4.3) : les erreurs arrivent par glDebugMessageCallback au lieu
+// d'être cherchées avec glGetError, qui force un aller-retour avec le pilote. Les étiquettes d'objets et les
+// groupes de passes apparaissent dans les outils externes (RenderDoc, Nsight).
+namespace GLDebug
+{
+	inline GLDebugMode mode = GLDebugMode::Off;
+
+	inline bool isActive() {
+		return mode != GLDebugMode::Off;
+	}
+
+	inline const char* sourceName(GLenum source) {
+		switch (source) {
+		case GL_DEBUG_SOURCE_API: return "API";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "Window System";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "Shader Compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "Third Party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "Application";
+		default: return "Other";
+		}
+	}
+
+	inline const char* typeName(GLenum type) {
+		switch (type) {
+		case GL_DEBUG_TYPE_ERROR: return "Error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "Deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "Undefined Behavior";
+		case GL_DEBUG_TYPE_PORTABILITY: return "Portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "Performance";
+		case GL_DEBUG_TYPE_MARKER: return "Marker";
+		default: return "Other";
+		}
+	}
+
+	inline const char* severityName(GLenum severity) {
+		switch (severity) {
+		case GL_DEBUG_SEVERITY_HIGH: return "High";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "Medium";
+		case GL_DEBUG_SEVERITY_LOW: return "Low";
+		default: return "Notification";
+		}
+	}
+
+	// Un seul fprintf par message : en mode asynchrone, le pilote peut appeler depuis plusieurs fils.
+	inline void GL_APIENTRY messageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void*) {
+		fprintf(stderr, "OpenGL %s %s (%s, id %u): %.*s\n", sourceName(source), typeName(type), severityName(severity), id, (int)length, message);
+	}
+
+	inline bool isSupported() {
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		if (major > 4 or (major == 4 and minor >= 3))
+			return true;
+		GLint nExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &nExtensions);
+		for (GLint i = 0; i < nExtensions; i++) {
+			auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (name != nullptr and std::strcmp(name, "GL_KHR_debug") == 0)
+				return true;
+		}
+		return false;
+	}
+
+	// À appeler une fois, le contexte actif. Retourne le mode effectif (Off si KHR_debug est absent).
+	inline GLDebugMode enable(GLDebugMode requested) {
+		mode = GLDebugMode::Off;
+		if (requested == GLDebugMode::Off or not isSupported())
+			return mode;
+
+		glEnable(GL_DEBUG_OUTPUT);
+		if (requested == GLDebugMode::Synchronous)
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		else
+			glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(messageCallback, nullptr);
+		// Les notifications (dont nos propres glPushDebugGroup) ne sont que du bruit dans la console.
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+		mode = requested;
+		return mode;
+	}
+
+	// Nomme un objet pour les outils externes. identifier : GL_PROGRAM, GL_BUFFER, GL_TEXTURE, GL_VERTEX_ARRAY, etc.
+	inline void label(GLenum identifier, GLuint name, std::string_view text) {
+		if (isActive() and name != 0)
+			glObjectLabel(identifier, name, (GLsizei)text.size(), text.data());
+	}
+
+	inline void pushGroup(const char* name) {
+		if (isActive())
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	}
+
+	inline void popGroup() {
+		if (isActive())
+			glPopDebugGroup();
+	}
+}
+
+// Regroupe les commandes du bloc englobant sous un nom dans les outils externes.
+struct DebugGroupScope
+{
+	DebugGroupScope(const char* name) { GLDebug::pushGroup(name); }
+	~DebugGroupScope() { GLDebug::popGroup(); }
+};
+
+#define DEBUG_GROUP_CONCAT_IMPL(a, b) a##b
+#define DEBUG_GROUP_CONCAT(a, b) DEBUG_GROUP_CONCAT_IMPL(a, b)
+#define DEBUG_GROUP(name) DebugGroupScope DEBUG_GROUP_CONCAT(debugGroup_, __LINE__)(name)
@@ -0,0 +1,404 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <imgui/imgui.h>
+
+
+class JobSystem;
+
+// Compteur parent/enfants : chaque tâche créée l'incrémente, chaque tâche terminée le décrémente.
+// JobSystem::wait() rend la main quand il revient à zéro.
+class JobCounter
+{
+public:
+	bool isDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<int> pending_ = 0;
+};
+
+// Une tâche est une tranche [begin, end[ d'une boucle parallelFor(). function et data viennent de l'appelant,
+// qui attend la fin du compteur avant de sortir. Les tâches sont copiées par valeur dans les files : rien n'est alloué.
+struct Job
+{
+	void (*function)(JobSystem& system, const Job& job) = nullptr;
+	const void* data = nullptr;
+	uint32_t begin = 0;
+	uint32_t end = 0;
+	uint32_t grain = 1;
+	JobCounter* counter = nullptr;
+};
+
+// File de Chase-Lev à capacité fixe. Le fil propriétaire empile et dépile par le bas sans verrou ; les autres
+// volent par le haut avec un seul compare-exchange. Pleine, push() échoue et l'appelant exécute la tâche lui-même.
+// Un voleur lit la case avant son compare-exchange : si le propriétaire l'a réécrite entre-temps, c'est que top a
+// avancé et le compare-exchange échoue, donc une copie déchirée n'est jamais utilisée.
+class WorkStealingDeque
+{
+public:
+	static constexpr int64_t CAPACITY = 1024;
+
+	// Fil propriétaire seulement.
+	bool push(const Job& job) {
+		int64_t bottom = bottom_.load(std::memory_order_relaxed);
+		int64_t top = top_.load(std::memory_order_acquire);
+		if (bottom - top >= CAPACITY)
+			return false;
+		slots_[bottom & MASK].store(job);
+		bottom_.store(bottom + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Fil propriétaire seulement. Dernière tâche empilée (la plus chaude dans le cache).
+	bool pop(Job& job) {
+		int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+		bottom_.store(bottom, std::memory_order_seq_cst);
+		int64_t top = top_.load(std::memory_order_seq_cst);
+		if (top > bottom) {
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+		job = slots_[bottom & MASK].load();
+		if (top == bottom) {
+			// Dernier élément : course possible avec un voleur.
+			bool isTaken = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom_.store(bottom + 1, std::memory_order_relaxed);
+			return isTaken;
+		}
+		return true;
+	}
+
+	// N'importe quel fil. Première tâche empilée (la plus grosse tranche restante).
+	bool steal(Job& job) {
+		int64_t top = top_.load(std::memory_order_seq_cst);
+		int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+		if (top >= bottom)
+			return false;
+		job = slots_[top & MASK].load();
+		return top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	bool isEmpty() const {
+		return top_.load(std::memory_order_relaxed) >= bottom_.load(std::memory_order_relaxed);
+	}
+
+private:
+	static constexpr int64_t MASK = CAPACITY - 1;
+
+	// Champs atomiques relâchés : l'ordre est donné par bottom_ et top_.
+	struct Slot
+	{
+		void store(const Job& job) {
+			function.store(job.function, std::memory_order_relaxed);
+			data.store(job.data, std::memory_order_relaxed);
+			begin.store(job.begin, std::memory_order_relaxed);
+			end.store(job.end, std::memory_order_relaxed);
+			grain.store(job.grain, std::memory_order_relaxed);
+			counter.store(job.counter, std::memory_order_relaxed);
+		}
+
+		Job load() const {
+			return {
+				function.load(std::memory_order_relaxed), data.load(std::memory_order_relaxed),
+				begin.load(std::memory_order_relaxed), end.load(std::memory_order_relaxed),
+				grain.load(std::memory_order_relaxed), counter.load(std::memory_order_relaxed)
+			};
+		}
+
+		std::atomic<void (*)(JobSystem&, const Job&)> function = nullptr;
+		std::atomic<const void*> data = nullptr;
+		std::atomic<uint32_t> begin = 0;
+		std::atomic<uint32_t> end = 0;
+		std::atomic<uint32_t> grain = 1;
+		std::atomic<JobCounter*> counter = nullptr;
+	};
+
+	alignas(64) std::atomic<int64_t> top_ = 0;
+	alignas(64) std::atomic<int64_t> bottom_ = 0;
+	std::array<Slot, CAPACITY> slots_;
+};
+
+// Système de tâches à vol de travail : un fil par cœur (moins le fil principal, qui participe pendant qu'il attend).
+// parallelFor() coupe récursivement l'intervalle en deux ; la moitié droite est empilée localement et les fils
+// inoccupés la volent. Les fils qui ne sont pas des travailleurs (principal, simulation) reçoivent leur propre file
+// au premier appel. Un parallelFor() imbriqué dans une tâche est permis : son attente exécute les tâches locales.
+class JobSystem
+{
+public:
+	static constexpr int MAX_THREADS = 64;
+
+	static JobSystem& get() {
+		static JobSystem system;
+		return system;
+	}
+
+	~JobSystem() {
+		stopping_.store(true);
+		workEpoch_.fetch_add(1);
+		workEpoch_.notify_all();
+		workers_.clear(); // jthread : join
+	}
+
+	// Nombre de fils qui exécutent des tâches, fil appelant compris.
+	int getThreadCount() const { return nWorkers_ + 1; }
+
+	// Appelle function(begin, end) sur des tranches disjointes de [0, count[ d'au plus grain éléments, puis attend.
+	template <typename Function>
+	void parallelFor(uint32_t count, uint32_t grain, const Function& function) {
+		if (count == 0)
+			return;
+		grain = std::max(grain, 1u);
+		ThreadSlot* slot = getThreadSlot();
+		if (count <= grain or nWorkers_ == 0 or slot == nullptr) {
+			function(0u, count);
+			return;
+		}
+
+		JobCounter counter;
+		Job job = { &runRange<Function>, &function, 0, count, grain, &counter };
+		counter.pending_.fetch_add(1, std::memory_order_relaxed);
+		execute(*slot, job);
+		wait(counter);
+	}
+
+	// Exécute des tâches jusqu'à ce que counter soit à zéro. Depuis une tâche (parallelFor imbriqué), seulement
+	// celles de la file locale : voler une tâche sans lien empilerait une récursion sans borne sur la pile.
+	void wait(const JobCounter& counter) {
+		ThreadSlot* slot = getThreadSlot();
+		while (not counter.isDone()) {
+			Job job;
+			bool isFound = false;
+			if (slot != nullptr)
+				isFound = executeDepth_ == 0 ? findJob(*slot, job) : slot->deque.pop(job);
+			if (isFound)
+				execute(*slot, job);
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	// Section « Jobs » de la fenêtre du profileur : occupation et vols par fil depuis l'affichage précédent.
+	void drawImGui() {
+		auto now = std::chrono::steady_clock::now();
+		double elapsedNs = std::chrono::duration<double, std::nano>(now - lastDrawTime_).count();
+		lastDrawTime_ = now;
+
+		int nSlots = nSlots_.load(std::memory_order_acquire);
+		std::array<float, MAX_THREADS> utilizations = {};
+		std::array<uint64_t, MAX_THREADS> jobs = {}, steals = {};
+		for (int i = 0; i < nSlots; i++) {
+			uint64_t busyNs = slots_[i].busyNs.load(std::memory_order_relaxed);
+			uint64_t nJobs = slots_[i].nJobs.load(std::memory_order_relaxed);
+			uint64_t nSteals = slots_[i].nSteals.load(std::memory_order_relaxed);
+			utilizations[i] = elapsedNs > 0.0 ? float((busyNs - lastStats_[i].busyNs) / elapsedNs) : 0.0f;
+			jobs[i] = nJobs - lastStats_[i].nJobs;
+			steals[i] = nSteals - lastStats_[i].nSteals;
+			lastStats_[i] = { busyNs, nJobs, nSteals };
+		}
+
+		if (not ImGui::Begin("Profiler")) {
+			ImGui::End();
+			return;
+		}
+		if (ImGui::CollapsingHeader("Jobs")) {
+			ImGui::Text("%d workers + caller threads", nWorkers_);
+			if (ImGui::BeginTable("jobs", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+				ImGui::TableSetupColumn("Thread");
+				ImGui::TableSetupColumn("Busy");
+				ImGui::TableSetupColumn("Jobs");
+				ImGui::TableSetupColumn("Steals");
+				ImGui::TableHeadersRow();
+				for (int i = 0; i < nSlots; i++) {
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					if (i < nWorkers_)
+						ImGui::Text("Worker %d", i);
+					else
+						ImGui::Text("Caller %d", i - nWorkers_);
+					ImGui::TableNextColumn();
+					ImGui::ProgressBar(std::min(utilizations[i], 1.0f), ImVec2(-1.0f, 0.0f));
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)jobs[i]);
+					ImGui::TableNextColumn();
+					ImGui::Text("%llu", (unsigned long long)steals[i]);
+				}
+				ImGui::EndTable();
+			}
+		}
+		ImGui::End();
+	}
+
+private:
+	struct alignas(64) ThreadSlot
+	{
+		WorkStealingDeque deque;
+		uint32_t randomState = 0;
+
+		std::atomic<uint64_t> busyNs = 0;
+		std::atomic<uint64_t> nJobs = 0;
+		std::atomic<uint64_t> nSteals = 0;
+	};
+
+	struct SlotStats
+	{
+		uint64_t busyNs = 0;
+		uint64_t nJobs = 0;
+		uint64_t nSteals = 0;
+	};
+
+	JobSystem() {
+		slots_ = std::make_unique<ThreadSlot[]>(MAX_THREADS);
+		for (int i = 0; i < MAX_THREADS; i++)
+			slots_[i].randomState = 0x9E3779B9u * (i + 1);
+
+		nWorkers_ = std::clamp((int)std::thread::hardware_concurrency() - 1, 0, MAX_THREADS / 2);
+		nSlots_.store(nWorkers_);
+		lastDrawTime_ = std::chrono::steady_clock::now();
+		for (int i = 0; i < nWorkers_; i++)
+			workers_.emplace_back([this, i] { runWorker(i); });
+	}
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// File du fil appelant, attribuée au premier appel. nullptr si toutes sont prises : l'appelant travaille seul.
+	ThreadSlot* getThreadSlot() {
+		if (threadIndex_ < 0) {
+			int index = nSlots_.fetch_add(1);
+			if (index >= MAX_THREADS) {
+				nSlots_.store(MAX_THREADS);
+				return nullptr;
+			}
+			threadIndex_ = index;
+		}
+		return &slots_[threadIndex_];
+	}
+
+	template <typename Function>
+	static void runRange(JobSystem& system, const Job& job) {
+		uint32_t begin = job.begin;
+		uint32_t end = job.end;
+		ThreadSlot& slot = system.slots_[threadIndex_];
+		// Garder la moitié gauche et publier la droite tant que la tranche dépasse grain.
+		while (end - begin > job.grain) {
+			uint32_t middle = begin + (end - begin) / 2;
+			Job child = job;
+			child.begin = middle;
+			child.end = end;
+			job.counter->pending_.fetch_add(1, std::memory_order_relaxed);
+			if (not slot.deque.push(child)) {
+				job.counter->pending_.fetch_sub(1, std::memory_order_relaxed);
+				break;
+			}
+			system.wakeWorkers();
+			end = middle;
+		}
+		(*static_cast<const Function*>(job.data))(begin, end);
+	}
+
+	// Le temps occupé n'est compté que pour la tâche la plus externe du fil : celui des tâches exécutées
+	// pendant une attente imbriquée y est déjà inclus.
+	void execute(ThreadSlot& slot, const Job& job) {
+		bool isOutermost = executeDepth_ == 0;
+		auto start = std::chrono::steady_clock::now();
+		JobCounter* counter = job.counter;
+		executeDepth_++;
+		job.function(*this, job);
+		executeDepth_--;
+		counter->pending_.fetch_sub(1, std::memory_order_acq_rel);
+		if (isOutermost) {
+			auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+			slot.busyNs.fetch_add(elapsed.count(), std::memory_order_relaxed);
+		}
+		slot.nJobs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Tâche locale d'abord, sinon vol en partant d'une victime au hasard.
+	bool findJob(ThreadSlot& slot, Job& job) {
+		if (slot.deque.pop(job))
+			return true;
+
+		int nSlots = std::min(nSlots_.load(std::memory_order_acquire), MAX_THREADS);
+		slot.randomState ^= slot.randomState << 13;
+		slot.randomState ^= slot.randomState >> 17;
+		slot.randomState ^= slot.randomState << 5;
+		int first = int(slot.randomState % uint32_t(nSlots));
+		for (int i = 0; i < nSlots; i++) {
+			ThreadSlot& victim = slots_[(first + i) % nSlots];
+			if (&victim == &slot)
+				continue;
+			if (victim.deque.steal(job)) {
+				slot.nSteals.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void wakeWorkers() {
+		workEpoch_.fetch_add(1, std::memory_order_seq_cst);
+		if (nSleeping_.load(std::memory_order_seq_cst) > 0)
+			workEpoch_.notify_all();
+	}
+
+	// Cherche du travail ; après quelques essais vides, dort jusqu'au prochain wakeWorkers().
+	void runWorker(int index) {
+		threadIndex_ = index;
+		ThreadSlot& slot = slots_[index];
+		int nFailedAttempts = 0;
+		while (not stopping_.load(std::memory_order_relaxed)) {
+			Job job;
+			if (findJob(slot, job)) {
+				execute(slot, job);
+				nFailedAttempts = 0;
+				continue;
+			}
+			if (++nFailedAttempts < 64) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			nSleeping_.fetch_add(1, std::memory_order_seq_cst);
+			uint32_t epoch = workEpoch_.load(std::memory_order_seq_cst);
+			if (not hasVisibleWork() and not stopping_.load())
+				workEpoch_.wait(epoch);
+			nSleeping_.fetch_sub(1, std::memory_order_seq_cst);
+			nFailedAttempts = 0;
+		}
+	}
+
+	bool hasVisibleWork() const {
+		int nSlots = std::min(nSlots_.load(std::memory_order_acquire), MAX_THREADS);
+		for (int i = 0; i < nSlots; i++)
+			if (not slots_[i].deque.isEmpty())
+				return true;
+		return false;
+	}
+
+	std::unique_ptr<ThreadSlot[]> slots_;
+	std::atomic<int> nSlots_ = 0;
+	int nWorkers_ = 0;
+	std::vector<std::jthread> workers_;
+
+	std::atomic<bool> stopping_ = false;
+	std::atomic<uint32_t> workEpoch_ = 0;
+	std::atomic<int> nSleeping_ = 0;
+
+	std::chrono::steady_clock::time_point lastDrawTime_;
+	std::array<SlotStats, MAX_THREADS> lastStats_ = {};
+
+	inline static thread_local int threadIndex_ = -1;
+	inline static thread_local int executeDepth_ = 0;
+};
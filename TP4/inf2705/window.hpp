@@ -0,0 +1,218 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#ifdef INF2705_HEADLESS_EGL
+	#include <EGL/egl.h>
+	#include <EGL/eglext.h>
+#endif
+
+#include <glbinding/Binding.h>
+#include <glbinding/gl/gl.h>
+#include <SFML/Window.hpp>
+#include <SFML/Graphics.hpp>
+
+
+using namespace gl;
+
+
+// Fenêtre de l'application. En mode normal, c'est une sf::RenderWindow. En mode sans affichage, aucune
+// fenêtre SFML n'est créée (son contexte partagé exige un serveur d'affichage) : le contexte vient d'EGL sans
+// surface (ex. Mesa llvmpipe) et on dessine dans un FBO qui reste lié à la place du framebuffer par défaut.
+// L'interface reprend le sous-ensemble de sf::RenderWindow utilisé par les applications.
+class ApplicationWindow
+{
+public:
+	ApplicationWindow() = default;
+	ApplicationWindow(const ApplicationWindow&) = delete;
+	ApplicationWindow& operator=(const ApplicationWindow&) = delete;
+
+	~ApplicationWindow() {
+		destroyHeadless();
+	}
+
+	template <typename... Args>
+	void create(Args&&... args) {
+		window_ = std::make_unique<sf::RenderWindow>();
+		window_->create(std::forward<Args>(args)...);
+	}
+
+	// Crée le contexte EGL et le FBO de dimensions size. Retourne false si EGL n'est pas disponible.
+	bool createHeadless(sf::Vector2u size, const sf::ContextSettings& context) {
+#ifdef INF2705_HEADLESS_EGL
+		auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != nullptr)
+			display_ = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		if (display_ == EGL_NO_DISPLAY)
+			display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display_ == EGL_NO_DISPLAY or not eglInitialize(display_, nullptr, nullptr)) {
+			std::cerr << "Could not initialize an EGL display" << "\n";
+			return false;
+		}
+		eglBindAPI(EGL_OPENGL_API);
+
+		// Aucune fenêtre n'est créée : une config pbuffer suffit, sinon EGL_KHR_no_config_context.
+		const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLConfig config = EGL_NO_CONFIG_KHR;
+		EGLint nConfigs = 0;
+		if (not eglChooseConfig(display_, configAttribs, &config, 1, &nConfigs) or nConfigs == 0)
+			config = EGL_NO_CONFIG_KHR;
+
+		// Les applications utilisent des nuanceurs de calcul : on vise la version la plus récente disponible.
+		const std::pair<int, int> versions[] = { {4, 6}, {4, 5}, {4, 3}, {(int)context.majorVersion, (int)context.minorVersion} };
+		for (auto [major, minor] : versions) {
+			const EGLint contextAttribs[] = {
+				EGL_CONTEXT_MAJOR_VERSION, major,
+				EGL_CONTEXT_MINOR_VERSION, minor,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_CONTEXT_OPENGL_DEBUG, (context.attributeFlags & sf::ContextSettings::Attribute::Debug) ? EGL_TRUE : EGL_FALSE,
+				EGL_NONE
+			};
+			context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, contextAttribs);
+			if (context_ != EGL_NO_CONTEXT)
+				break;
+		}
+		if (context_ == EGL_NO_CONTEXT or not eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_)) {
+			std::cerr << "Could not create a surfaceless OpenGL context" << "\n";
+			return false;
+		}
+
+		glbinding::Binding::initialize(eglGetProcAddress);
+
+		size_ = size;
+		isHeadlessOpen_ = true;
+		createFramebuffer();
+
+		headlessSettings_ = context;
+		GLint major = 0, minor = 0;
+		glGetIntegerv(GL_MAJOR_VERSION, &major);
+		glGetIntegerv(GL_MINOR_VERSION, &minor);
+		headlessSettings_.majorVersion = major;
+		headlessSettings_.minorVersion = minor;
+		headlessSettings_.depthBits = 24;
+		headlessSettings_.stencilBits = 8;
+		headlessSettings_.antiAliasingLevel = 0;
+		return true;
+#else
+		std::cerr << "Headless mode requires a build with EGL (INF2705_HEADLESS_EGL)" << "\n";
+		return false;
+#endif
+	}
+
+	bool isHeadless() const { return window_ == nullptr and size_.x != 0; }
+
+	bool isOpen() const { return window_ != nullptr ? window_->isOpen() : isHeadlessOpen_; }
+
+	void close() {
+		if (window_ != nullptr)
+			window_->close();
+		isHeadlessOpen_ = false;
+	}
+
+	// En mode sans affichage, attend la fin du GPU pour que le temps de trame mesuré l'inclue.
+	void display() {
+		if (window_ != nullptr)
+			window_->display();
+		else
+			glFinish();
+	}
+
+	std::optional<sf::Event> pollEvent() {
+		return window_ != nullptr ? window_->pollEvent() : std::nullopt;
+	}
+
+	sf::Vector2u getSize() const { return window_ != nullptr ? window_->getSize() : size_; }
+
+	bool hasFocus() const { return window_ != nullptr and window_->hasFocus(); }
+
+	void setMouseCursorGrabbed(bool grabbed) {
+		if (window_ != nullptr)
+			window_->setMouseCursorGrabbed(grabbed);
+	}
+
+	void setMouseCursorVisible(bool visible) {
+		if (window_ != nullptr)
+			window_->setMouseCursorVisible(visible);
+	}
+
+	void setFramerateLimit(unsigned int limit) {
+		if (window_ != nullptr)
+			window_->setFramerateLimit(limit);
+	}
+
+	void setVerticalSyncEnabled(bool enabled) {
+		if (window_ != nullptr)
+			window_->setVerticalSyncEnabled(enabled);
+	}
+
+	bool setActive(bool active = true) {
+		return window_ != nullptr ? window_->setActive(active) : isHeadlessOpen_;
+	}
+
+	const sf::ContextSettings& getSettings() const {
+		return window_ != nullptr ? window_->getSettings() : headlessSettings_;
+	}
+
+	// Tampon où la trame courante est dessinée.
+	GLenum getBackBuffer() const {
+		return window_ != nullptr ? GL_BACK : GL_COLOR_ATTACHMENT0;
+	}
+
+	// Tampon à lire pour capturer la dernière trame affichée.
+	GLenum getFrontBuffer() const {
+		return window_ != nullptr ? GL_FRONT : GL_COLOR_ATTACHMENT0;
+	}
+
+	// Pour les fonctions SFML qui prennent une fenêtre (souris). Seulement valide en mode fenêtré.
+	operator const sf::WindowBase&() const { return *window_; }
+
+private:
+	void createFramebuffer() {
+		glGenRenderbuffers(2, renderbuffers_);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers_[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size_.x, size_.y);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers_[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size_.x, size_.y);
+
+		glGenFramebuffers(1, &framebuffer_);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers_[0]);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers_[1]);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cerr << "Headless framebuffer is incomplete" << "\n";
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glViewport(0, 0, size_.x, size_.y);
+	}
+
+	void destroyHeadless() {
+#ifdef INF2705_HEADLESS_EGL
+		if (context_ == EGL_NO_CONTEXT)
+			return;
+		glDeleteFramebuffers(1, &framebuffer_);
+		glDeleteRenderbuffers(2, renderbuffers_);
+		eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(display_, context_);
+		eglTerminate(display_);
+		context_ = EGL_NO_CONTEXT;
+#endif
+	}
+
+	std::unique_ptr<sf::RenderWindow> window_;
+
+	sf::Vector2u size_ = {};
+	bool isHeadlessOpen_ = false;
+	sf::ContextSettings headlessSettings_;
+	GLuint framebuffer_ = 0;
+	GLuint renderbuffers_[2] = {};
+#ifdef INF2705_HEADLESS_EGL
+	EGLDisplay display_ = EGL_NO_DISPLAY;
+	EGLContext context_ = EGL_NO_CONTEXT;
+#endif
+};
@@ -2,18 +2,285 @@
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <bit>
+#include <chrono>
 #include <vector>
-#include <map>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <inf2705/gl_debug.hpp>
+#include <inf2705/job_system.hpp>
+
+#include "../../TP1-3/src/frustum.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CLOUD_UPDATE_SSE2
+#endif
+
 using namespace gl;
 
-static void generateCloudMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices, int detail = 3) {
+namespace {
+    const float TWO_PI = 6.2831853f;
+    const float MAX_DISTANCE = 30.0f;
+
+    // Parabola through 0, pi/2 and pi with a second correction pass, after reduction to [-pi, pi].
+    // The error stays under 0.001, plenty for the vertical bobbing. The SIMD versions do the same operations.
+    float sinApprox(float x) {
+        x -= std::nearbyint(x * (1.0f / TWO_PI)) * TWO_PI;
+        float y = 1.27323954f * x - 0.405284735f * x * std::fabs(x);
+        return 0.225f * (y * std::fabs(y) - y) + y;
+    }
+
+#if defined(__AVX2__)
+    __m256 sinApprox(__m256 x) {
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+        __m256 turns = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.0f / TWO_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        x = _mm256_sub_ps(x, _mm256_mul_ps(turns, _mm256_set1_ps(TWO_PI)));
+        __m256 y = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(1.27323954f), x),
+            _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.405284735f), x), _mm256_and_ps(x, absMask)));
+        return _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.225f), _mm256_sub_ps(_mm256_mul_ps(y, _mm256_and_ps(y, absMask)), y)), y);
+    }
+#elif defined(CLOUD_UPDATE_SSE2)
+    __m128 sinApprox(__m128 x) {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / TWO_PI))));
+        x = _mm_sub_ps(x, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI)));
+        __m128 y = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(1.27323954f), x),
+            _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.405284735f), x), _mm_and_ps(x, absMask)));
+        return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(0.225f), _mm_sub_ps(_mm_mul_ps(y, _mm_and_ps(y, absMask)), y)), y);
+    }
+#endif
+
+    // GPU version of Clouds::update: same rules and same generator as spawnCloud, one invocation per cloud.
+    const char* UPDATE_SOURCE = R"GLSL(
+#version 430 core
+layout(local_size_x = 256) in;
+
+const float TWO_PI = 6.2831853;
+const float MAX_DISTANCE = 30.0;
+
+// Same layout as Clouds::GpuState.
+struct CloudState {
+    vec4 positionRotation; // xyz: position, w: rotation around Y
+    vec4 scaleAlpha;       // xyz: scale, w: alpha
+    vec4 motion;           // xy: direction (x, z), z: speed, w: rotation speed
+    vec4 life;             // x: lifetime, y: max lifetime, z: float offset, w: float speed
+    float floatAmount;
+    uint random;
+    vec2 padding;
+};
+
+layout(std430, binding = 0) buffer CloudStates { CloudState clouds[]; };
+
+uniform uint uCloudCount;
+uniform float uDeltaTime;
+
+float uniformRandom(inout uint state, float minValue, float maxValue) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return minValue + float(state >> 8) * (1.0 / 16777216.0) * (maxValue - minValue);
+}
+
+void spawnCloud(inout CloudState c) {
+    uint r = c.random;
+    c.positionRotation.x = uniformRandom(r, -20.0, 20.0);
+    c.positionRotation.y = uniformRandom(r, 1.5, 5.0);
+    c.positionRotation.z = uniformRandom(r, -20.0, 20.0);
+    float heading = uniformRandom(r, 0.0, TWO_PI);
+    c.motion.xy = vec2(cos(heading), sin(heading));
+    c.motion.z = uniformRandom(r, 0.15, 0.4);
+    c.life.x = 0.0;
+    c.life.y = uniformRandom(r, 25.0, 35.0);
+    c.scaleAlpha.w = 0.0;
+    c.scaleAlpha.x = uniformRandom(r, 1.8, 2.8);
+    c.scaleAlpha.y = uniformRandom(r, 0.7, 1.1);
+    c.scaleAlpha.z = uniformRandom(r, 1.5, 2.5);
+    c.positionRotation.w = uniformRandom(r, 0.0, TWO_PI);
+    c.motion.w = uniformRandom(r, -0.03, 0.03);
+    c.life.z = 0.0;
+    c.life.w = uniformRandom(r, 0.5, 1.5);
+    c.floatAmount = uniformRandom(r, 0.05, 0.15);
+    c.random = r;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uCloudCount) return;
+
+    CloudState c = clouds[i];
+    float lifetime = c.life.x + uDeltaTime;
+    c.life.x = lifetime;
+    c.scaleAlpha.w = min(min(lifetime * 0.25, 1.0), (c.life.y - lifetime) * 0.25);
+    c.positionRotation.xz += c.motion.xy * (c.motion.z * uDeltaTime);
+    c.life.z += c.life.w * uDeltaTime;
+    c.positionRotation.y += sin(c.life.z) * c.floatAmount * uDeltaTime;
+    c.positionRotation.w += c.motion.w * uDeltaTime;
+
+    vec3 position = c.positionRotation.xyz;
+    if (lifetime >= c.life.y || dot(position, position) > MAX_DISTANCE * MAX_DISTANCE) spawnCloud(c);
+    clouds[i] = c;
+}
+)GLSL";
+
+    // GPU version of Clouds::fillInstances, in two passes over the clouds. The first counts the visible clouds of
+    // each LOD, the second writes each one after the instances of the finer LODs and fills the indirect commands.
+    const char* CULL_SOURCE = R"GLSL(
+#version 430 core
+layout(local_size_x = 256) in;
+
+const int MESH_LOD_COUNT = 4; // Clouds::MESH_LOD_COUNT
+const int LOD_COUNT = MESH_LOD_COUNT + 1;
+
+struct CloudState {
+    vec4 positionRotation;
+    vec4 scaleAlpha;
+    vec4 motion;
+    vec4 life;
+    float floatAmount;
+    uint random;
+    vec2 padding;
+};
+
+// Same layout as Clouds::CloudInstance.
+struct CloudInstance {
+    vec4 positionRotation;
+    vec4 scaleAlpha;
+};
+
+layout(std430, binding = 0) readonly buffer CloudStates { CloudState clouds[]; };
+layout(std430, binding = 1) writeonly buffer CloudInstances { CloudInstance instances[]; };
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+// Same layout as Clouds::DrawCommands, cleared to zero before the first pass.
+layout(std430, binding = 2) buffer DrawCommands {
+    DrawCommand commands[LOD_COUNT];
+    uint lodCounts[LOD_COUNT];
+};
+
+uniform uint uCloudCount;
+uniform vec4 uFrustumPlanes[6];
+uniform float uMeshRadius;
+uniform vec3 uCameraPos;
+uniform float uProjScale;
+uniform float uLodScreenSizes[MESH_LOD_COUNT];
+uniform uvec2 uLodRanges[LOD_COUNT]; // x: first index, y: index count
+uniform bool uScatter;
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    // The counts are final in the second pass: one invocation rewrites the commands that were cleared.
+    if (uScatter && i == 0u) {
+        uint baseInstance = 0u;
+        for (int lod = 0; lod < LOD_COUNT; lod++) {
+            commands[lod].count = uLodRanges[lod].y;
+            commands[lod].firstIndex = uLodRanges[lod].x;
+            commands[lod].baseVertex = 0;
+            commands[lod].baseInstance = baseInstance;
+            baseInstance += lodCounts[lod];
+        }
+    }
+    if (i >= uCloudCount) return;
+
+    vec4 positionRotation = clouds[i].positionRotation;
+    vec4 scaleAlpha = clouds[i].scaleAlpha;
+    if (scaleAlpha.w <= 0.01) return;
+
+    float radius = uMeshRadius * max(scaleAlpha.x, max(scaleAlpha.y, scaleAlpha.z));
+    for (int p = 0; p < 6; p++) {
+        if (dot(uFrustumPlanes[p].xyz, positionRotation.xyz) + uFrustumPlanes[p].w < -radius) return;
+    }
+
+    // Same choice as selectLod() on the CPU.
+    float screenSize = radius * uProjScale / max(distance(uCameraPos, positionRotation.xyz), 0.001);
+    int lod = 0;
+    while (lod < MESH_LOD_COUNT && screenSize < uLodScreenSizes[lod]) lod++;
+
+    if (!uScatter) {
+        atomicAdd(lodCounts[lod], 1u);
+        return;
+    }
+    uint slot = atomicAdd(commands[lod].instanceCount, 1u);
+    for (int finer = 0; finer < lod; finer++) slot += lodCounts[finer];
+    instances[slot] = CloudInstance(positionRotation, vec4(scaleAlpha.xyz, scaleAlpha.w * 0.85));
+}
+)GLSL";
+
+    GLuint createComputeProgram(const char* source, const char* name) {
+        GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint success;
+        char infoLog[512];
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+            std::cerr << name << " compute shader compilation failed: " << infoLog << std::endl;
+        }
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, shader);
+        glLinkProgram(program);
+        glDeleteShader(shader);
+        GLDebug::label(GL_PROGRAM, program, name);
+
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            std::cerr << name << " compute program linking failed: " << infoLog << std::endl;
+        }
+        return program;
+    }
+
+    const GLuint CLOUD_GROUP_SIZE = 256;
+
+    // Finest icosphere subdivision, used by LOD 0. LOD k uses MAX_MESH_DETAIL - k.
+    const int MAX_MESH_DETAIL = 4;
+    static_assert(MAX_MESH_DETAIL >= Clouds::MESH_LOD_COUNT - 1, "every mesh LOD needs its own level");
+    // Smallest screen size of each mesh LOD: the bounding sphere radius over the distance, times proj[1][1] (the
+    // fraction of the screen height covered by the diameter). Smaller clouds are drawn as impostors.
+    const float LOD_SCREEN_SIZES[Clouds::MESH_LOD_COUNT] = { 0.6f, 0.3f, 0.15f, 0.08f };
+
+    int selectLod(float screenSize) {
+        int lod = 0;
+        while (lod < Clouds::MESH_LOD_COUNT && screenSize < LOD_SCREEN_SIZES[lod]) lod++;
+        return lod;
+    }
+
+    // Appends to respawns the indices whose bits are set in mask.
+    void appendRespawns(int mask, uint32_t base, std::vector<uint32_t>& respawns) {
+        unsigned int bits = static_cast<unsigned int>(mask);
+        while (bits != 0) {
+            respawns.push_back(base + std::countr_zero(bits));
+            bits &= bits - 1;
+        }
+    }
+}
+
+// Every icosphere level from 0 to detail, in a single pass without copies. Each level keeps the vertices of the
+// previous one and appends its edge midpoints, so all the levels index the same vertices: levelOffsets[level] is
+// the first index of that level, levelOffsets[detail + 1] the end. Midpoints are found in a flat open-addressing
+// table keyed on the sorted edge. The radius noise is displaced from the midpoint of the two parents with an
+// amplitude halved at each level, so the coarse levels keep the overall shape of the fine ones.
+static void generateCloudMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices,
+    std::vector<size_t>& levelOffsets, int detail = 3) {
     vertices.clear();
     indices.clear();
+    levelOffsets.clear();
     const float t = (1.0f + sqrt(5.0f)) / 2.0f;
-    std::vector<glm::vec3> baseVertices = {
+    std::vector<glm::vec3> positions = {
         glm::normalize(glm::vec3(-1, t, 0)),
         glm::normalize(glm::vec3(1, t, 0)),
         glm::normalize(glm::vec3(-1, -t, 0)),
@@ -27,57 +294,72 @@ static void generateCloudMesh(std::vector<float>& vertices, std::vector<unsigned
         glm::normalize(glm::vec3(-t, 0, -1)),
         glm::normalize(glm::vec3(-t, 0, 1))
     };
-    std::vector<unsigned int> baseIndices = {   // forme de nuage hard-coded, gnr par DeepSeek: "Gnrer indices pour la forme gnrale d'un nuage"
+    indices = {   // forme de nuage hard-coded, gnr par DeepSeek: "Gnrer indices pour la forme gnrale d'un nuage"
         0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
         1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
         3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
         4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
     };
-    for (int i = 0; i < detail; i++) {
-        std::vector<glm::vec3> newVertices = baseVertices;
-        std::vector<unsigned int> newIndices;
-        struct Edge {
-            int v1, v2;
-            bool operator<(const Edge& other) const {
-                return (v1 < other.v1) || (v1 == other.v1 && v2 < other.v2);
+    size_t finalVertexCount = 10 * ((size_t)1 << (2 * detail)) + 2;
+    positions.reserve(finalVertexCount);
+    indices.reserve(20 * (((size_t)1 << (2 * detail + 2)) - 1));
+
+    auto randNoise = []() -> float { return (rand() % 400) / 1000.0f; };
+    std::vector<float> radii;
+    radii.reserve(finalVertexCount);
+    for (size_t i = 0; i < positions.size(); i++) radii.push_back(0.8f + randNoise());
+
+    const uint64_t EMPTY = ~0ull;
+    std::vector<uint64_t> edgeKeys;
+    std::vector<unsigned int> edgeMidpoints;
+    levelOffsets.push_back(0);
+    for (int level = 1; level <= detail; level++) {
+        size_t begin = levelOffsets.back();
+        size_t end = indices.size();
+        levelOffsets.push_back(end);
+
+        // Half full at most: a level has 1.5 edges per triangle.
+        size_t edgeCount = (end - begin) / 2;
+        int bits = (int)std::bit_width(edgeCount * 2 - 1);
+        edgeKeys.assign((size_t)1 << bits, EMPTY);
+        edgeMidpoints.resize(edgeKeys.size());
+        float amplitude = 1.0f / (float)(1 << level);
+
+        auto getMidpoint = [&](unsigned int v1, unsigned int v2) -> unsigned int {
+            uint64_t key = ((uint64_t)std::min(v1, v2) << 32) | std::max(v1, v2);
+            size_t mask = edgeKeys.size() - 1;
+            size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+            while (edgeKeys[slot] != EMPTY) {
+                if (edgeKeys[slot] == key) return edgeMidpoints[slot];
+                slot = (slot + 1) & mask;
             }
-        };
-        std::map<Edge, int> midpointCache;
-        auto getMidpoint = [&](int v1, int v2) -> int {
-            Edge e = { std::min(v1, v2), std::max(v1, v2) };
-            auto it = midpointCache.find(e);
-            if (it != midpointCache.end()) return it->second;
-            glm::vec3 mid = glm::normalize((baseVertices[v1] + baseVertices[v2]) * 0.5f);
-            int index = newVertices.size();
-            newVertices.push_back(mid);
-            midpointCache[e] = index;
+            unsigned int index = (unsigned int)positions.size();
+            positions.push_back(glm::normalize(positions[v1] + positions[v2]));
+            radii.push_back((radii[v1] + radii[v2]) * 0.5f + (randNoise() - 0.2f) * amplitude);
+            edgeKeys[slot] = key;
+            edgeMidpoints[slot] = index;
             return index;
             };
-        for (size_t j = 0; j < baseIndices.size(); j += 3) {
-            int v1 = baseIndices[j];
-            int v2 = baseIndices[j + 1];
-            int v3 = baseIndices[j + 2];
-            int m12 = getMidpoint(v1, v2);
-            int m23 = getMidpoint(v2, v3);
-            int m31 = getMidpoint(v3, v1);
-            newIndices.push_back(v1); newIndices.push_back(m12); newIndices.push_back(m31);
-            newIndices.push_back(v2); newIndices.push_back(m23); newIndices.push_back(m12);
-            newIndices.push_back(v3); newIndices.push_back(m31); newIndices.push_back(m23);
-            newIndices.push_back(m12); newIndices.push_back(m23); newIndices.push_back(m31);
+        for (size_t j = begin; j < end; j += 3) {
+            unsigned int v1 = indices[j];
+            unsigned int v2 = indices[j + 1];
+            unsigned int v3 = indices[j + 2];
+            unsigned int m12 = getMidpoint(v1, v2);
+            unsigned int m23 = getMidpoint(v2, v3);
+            unsigned int m31 = getMidpoint(v3, v1);
+            unsigned int triangles[] = { v1, m12, m31, v2, m23, m12, v3, m31, m23, m12, m23, m31 };
+            indices.insert(indices.end(), std::begin(triangles), std::end(triangles));
         }
-        baseVertices = newVertices;
-        baseIndices = newIndices;
-    }
-    for (size_t i = 0; i < baseVertices.size(); i++) {
-        glm::vec3 pos = baseVertices[i];
-        auto randFloat = []() -> float { return 0.8f + (rand() % 400) / 1000.0f; };
-        float noise = randFloat();
-        pos *= noise;
+    }
+    levelOffsets.push_back(indices.size());
+
+    vertices.reserve(positions.size() * 3);
+    for (size_t i = 0; i < positions.size(); i++) {
+        glm::vec3 pos = positions[i] * radii[i];
         vertices.push_back(pos.x);
         vertices.push_back(pos.y);
         vertices.push_back(pos.z);
     }
-    indices = baseIndices;
 }
 
 Clouds::Clouds() : cloudCount_(20) {}
@@ -86,61 +368,125 @@ Clouds::Clouds(unsigned int cloudCount) : cloudCount_(cloudCount) {}
 Clouds::~Clouds() {
     if (vbo_) glDeleteBuffers(1, &vbo_);
     if (ebo_) glDeleteBuffers(1, &ebo_);
+    if (instanceVbo_) glDeleteBuffers(1, &instanceVbo_);
+    if (drawCommandBuffer_) glDeleteBuffers(1, &drawCommandBuffer_);
     if (vao_) glDeleteVertexArrays(1, &vao_);
     if (shaderProgram_) glDeleteProgram(shaderProgram_);
+    if (gpuStateBuffer_) glDeleteBuffers(1, &gpuStateBuffer_);
+    if (gpuInstanceBuffer_) glDeleteBuffers(1, &gpuInstanceBuffer_);
+    if (gpuVao_) glDeleteVertexArrays(1, &gpuVao_);
+    if (updateProgram_) glDeleteProgram(updateProgram_);
+    if (cullProgram_) glDeleteProgram(cullProgram_);
 }
 
 void Clouds::initialize() {
-    if (clouds_.empty()) {
-        clouds_.resize(cloudCount_);
-        for (unsigned int i = 0; i < cloudCount_; ++i) spawnCloud(i);
-    }
+    spawnClouds();
     if (vao_ == 0) {
         initBuffers();
         loadShaders();
     }
 }
 
-void Clouds::spawnCloud(unsigned int index) {
-    auto randomFloat = [](float min = 0.0f, float max = 1.0f) -> float {
-        return min + (rand() % 10000) * (max - min) / 10000.0f;
-        };
-    clouds_[index].position = glm::vec3(
-        (rand() % 4000 - 2000) / 100.0f,
-        (rand() % 350) / 100.0f + 1.5f,
-        (rand() % 4000 - 2000) / 100.0f
-    );
-    clouds_[index].direction = glm::normalize(glm::vec3(
-        randomFloat(-1.0f, 1.0f),
-        0.0f,
-        randomFloat(-1.0f, 1.0f)
-    ));
-    clouds_[index].speed = randomFloat(0.15f, 0.4f);
-    clouds_[index].lifetime = 0.0f;
-    clouds_[index].maxLifetime = randomFloat(25.0f, 35.0f);
-    clouds_[index].fadePhase = 0.0f;
-    clouds_[index].alpha = 0.0f;
-    clouds_[index].scale = glm::vec3(
-        randomFloat(1.8f, 2.8f),
-        randomFloat(0.7f, 1.1f),
-        randomFloat(1.5f, 2.5f)
-    );
-    clouds_[index].rotationY = randomFloat(0.0f, M_PI * 2.0f);
-    clouds_[index].rotationSpeedY = randomFloat(-0.03f, 0.03f);
-    clouds_[index].floatOffset = 0.0f;
-    clouds_[index].floatSpeed = randomFloat(0.5f, 1.5f);
-    clouds_[index].floatAmount = randomFloat(0.05f, 0.15f);
+void Clouds::spawnClouds() {
+    if (clouds_.size() == 0) setCloudCount(cloudCount_);
+}
+
+void Clouds::setCloudCount(unsigned int cloudCount) {
+    uint32_t oldCount = (uint32_t)clouds_.size();
+    cloudCount_ = cloudCount;
+    for (std::vector<float>* column : { &clouds_.positionX, &clouds_.positionY, &clouds_.positionZ, &clouds_.rotationY,
+        &clouds_.scaleX, &clouds_.scaleY, &clouds_.scaleZ, &clouds_.alpha, &clouds_.directionX, &clouds_.directionZ,
+        &clouds_.speed, &clouds_.lifetime, &clouds_.maxLifetime, &clouds_.rotationSpeedY,
+        &clouds_.floatOffset, &clouds_.floatSpeed, &clouds_.floatAmount })
+        column->resize(cloudCount_);
+
+    // The generators are seeded from rand() so that srand() (input replay) still fixes the clouds.
+    size_t nChunks = (cloudCount_ + UPDATE_CHUNK_SIZE - 1) / UPDATE_CHUNK_SIZE;
+    for (size_t chunk = randoms_.size(); chunk < nChunks; chunk++)
+        randoms_.push_back({ ((uint32_t)std::rand() * 2654435761u) ^ (uint32_t)(chunk * 40503u) | 1u });
+    randoms_.resize(nChunks);
+    respawns_.resize(nChunks);
+
+    for (uint32_t i = oldCount; i < cloudCount_; ++i) spawnCloud(i, randoms_[i / UPDATE_CHUNK_SIZE]);
+
+    // The CPU columns are not kept up to date in GPU mode: every cloud restarts.
+    if (isGpuSimulation_) {
+        for (uint32_t i = 0; i < oldCount && i < cloudCount_; ++i) spawnCloud(i, randoms_[i / UPDATE_CHUNK_SIZE]);
+        uploadGpuState();
+    }
+}
+
+void Clouds::spawnCloud(uint32_t index, Random& random) {
+    CloudArrays& c = clouds_;
+    c.positionX[index] = random.uniform(-20.0f, 20.0f);
+    c.positionY[index] = random.uniform(1.5f, 5.0f);
+    c.positionZ[index] = random.uniform(-20.0f, 20.0f);
+    float heading = random.uniform(0.0f, TWO_PI);
+    c.directionX[index] = std::cos(heading);
+    c.directionZ[index] = std::sin(heading);
+    c.speed[index] = random.uniform(0.15f, 0.4f);
+    c.lifetime[index] = 0.0f;
+    c.maxLifetime[index] = random.uniform(25.0f, 35.0f);
+    c.alpha[index] = 0.0f;
+    c.scaleX[index] = random.uniform(1.8f, 2.8f);
+    c.scaleY[index] = random.uniform(0.7f, 1.1f);
+    c.scaleZ[index] = random.uniform(1.5f, 2.5f);
+    c.rotationY[index] = random.uniform(0.0f, TWO_PI);
+    c.rotationSpeedY[index] = random.uniform(-0.03f, 0.03f);
+    c.floatOffset[index] = 0.0f;
+    c.floatSpeed[index] = random.uniform(0.5f, 1.5f);
+    c.floatAmount[index] = random.uniform(0.05f, 0.15f);
+}
+
+void Clouds::copyRenderState(CloudArrays& state) const {
+    state.positionX = clouds_.positionX;
+    state.positionY = clouds_.positionY;
+    state.positionZ = clouds_.positionZ;
+    state.rotationY = clouds_.rotationY;
+    state.scaleX = clouds_.scaleX;
+    state.scaleY = clouds_.scaleY;
+    state.scaleZ = clouds_.scaleZ;
+    state.alpha = clouds_.alpha;
+}
+
+void Clouds::setRenderState(const CloudArrays& state) {
+    clouds_.positionX = state.positionX;
+    clouds_.positionY = state.positionY;
+    clouds_.positionZ = state.positionZ;
+    clouds_.rotationY = state.rotationY;
+    clouds_.scaleX = state.scaleX;
+    clouds_.scaleY = state.scaleY;
+    clouds_.scaleZ = state.scaleZ;
+    clouds_.alpha = state.alpha;
+    cloudCount_ = (unsigned int)state.size();
 }
 
 void Clouds::initBuffers() {
     std::vector<float> vertices;
     std::vector<unsigned int> indices;
-    generateCloudMesh(vertices, indices, 2);
+    std::vector<size_t> levelOffsets;
+    generateCloudMesh(vertices, indices, levelOffsets, MAX_MESH_DETAIL);
     vertexCount_ = vertices.size() / 3;
-    indexCount_ = indices.size();
+    meshRadius_ = 0.0f;
+    for (size_t i = 0; i < vertexCount_; i++)
+        meshRadius_ = std::max(meshRadius_, glm::length(glm::vec3(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2])));
+
+    for (int lod = 0; lod < MESH_LOD_COUNT; lod++) {
+        int level = MAX_MESH_DETAIL - lod;
+        lodCommands_[lod] = { (GLuint)(levelOffsets[level + 1] - levelOffsets[level]), 0, (GLuint)levelOffsets[level], 0, 0 };
+    }
+    // The impostor quad follows the mesh: the vertex shader recognizes it by its vertex index.
+    const float quad[] = { -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 1.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f };
+    const unsigned int quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+    lodCommands_[MESH_LOD_COUNT] = { 6, 0, (GLuint)indices.size(), 0, 0 };
+    vertices.insert(vertices.end(), std::begin(quad), std::end(quad));
+    for (unsigned int index : quadIndices) indices.push_back((unsigned int)vertexCount_ + index);
+
     glGenVertexArrays(1, &vao_);
     glGenBuffers(1, &vbo_);
     glGenBuffers(1, &ebo_);
+    glGenBuffers(1, &instanceVbo_);
+    glGenBuffers(1, &drawCommandBuffer_);
     glBindVertexArray(vao_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
@@ -148,32 +494,84 @@ void Clouds::initBuffers() {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+
+    setInstanceAttributes(instanceVbo_);
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Written by fillInstances() or by the GPU cull pass.
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer_);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommands), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    GLDebug::label(GL_VERTEX_ARRAY, vao_, "Cloud");
+    GLDebug::label(GL_BUFFER, vbo_, "Cloud");
+    GLDebug::label(GL_BUFFER, ebo_, "Cloud");
+    GLDebug::label(GL_BUFFER, instanceVbo_, "Cloud Instances");
+    GLDebug::label(GL_BUFFER, drawCommandBuffer_, "Cloud Draw Commands");
+}
+
+// One CloudInstance per instance: (position, rotationY) then (scale, alpha). The VAO must be bound.
+void Clouds::setInstanceAttributes(unsigned int instanceBuffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(CloudInstance), (void*)offsetof(CloudInstance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CloudInstance), (void*)offsetof(CloudInstance, scale));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
 }
 
 void Clouds::loadShaders() {
     const char* vsSource = R"GLSL(
 #version 330 core
 layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aPositionRotation; // xyz: position, w: rotation around Y
+layout(location = 2) in vec4 aScaleAlpha;       // xyz: scale, w: alpha
 uniform mat4 uProj;
 uniform mat4 uView;
-uniform mat4 uModel;
+uniform float uMeshRadius;
+uniform int uImpostorFirstVertex;
 
 out vec3 vWorldPos;
+out float vAlpha;
+out vec2 vImpostorCoord;
+flat out int vIsImpostor;
 
 void main() {
-    vec4 worldPos = uModel * vec4(aPos, 1.0);
-    vWorldPos = worldPos.xyz;
-    gl_Position = uProj * uView * worldPos;
+    vec3 worldPos;
+    vIsImpostor = gl_VertexID >= uImpostorFirstVertex ? 1 : 0;
+    vImpostorCoord = aPos.xy;
+    if (vIsImpostor != 0) {
+        // Quad facing the camera, as wide as the cloud and as high as it looks: its height seen from the side,
+        // its width seen from above.
+        vec3 right = vec3(uView[0][0], uView[1][0], uView[2][0]);
+        vec3 up = vec3(uView[0][1], uView[1][1], uView[2][1]);
+        float width = max(aScaleAlpha.x, aScaleAlpha.z);
+        float height = mix(width, aScaleAlpha.y, abs(up.y));
+        worldPos = aPositionRotation.xyz + (right * aPos.x * width + up * aPos.y * height) * uMeshRadius;
+    }
+    else {
+        // Same as translate * rotate(Y) * scale on the CPU.
+        vec3 p = aPos * aScaleAlpha.xyz;
+        float c = cos(aPositionRotation.w);
+        float s = sin(aPositionRotation.w);
+        worldPos = vec3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z) + aPositionRotation.xyz;
+    }
+    vWorldPos = worldPos;
+    vAlpha = aScaleAlpha.w;
+    gl_Position = uProj * uView * vec4(worldPos, 1.0);
 }
 )GLSL";
 
     const char* fsSource = R"GLSL(
 #version 330 core
 in vec3 vWorldPos;
+in float vAlpha;
+in vec2 vImpostorCoord;
+flat in int vIsImpostor;
 out vec4 FragColor;
 
-uniform float uAlpha;
 uniform vec3 uLightPos;
 uniform vec3 uLightColor;
 uniform float uLightIntensity;
@@ -200,7 +598,13 @@ void main() {
     
     float depth = distance(vWorldPos, uCameraPos);
     float depthFade = smoothstep(40.0, 60.0, depth);
-    float finalAlpha = uAlpha * 0.85 * (1.0 - depthFade * 0.5);
+    float finalAlpha = vAlpha * 0.85 * (1.0 - depthFade * 0.5);
+    if (vIsImpostor != 0) {
+        // Soft ellipse inscribed in the quad.
+        float r2 = dot(vImpostorCoord, vImpostorCoord);
+        if (r2 > 1.0) discard;
+        finalAlpha *= 1.0 - smoothstep(0.5, 1.0, r2);
+    }
     
     FragColor = vec4(litColor, finalAlpha);
 }
@@ -233,6 +637,7 @@ void main() {
     glAttachShader(shaderProgram_, vs);
     glAttachShader(shaderProgram_, fs);
     glLinkProgram(shaderProgram_);
+    GLDebug::label(GL_PROGRAM, shaderProgram_, "Cloud");
 
     glGetProgramiv(shaderProgram_, GL_LINK_STATUS, &success);
     if (!success) {
@@ -245,8 +650,8 @@ void main() {
 
     uProjLoc_ = glGetUniformLocation(shaderProgram_, "uProj");
     uViewLoc_ = glGetUniformLocation(shaderProgram_, "uView");
-    uModelLoc_ = glGetUniformLocation(shaderProgram_, "uModel");
-    uAlphaLoc_ = glGetUniformLocation(shaderProgram_, "uAlpha");
+    uMeshRadiusLoc_ = glGetUniformLocation(shaderProgram_, "uMeshRadius");
+    uImpostorFirstVertexLoc_ = glGetUniformLocation(shaderProgram_, "uImpostorFirstVertex");
 
     uLightPosLoc_ = glGetUniformLocation(shaderProgram_, "uLightPos");
     uLightColorLoc_ = glGetUniformLocation(shaderProgram_, "uLightColor");
@@ -255,38 +660,298 @@ void main() {
 }
 
 void Clouds::update(float deltaTime) {
-    for (auto& cloud : clouds_) {
-        cloud.lifetime += deltaTime;
-        if (cloud.lifetime < 4.0f) {
-            cloud.fadePhase = 0;
-            cloud.alpha = cloud.lifetime / 4.0f;
-        }
-        else if (cloud.lifetime < cloud.maxLifetime - 4.0f) {
-            cloud.fadePhase = 1;
-            cloud.alpha = 1.0f;
-        }
-        else if (cloud.lifetime < cloud.maxLifetime) {
-            cloud.fadePhase = 2;
-            cloud.alpha = (cloud.maxLifetime - cloud.lifetime) / 4.0f;
-        }
-        else {
-            spawnCloud(&cloud - &clouds_[0]);
-            continue;
-        }
-        glm::vec3 horizontalMovement = glm::vec3(cloud.direction.x, 0.0f, cloud.direction.z);
-        cloud.position += horizontalMovement * cloud.speed * deltaTime;
-        cloud.rotationY += cloud.rotationSpeedY * deltaTime;
-        cloud.floatOffset += cloud.floatSpeed * deltaTime;
-        float floatY = sin(cloud.floatOffset) * cloud.floatAmount;
-        cloud.position.y += floatY * deltaTime;
-        float maxDistance = 30.0f;
-        if (glm::length(cloud.position) > maxDistance) spawnCloud(&cloud - &clouds_[0]);
+    if (isGpuSimulation_) {
+        updateGpu(deltaTime);
+        return;
+    }
+    uint32_t nChunks = (uint32_t)randoms_.size();
+    JobSystem::get().parallelFor(nChunks, 1, [&](uint32_t first, uint32_t last) {
+        for (uint32_t chunk = first; chunk < last; chunk++) updateChunk(chunk, deltaTime);
+    });
+}
+
+// Same rules as before, without branches: the alpha ramp is min(fade in, 1, fade out), and a cloud that is
+// too old or too far is moved like the others, then overwritten by spawnCloud() after the loop.
+void Clouds::updateChunk(uint32_t chunk, float deltaTime) {
+    CloudArrays& c = clouds_;
+    uint32_t begin = chunk * UPDATE_CHUNK_SIZE;
+    uint32_t end = std::min(begin + UPDATE_CHUNK_SIZE, (uint32_t)c.size());
+    std::vector<uint32_t>& respawns = respawns_[chunk];
+    respawns.clear();
+    uint32_t i = begin;
+
+#if defined(__AVX2__)
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 maxDistance2 = _mm256_set1_ps(MAX_DISTANCE * MAX_DISTANCE);
+    for (; i + 8 <= end; i += 8) {
+        __m256 lifetime = _mm256_add_ps(_mm256_loadu_ps(&c.lifetime[i]), dt);
+        __m256 maxLifetime = _mm256_loadu_ps(&c.maxLifetime[i]);
+        __m256 alpha = _mm256_min_ps(_mm256_min_ps(_mm256_mul_ps(lifetime, quarter), one),
+            _mm256_mul_ps(_mm256_sub_ps(maxLifetime, lifetime), quarter));
+
+        __m256 step = _mm256_mul_ps(_mm256_loadu_ps(&c.speed[i]), dt);
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(&c.positionX[i]), _mm256_mul_ps(_mm256_loadu_ps(&c.directionX[i]), step));
+        __m256 z = _mm256_add_ps(_mm256_loadu_ps(&c.positionZ[i]), _mm256_mul_ps(_mm256_loadu_ps(&c.directionZ[i]), step));
+        __m256 floatOffset = _mm256_add_ps(_mm256_loadu_ps(&c.floatOffset[i]), _mm256_mul_ps(_mm256_loadu_ps(&c.floatSpeed[i]), dt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(&c.positionY[i]),
+            _mm256_mul_ps(_mm256_mul_ps(sinApprox(floatOffset), _mm256_loadu_ps(&c.floatAmount[i])), dt));
+        __m256 rotation = _mm256_add_ps(_mm256_loadu_ps(&c.rotationY[i]), _mm256_mul_ps(_mm256_loadu_ps(&c.rotationSpeedY[i]), dt));
+
+        _mm256_storeu_ps(&c.lifetime[i], lifetime);
+        _mm256_storeu_ps(&c.alpha[i], alpha);
+        _mm256_storeu_ps(&c.positionX[i], x);
+        _mm256_storeu_ps(&c.positionY[i], y);
+        _mm256_storeu_ps(&c.positionZ[i], z);
+        _mm256_storeu_ps(&c.floatOffset[i], floatOffset);
+        _mm256_storeu_ps(&c.rotationY[i], rotation);
+
+        __m256 distance2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+        __m256 isDone = _mm256_or_ps(_mm256_cmp_ps(lifetime, maxLifetime, _CMP_GE_OQ), _mm256_cmp_ps(distance2, maxDistance2, _CMP_GT_OQ));
+        appendRespawns(_mm256_movemask_ps(isDone), i, respawns);
+    }
+#elif defined(CLOUD_UPDATE_SSE2)
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 maxDistance2 = _mm_set1_ps(MAX_DISTANCE * MAX_DISTANCE);
+    for (; i + 4 <= end; i += 4) {
+        __m128 lifetime = _mm_add_ps(_mm_loadu_ps(&c.lifetime[i]), dt);
+        __m128 maxLifetime = _mm_loadu_ps(&c.maxLifetime[i]);
+        __m128 alpha = _mm_min_ps(_mm_min_ps(_mm_mul_ps(lifetime, quarter), one),
+            _mm_mul_ps(_mm_sub_ps(maxLifetime, lifetime), quarter));
+
+        __m128 step = _mm_mul_ps(_mm_loadu_ps(&c.speed[i]), dt);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&c.positionX[i]), _mm_mul_ps(_mm_loadu_ps(&c.directionX[i]), step));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(&c.positionZ[i]), _mm_mul_ps(_mm_loadu_ps(&c.directionZ[i]), step));
+        __m128 floatOffset = _mm_add_ps(_mm_loadu_ps(&c.floatOffset[i]), _mm_mul_ps(_mm_loadu_ps(&c.floatSpeed[i]), dt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&c.positionY[i]),
+            _mm_mul_ps(_mm_mul_ps(sinApprox(floatOffset), _mm_loadu_ps(&c.floatAmount[i])), dt));
+        __m128 rotation = _mm_add_ps(_mm_loadu_ps(&c.rotationY[i]), _mm_mul_ps(_mm_loadu_ps(&c.rotationSpeedY[i]), dt));
+
+        _mm_storeu_ps(&c.lifetime[i], lifetime);
+        _mm_storeu_ps(&c.alpha[i], alpha);
+        _mm_storeu_ps(&c.positionX[i], x);
+        _mm_storeu_ps(&c.positionY[i], y);
+        _mm_storeu_ps(&c.positionZ[i], z);
+        _mm_storeu_ps(&c.floatOffset[i], floatOffset);
+        _mm_storeu_ps(&c.rotationY[i], rotation);
+
+        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 isDone = _mm_or_ps(_mm_cmpge_ps(lifetime, maxLifetime), _mm_cmpgt_ps(distance2, maxDistance2));
+        appendRespawns(_mm_movemask_ps(isDone), i, respawns);
+    }
+#endif
+
+    for (; i < end; i++) {
+        float lifetime = c.lifetime[i] + deltaTime;
+        c.lifetime[i] = lifetime;
+        c.alpha[i] = std::min(std::min(lifetime * 0.25f, 1.0f), (c.maxLifetime[i] - lifetime) * 0.25f);
+
+        float step = c.speed[i] * deltaTime;
+        c.positionX[i] += c.directionX[i] * step;
+        c.positionZ[i] += c.directionZ[i] * step;
+        c.floatOffset[i] += c.floatSpeed[i] * deltaTime;
+        c.positionY[i] += sinApprox(c.floatOffset[i]) * c.floatAmount[i] * deltaTime;
+        c.rotationY[i] += c.rotationSpeedY[i] * deltaTime;
+
+        float distance2 = c.positionX[i] * c.positionX[i] + c.positionY[i] * c.positionY[i] + c.positionZ[i] * c.positionZ[i];
+        if (lifetime >= c.maxLifetime[i] || distance2 > MAX_DISTANCE * MAX_DISTANCE) respawns.push_back(i);
+    }
+
+    // Only a few clouds per step: they are respawned together, with the generator of the chunk.
+    Random& random = randoms_[chunk];
+    for (uint32_t index : respawns) spawnCloud(index, random);
+}
+
+const char* Clouds::getKernelName() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(CLOUD_UPDATE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// Visible clouds only: invisible ones (alpha) and those outside the frustum are skipped. The others are grouped by
+// LOD, each group after the finer ones in the instance buffer, with one indirect command per group.
+void Clouds::fillInstances(const glm::mat4& proj, const glm::mat4& view, const glm::vec3& cameraPos) {
+    Frustum frustum = Frustum::fromMatrix(proj * view);
+    float projScale = proj[1][1] * lodScale_;
+    const CloudArrays& c = clouds_;
+    for (std::vector<CloudInstance>& instances : lodInstances_) instances.clear();
+    for (size_t i = 0; i < c.size(); i++) {
+        if (c.alpha[i] <= 0.01f) continue;
+        glm::vec3 position(c.positionX[i], c.positionY[i], c.positionZ[i]);
+        glm::vec3 scale(c.scaleX[i], c.scaleY[i], c.scaleZ[i]);
+        float radius = meshRadius_ * std::max(scale.x, std::max(scale.y, scale.z));
+        if (!frustum.intersectsSphere(position, radius)) continue;
+        int lod = selectLod(radius * projScale / std::max(glm::distance(cameraPos, position), 0.001f));
+        lodInstances_[lod].push_back({ position, c.rotationY[i], scale, c.alpha[i] * 0.85f });
+    }
+
+    DrawCommand commands[LOD_COUNT];
+    drawnCloudCount_ = 0;
+    for (int lod = 0; lod < LOD_COUNT; lod++) {
+        commands[lod] = lodCommands_[lod];
+        commands[lod].instanceCount = (GLuint)lodInstances_[lod].size();
+        commands[lod].baseInstance = drawnCloudCount_;
+        drawnCloudCount_ += commands[lod].instanceCount;
+    }
+    if (drawnCloudCount_ == 0) return;
+
+    // The buffer only grows; it is orphaned each frame so the upload does not wait for the previous draw.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    instanceCapacity_ = std::max(instanceCapacity_, clouds_.size());
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity_ * sizeof(CloudInstance), nullptr, GL_STREAM_DRAW);
+    for (int lod = 0; lod < LOD_COUNT; lod++) {
+        if (lodInstances_[lod].empty()) continue;
+        glBufferSubData(GL_ARRAY_BUFFER, commands[lod].baseInstance * sizeof(CloudInstance),
+            lodInstances_[lod].size() * sizeof(CloudInstance), lodInstances_[lod].data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer_);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(commands), commands);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void Clouds::setGpuSimulation(bool isEnabled) {
+    if (isEnabled == isGpuSimulation_ || !vao_) return;
+    isGpuSimulation_ = isEnabled;
+    if (!isEnabled) return;
+
+    if (!updateProgram_) initGpuSimulation();
+    // The render instance only receives the render columns from the snapshots: setCloudCount() restarts
+    // every cloud in GPU mode, then uploads them.
+    setCloudCount(cloudCount_);
+}
+
+void Clouds::initGpuSimulation() {
+    updateProgram_ = createComputeProgram(UPDATE_SOURCE, "Cloud Update");
+    uUpdateCloudCountLoc_ = glGetUniformLocation(updateProgram_, "uCloudCount");
+    uUpdateDeltaTimeLoc_ = glGetUniformLocation(updateProgram_, "uDeltaTime");
+
+    cullProgram_ = createComputeProgram(CULL_SOURCE, "Cloud Cull");
+    uCullCloudCountLoc_ = glGetUniformLocation(cullProgram_, "uCloudCount");
+    uCullFrustumPlanesLoc_ = glGetUniformLocation(cullProgram_, "uFrustumPlanes");
+    uCullMeshRadiusLoc_ = glGetUniformLocation(cullProgram_, "uMeshRadius");
+    uCullCameraPosLoc_ = glGetUniformLocation(cullProgram_, "uCameraPos");
+    uCullProjScaleLoc_ = glGetUniformLocation(cullProgram_, "uProjScale");
+    uCullLodScreenSizesLoc_ = glGetUniformLocation(cullProgram_, "uLodScreenSizes");
+    uCullLodRangesLoc_ = glGetUniformLocation(cullProgram_, "uLodRanges");
+    uCullScatterLoc_ = glGetUniformLocation(cullProgram_, "uScatter");
+
+    glGenBuffers(1, &gpuStateBuffer_);
+    glGenBuffers(1, &gpuInstanceBuffer_);
+
+    // Same mesh as vao_, instances written by the cull pass.
+    glGenVertexArrays(1, &gpuVao_);
+    glBindVertexArray(gpuVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    setInstanceAttributes(gpuInstanceBuffer_);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLDebug::label(GL_VERTEX_ARRAY, gpuVao_, "Cloud GPU");
+    GLDebug::label(GL_BUFFER, gpuStateBuffer_, "Cloud States");
+    GLDebug::label(GL_BUFFER, gpuInstanceBuffer_, "Cloud GPU Instances");
+}
+
+// Only when the simulation starts or the count changes; the GPU owns the state afterwards.
+void Clouds::uploadGpuState() {
+    const CloudArrays& c = clouds_;
+    std::vector<GpuState> states(c.size());
+    for (size_t i = 0; i < c.size(); i++) {
+        GpuState& state = states[i];
+        state.positionRotation = glm::vec4(c.positionX[i], c.positionY[i], c.positionZ[i], c.rotationY[i]);
+        state.scaleAlpha = glm::vec4(c.scaleX[i], c.scaleY[i], c.scaleZ[i], c.alpha[i]);
+        state.motion = glm::vec4(c.directionX[i], c.directionZ[i], c.speed[i], c.rotationSpeedY[i]);
+        state.life = glm::vec4(c.lifetime[i], c.maxLifetime[i], c.floatOffset[i], c.floatSpeed[i]);
+        state.floatAmount = c.floatAmount[i];
+        // One xorshift state per cloud, never zero.
+        state.random = randoms_[i / UPDATE_CHUNK_SIZE].next() | 1u;
+        state.padding[0] = state.padding[1] = 0.0f;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuStateBuffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, states.size() * sizeof(GpuState), states.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuInstanceBuffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, states.size() * sizeof(CloudInstance), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Clouds::updateGpu(float deltaTime) {
+    if (cloudCount_ == 0) return;
+
+    glUseProgram(updateProgram_);
+    glUniform1ui(uUpdateCloudCountLoc_, cloudCount_);
+    glUniform1f(uUpdateDeltaTimeLoc_, deltaTime);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gpuStateBuffer_);
+    glDispatchCompute((cloudCount_ + CLOUD_GROUP_SIZE - 1) / CLOUD_GROUP_SIZE, 1, 1);
+    // Read by the cull pass and by the cloud shadows of the rocky floor.
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void Clouds::cullGpu(const glm::mat4& proj, const glm::mat4& view, const glm::vec3& cameraPos) {
+    Frustum frustum = Frustum::fromMatrix(proj * view);
+    GLuint lodRanges[LOD_COUNT * 2];
+    for (int lod = 0; lod < LOD_COUNT; lod++) {
+        lodRanges[2 * lod] = lodCommands_[lod].firstIndex;
+        lodRanges[2 * lod + 1] = lodCommands_[lod].count;
     }
+
+    // Commands and counts are cleared on the GPU; the second pass writes the commands back.
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, drawCommandBuffer_);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glUseProgram(cullProgram_);
+    glUniform1ui(uCullCloudCountLoc_, cloudCount_);
+    glUniform4fv(uCullFrustumPlanesLoc_, 6, glm::value_ptr(frustum.planes[0]));
+    glUniform1f(uCullMeshRadiusLoc_, meshRadius_);
+    glUniform3fv(uCullCameraPosLoc_, 1, glm::value_ptr(cameraPos));
+    glUniform1f(uCullProjScaleLoc_, proj[1][1] * lodScale_);
+    glUniform1fv(uCullLodScreenSizesLoc_, MESH_LOD_COUNT, LOD_SCREEN_SIZES);
+    glUniform2uiv(uCullLodRangesLoc_, LOD_COUNT, lodRanges);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gpuStateBuffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gpuInstanceBuffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, drawCommandBuffer_);
+    GLuint groupCount = (cloudCount_ + CLOUD_GROUP_SIZE - 1) / CLOUD_GROUP_SIZE;
+
+    glUniform1i(uCullScatterLoc_, GL_FALSE);
+    glDispatchCompute(groupCount, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUniform1i(uCullScatterLoc_, GL_TRUE);
+    glDispatchCompute(groupCount, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+// One indirect draw per LOD in a single call, from the finest. Both paths fill the same command buffer.
+void Clouds::drawInstances(int lodCount) {
+    glBindVertexArray(isGpuSimulation_ ? gpuVao_ : vao_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawCommandBuffer_);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, lodCount, sizeof(DrawCommand));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
 }
 
 void Clouds::draw(const glm::mat4& proj, const glm::mat4& view,
     const Light::LightSource& light, const glm::vec3& cameraPos) {
-    if (!shaderProgram_ || !vao_ || clouds_.empty()) return;
+    if (!shaderProgram_ || !vao_ || cloudCount_ == 0) return;
+
+    if (isGpuSimulation_) {
+        cullGpu(proj, view, cameraPos);
+    }
+    else {
+        fillInstances(proj, view, cameraPos);
+        if (drawnCloudCount_ == 0) return;
+    }
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -300,28 +965,15 @@ void Clouds::draw(const glm::mat4& proj, const glm::mat4& view,
 
     glUniformMatrix4fv(uProjLoc_, 1, GL_FALSE, glm::value_ptr(proj));
     glUniformMatrix4fv(uViewLoc_, 1, GL_FALSE, glm::value_ptr(view));
+    glUniform1f(uMeshRadiusLoc_, meshRadius_);
+    glUniform1i(uImpostorFirstVertexLoc_, (GLint)vertexCount_);
 
     if (uCameraPosLoc_ != -1) {
         glUniform3f(uCameraPosLoc_, cameraPos.x, cameraPos.y, cameraPos.z);
     }
     updateLightingUniforms(light);
 
-    glBindVertexArray(vao_);
-
-    for (auto& cloud : clouds_) {
-        if (cloud.alpha <= 0.01f) continue;
-
-        glUniform1f(uAlphaLoc_, cloud.alpha * 0.85f);
-
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), cloud.position);
-        model = glm::rotate(model, cloud.rotationY, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, cloud.scale);
-        glUniformMatrix4fv(uModelLoc_, 1, GL_FALSE, glm::value_ptr(model));
-
-        glDrawElements(GL_TRIANGLES, (GLsizei)indexCount_, GL_UNSIGNED_INT, 0);
-    }
-
-    glBindVertexArray(0);
+    drawInstances(LOD_COUNT);
     glDisable(GL_BLEND);
 }
 
@@ -337,10 +989,32 @@ void Clouds::updateLightingUniforms(const Light::LightSource& light) {
     }
 }
 
+// Reuses the instances filled by the last draw(). The impostors face the camera, not the light: they are skipped.
 void Clouds::drawShadow() {
-    if (!vao_) return;
+    if (!vao_ || (!isGpuSimulation_ && drawnCloudCount_ == 0)) return;
+    drawInstances(MESH_LOD_COUNT);
+}
 
-    glBindVertexArray(vao_);
-    glDrawElements(GL_TRIANGLES, (GLsizei)indexCount_, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+void benchmarkClouds() {
+    const unsigned int COUNTS[] = { 50, 500, 5000, 50000, 500000, 1000000 };
+    const float DELTA_TIME = 1.0f / 60.0f;
+    // About the same number of cloud updates for every count, and several lifetimes for the small ones.
+    const double UPDATES_PER_COUNT = 5e7;
+
+    std::cout << "Cloud update benchmark (" << Clouds::getKernelName() << ", "
+        << JobSystem::get().getThreadCount() << " threads, chunks of " << Clouds::UPDATE_CHUNK_SIZE << ")" << std::endl;
+
+    for (unsigned int count : COUNTS) {
+        Clouds clouds(count);
+        clouds.spawnClouds();
+        int nSteps = std::max(20, (int)(UPDATES_PER_COUNT / count));
+        clouds.update(DELTA_TIME);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < nSteps; step++) clouds.update(DELTA_TIME);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << "  " << count << " clouds: " << elapsed.count() * 1e3 / nSteps << " ms/step, "
+            << elapsed.count() * 1e9 / ((double)count * nSteps) << " ns/cloud" << std::endl;
+    }
+}
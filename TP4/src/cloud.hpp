@@ -1,6 +1,7 @@
 #ifndef CLOUD_HPP
 #define CLOUD_HPP
 
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 #include <inf2705/OpenGLApplication.hpp>
@@ -22,29 +23,36 @@ struct Cloud {
     float alpha;
 };
 
+// Nuages en SoA. Les huit premières colonnes sont celles que lit le rendu : ce sont les seules copiées dans les
+// instantanés. La direction est horizontale, seuls x et z sont gardés.
+struct CloudArrays {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationY;
+    std::vector<float> scaleX, scaleY, scaleZ;
+    std::vector<float> alpha;
+
+    std::vector<float> directionX, directionZ;
+    std::vector<float> speed;
+    std::vector<float> lifetime, maxLifetime;
+    std::vector<float> rotationSpeedY;
+    std::vector<float> floatOffset, floatSpeed, floatAmount;
+
+    size_t size() const { return positionX.size(); }
+};
+
 class Clouds {
 public:
-    struct CloudData {
-        glm::vec3 position;
-        glm::vec3 direction;
-        float speed;
-        float lifetime;
-        float maxLifetime;
-        float fadePhase;
-        float alpha;
-        glm::vec3 scale;
-        float rotationY;
-        float rotationSpeedY;
-        float floatOffset;
-        float floatSpeed;
-        float floatAmount;
-    };
-
     Clouds();
     Clouds(unsigned int cloudCount);
     ~Clouds();
 
     void initialize();
+    // Crée les nuages sans ressource OpenGL, pour une instance qui ne fait que simuler.
+    void spawnClouds();
+    // Garde les nuages existants et fait apparaître ceux qui s'ajoutent.
+    void setCloudCount(unsigned int cloudCount);
+    // Vectorisée (AVX2, SSE2 ou scalaire selon la compilation). Par tranches de UPDATE_CHUNK_SIZE nuages, réparties
+    // sur le JobSystem quand il y en a plusieurs.
     void update(float deltaTime);
     void draw(const glm::mat4& proj, const glm::mat4& view,
         const Light::LightSource& light, const glm::vec3& cameraPos);
@@ -52,28 +60,138 @@ public:
     void updateLightingUniforms(const Light::LightSource& light);
 
     unsigned int getCloudCount() const { return cloudCount_; }
-    const CloudData& getCloud(unsigned int index) const {
-        if (index < clouds_.size()) return clouds_[index];
-        static CloudData empty;
-        return empty;
-    }
+    // Nuages soumis au dernier draw(), après l'élimination par le frustum.
+    unsigned int getDrawnCloudCount() const { return drawnCloudCount_; }
+    // Par niveau de détail, les imposteurs en dernier. Simulation CPU seulement : le GPU ne renvoie pas ses comptes.
+    unsigned int getDrawnLodCount(int lod) const { return (unsigned int)lodInstances_[lod].size(); }
+    // Multiplie la taille à l'écran qui choisit le niveau de détail : plus grand garde les maillages fins plus loin.
+    void setLodScale(float scale) { lodScale_ = scale; }
+    float getLodScale() const { return lodScale_; }
+    const CloudArrays& getClouds() const { return clouds_; }
+    // Seulement les colonnes du rendu, sans réallocation une fois la taille atteinte.
+    void copyRenderState(CloudArrays& state) const;
+    void setRenderState(const CloudArrays& state);
+
+    // Simulation par nuanceur de calcul : l'état vit dans un SSBO, update() ne fait qu'une répartition et draw() dessine
+    // les instances que le GPU a écrites. Aucun travail par nuage sur le CPU, aucun envoi par trame. L'activer fait
+    // réapparaître tous les nuages. Fil OpenGL seulement.
+    void setGpuSimulation(bool isEnabled);
+    bool isGpuSimulation() const { return isGpuSimulation_; }
+    // SSBO des états (CloudState dans les nuanceurs), lu par RockyFloor pour les ombres. 0 sans simulation GPU.
+    unsigned int getGpuStateBuffer() const { return isGpuSimulation_ ? gpuStateBuffer_ : 0; }
+
+    static const char* getKernelName();
+
+    static constexpr uint32_t UPDATE_CHUNK_SIZE = 16384;
+    // Niveaux de l'icosphère du plus fin au plus grossier, puis un imposteur (quad face à la caméra).
+    static constexpr int MESH_LOD_COUNT = 4;
+    static constexpr int LOD_COUNT = MESH_LOD_COUNT + 1;
+
 private:
-    void spawnCloud(unsigned int index);
+    // Attributs par instance, lus avec un diviseur de 1 : la matrice modèle est composée dans le nuanceur.
+    struct CloudInstance {
+        glm::vec3 position;
+        float rotationY;
+        glm::vec3 scale;
+        float alpha;
+    };
+
+    // xorshift32 : quelques opérations entières par tirage au lieu de rand(). Un générateur par tranche de update(),
+    // pour que les réapparitions ne dépendent pas du nombre de fils.
+    struct Random {
+        uint32_t state = 1;
+
+        uint32_t next() {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        float uniform(float min, float max) {
+            return min + (next() >> 8) * (1.0f / 16777216.0f) * (max - min);
+        }
+    };
+
+    // Même disposition que CloudState dans les nuanceurs (std430).
+    struct GpuState {
+        glm::vec4 positionRotation;
+        glm::vec4 scaleAlpha;
+        glm::vec4 motion;
+        glm::vec4 life;
+        float floatAmount;
+        uint32_t random;
+        float padding[2];
+    };
+
+    // Comme DrawElementsIndirectCommand.
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Contenu du tampon des commandes indirectes, même disposition que DrawCommands dans le nuanceur d'élimination.
+    // Une commande par niveau de détail, leurs instances à la suite dans le même tampon. lodCounts ne sert qu'au GPU.
+    struct DrawCommands {
+        DrawCommand commands[LOD_COUNT];
+        GLuint lodCounts[LOD_COUNT];
+    };
+
+    void spawnCloud(uint32_t index, Random& random);
+    void updateChunk(uint32_t chunk, float deltaTime);
+    void fillInstances(const glm::mat4& proj, const glm::mat4& view, const glm::vec3& cameraPos);
     void initBuffers();
     void loadShaders();
+    void setInstanceAttributes(unsigned int instanceBuffer);
 
-    std::vector<CloudData> clouds_;
+    void initGpuSimulation();
+    void uploadGpuState();
+    void updateGpu(float deltaTime);
+    void cullGpu(const glm::mat4& proj, const glm::mat4& view, const glm::vec3& cameraPos);
+    void drawInstances(int lodCount);
+
+    CloudArrays clouds_;
     unsigned int cloudCount_;
+    std::vector<Random> randoms_;
+    // Nuages à faire réapparaître, par tranche ; vidées sans libérer leur mémoire.
+    std::vector<std::vector<uint32_t>> respawns_;
 
     unsigned int vao_ = 0;
     unsigned int vbo_ = 0;
     unsigned int ebo_ = 0;
+    unsigned int instanceVbo_ = 0;
     unsigned int shaderProgram_ = 0;
 
+    unsigned int drawCommandBuffer_ = 0;
+    std::vector<CloudInstance> lodInstances_[LOD_COUNT];
+    size_t instanceCapacity_ = 0;
+    unsigned int drawnCloudCount_ = 0;
+    float lodScale_ = 1.0f;
+
+    bool isGpuSimulation_ = false;
+    unsigned int gpuVao_ = 0;
+    unsigned int gpuStateBuffer_ = 0;
+    unsigned int gpuInstanceBuffer_ = 0;
+    unsigned int updateProgram_ = 0;
+    unsigned int cullProgram_ = 0;
+    GLint uUpdateCloudCountLoc_ = -1;
+    GLint uUpdateDeltaTimeLoc_ = -1;
+    GLint uCullCloudCountLoc_ = -1;
+    GLint uCullFrustumPlanesLoc_ = -1;
+    GLint uCullMeshRadiusLoc_ = -1;
+    GLint uCullCameraPosLoc_ = -1;
+    GLint uCullProjScaleLoc_ = -1;
+    GLint uCullLodScreenSizesLoc_ = -1;
+    GLint uCullLodRangesLoc_ = -1;
+    GLint uCullScatterLoc_ = -1;
+
     GLint uProjLoc_ = -1;
     GLint uViewLoc_ = -1;
-    GLint uModelLoc_ = -1;
-    GLint uAlphaLoc_ = -1;
+    GLint uMeshRadiusLoc_ = -1;
+    GLint uImpostorFirstVertexLoc_ = -1;
     GLint uLightPosLoc_;
     GLint uLightColorLoc_;
     GLint uLightIntensityLoc_;
@@ -84,7 +202,13 @@ private:
     GLint uShadowSoftnessLoc_;
 
     size_t vertexCount_ = 0;
-    size_t indexCount_ = 0;
+    // Plage d'indices de chaque niveau ; instanceCount et baseInstance sont remplis à chaque trame.
+    DrawCommand lodCommands_[LOD_COUNT] = {};
+    // Rayon de la sphère englobante du maillage, avant l'échelle de l'instance.
+    float meshRadius_ = 1.0f;
 };
 
+// Mesure update() de 50 à 1M nuages et affiche le temps par pas et par nuage.
+void benchmarkClouds();
+
 #endif
\ No newline at end of file
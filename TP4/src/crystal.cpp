@@ -6,7 +6,7 @@ using namespace gl;
 using namespace glm;
 
 Crystal::Crystal()
-    : position(0.0f, 0.0f, 0.0f), orientation(0.0f, 0.0f)
+    : renderPosition(0.0f, 0.0f, 0.0f), renderOrientation(0.0f, 0.0f)
 {
 }
 
@@ -15,14 +15,40 @@ void Crystal::loadModels()
     crystal_.load("../models/crystal.ply");
 }
 
-void Crystal::update(float deltaTime)
+void CrystalState::update(float deltaTime)
 {
+    previousPosition = position;
+    previousOrientation = orientation;
+
     orientation.y += rotationSpeed * deltaTime;
 
     floatPhase += floatSpeed * deltaTime * glm::two_pi<float>();
     position.y = sin(floatPhase) * floatAmplitude;
 }
 
+CrystalMotion CrystalState::getMotion() const
+{
+    return { rotationSpeed, floatSpeed, floatAmplitude };
+}
+
+void CrystalState::setMotion(const CrystalMotion& motion)
+{
+    rotationSpeed = motion.rotationSpeed;
+    floatSpeed = motion.floatSpeed;
+    floatAmplitude = motion.floatAmplitude;
+}
+
+void Crystal::setState(const CrystalState& state)
+{
+    static_cast<CrystalState&>(*this) = state;
+}
+
+void Crystal::interpolate(float alpha)
+{
+    renderPosition = glm::mix(previousPosition, position, alpha);
+    renderOrientation = glm::mix(previousOrientation, orientation, alpha);
+}
+
 void Crystal::draw()
 {
     crystal_.draw();
@@ -5,14 +5,46 @@
 
 #include "model.hpp"
 
-class Crystal
+// Paramètres de l'interface, envoyés au fil de simulation.
+struct CrystalMotion
+{
+    float rotationSpeed = glm::radians(20.f);
+    float floatSpeed = 0.2f;
+    float floatAmplitude = 0.25f;
+};
+
+// État simulé du cristal, sans ressource OpenGL: il peut avancer sur le fil de simulation et être copié tel quel
+// dans un instantané pour le rendu.
+struct CrystalState
+{
+    void update(float deltaTime);
+
+    CrystalMotion getMotion() const;
+    void setMotion(const CrystalMotion& motion);
+
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec2 orientation = glm::vec2(0.0f);
+    glm::vec3 previousPosition = glm::vec3(0.0f);
+    glm::vec2 previousOrientation = glm::vec2(0.0f);
+
+    float rotationSpeed = glm::radians(20.f);
+    float floatSpeed = 0.2f;
+    float floatAmplitude = 0.25f;
+    float floatPhase = 0.0f;
+};
+
+class Crystal : public CrystalState
 {
 public:
     Crystal();
 
     void loadModels();
 
-    void update(float deltaTime);
+    // Remplace l'état simulé, par exemple par celui d'un instantané.
+    void setState(const CrystalState& state);
+
+    // Calcule renderPosition et renderOrientation entre l'état précédent et l'état courant (alpha dans [0, 1]).
+    void interpolate(float alpha);
 
     void draw();
     void drawShadow();
@@ -30,13 +62,8 @@ private:
     size_t vertexCount_ = 0;
 
 public:
-    glm::vec3 position;
-    glm::vec2 orientation;
-
-    float rotationSpeed = glm::radians(20.f);
-    float floatSpeed = 0.2f;
-    float floatAmplitude = 0.25f;
-    float floatPhase = 0.0f;
+    glm::vec3 renderPosition;
+    glm::vec2 renderOrientation;
 
     std::vector<float> vertices;
     std::vector<unsigned int> indices;
@@ -2,8 +2,11 @@
 #include <cstdint>
 
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <iostream>
+#include <memory_resource>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -15,6 +18,8 @@
 
 #include <imgui/imgui.h>
 
+// Compte les appels à new pour le panneau Memory du profileur.
+#define INF2705_ALLOCATION_COUNTER_IMPLEMENTATION
 #include <inf2705/OpenGLApplication.hpp>
 
 #include "model.hpp"
@@ -23,8 +28,7 @@
 #include "cloud.hpp"
 #include "light.hpp"
 #include "audiovisualizer.hpp"
-
-#define CHECK_GL_ERROR printGLError(__FILE__, __LINE__)
+#include "../../TP1-3/src/particle_system.hpp"
 
 using namespace gl;
 using namespace glm;
@@ -81,12 +85,51 @@ struct App : public OpenGLApplication
         crystal_.colorModUniformLocation = colorModUniformLocation_;
 
         rockyFloor_.initialize();
-        clouds_ = Clouds(50);
+        clouds_ = Clouds(DEFAULT_CLOUD_COUNT);
         clouds_.initialize();
+        simulatedClouds_ = Clouds(DEFAULT_CLOUD_COUNT);
+        simulatedClouds_.spawnClouds();
+        resetSnapshots();
+
+        initSparkles();
 
         audioViz_.loadMusic("lofi-lofi-chill-lofi-girl-438671.mp3"); //Royalty-free music de https://pixabay.com/music/search/lofi/
     }
 
+    // Scène de stress (--stress, --benchmark): clouds, clouds_gpu (0 ou 1), terrain_extent, terrain_patches (par côté)
+    // et terrain_tess.
+    // Appelée avant le démarrage du fil de simulation, qui est désactivé pendant le banc d'essai.
+    void applyStressConfig(const StressConfig& config) override
+    {
+        unsigned int nClouds = static_cast<unsigned int>(std::max(0, config.getInt("clouds", DEFAULT_CLOUD_COUNT)));
+        simulatedClouds_.setCloudCount(nClouds);
+        clouds_.setCloudCount(nClouds);
+        setCloudGpuSimulation(config.getInt("clouds_gpu", 0) != 0);
+        resetSnapshots();
+
+        float extent = config.get("terrain_extent", RockyFloor::DEFAULT_EXTENT);
+        int patchesPerSide = config.getInt("terrain_patches", RockyFloor::DEFAULT_PATCHES_PER_SIDE);
+        rockyFloor_.configure(extent, patchesPerSide, config.get("terrain_tess", 1.0f));
+
+        std::cout << "Stress: " << nClouds << (clouds_.isGpuSimulation() ? " GPU" : "") << " clouds, terrain " << extent << " m, "
+            << patchesPerSide * patchesPerSide << " patches" << std::endl;
+    }
+
+    // Sur le GPU, les nuages sont simulés dans fixedUpdate() et le fil de simulation ne les touche plus.
+    void setCloudGpuSimulation(bool isEnabled)
+    {
+        clouds_.setGpuSimulation(isEnabled);
+        isCloudGpuSimulation_.store(clouds_.isGpuSimulation());
+    }
+
+    // Les trois instantanés partent de l'état simulé courant.
+    void resetSnapshots()
+    {
+        SceneSnapshot snapshot = { simulatedCrystal_, {}, 0.0 };
+        simulatedClouds_.copyRenderState(snapshot.clouds);
+        snapshots_.reset(snapshot);
+    }
+
     void checkShaderCompilingError(const char* name, GLuint id)
     {
         GLint success;
@@ -115,12 +158,41 @@ struct App : public OpenGLApplication
         }
     }
 
+    // Cristal et nuages au pas fixe, sur le fil de simulation si --sim-thread. Le rendu ne lit que les instantanés.
+    void simulate(float fixedDeltaTime) override
+    {
+        if (crystalMotion_.acquire())
+            simulatedCrystal_.setMotion(crystalMotion_.getReadBuffer());
+        simulatedCrystal_.update(fixedDeltaTime);
+        bool isCloudOnCpu = !isCloudGpuSimulation_.load();
+        if (isCloudOnCpu)
+            simulatedClouds_.update(fixedDeltaTime);
+
+        SceneSnapshot& snapshot = snapshots_.getWriteBuffer();
+        snapshot.crystal = simulatedCrystal_;
+        if (isCloudOnCpu)
+            simulatedClouds_.copyRenderState(snapshot.clouds);
+        snapshot.publishTime = getElapsedTime();
+        snapshots_.publish();
+    }
+
+    // Pas fixe du côté OpenGL: les étincelles sont simulées sur le GPU.
+    void fixedUpdate(float fixedDeltaTime) override
+    {
+        snapshots_.acquire();
+        sparkles_.getEmitter(sparkleEmitter_).transform = glm::translate(glm::mat4(1.0f), snapshots_.getReadBuffer().crystal.position);
+        sparkles_.update(static_cast<float>(getSimulationTime()), fixedDeltaTime);
+        if (clouds_.isGpuSimulation())
+            clouds_.update(fixedDeltaTime);
+    }
+
     void drawFrame() override
     {
-        static sf::Time lastTime = clock.getElapsedTime();
-        sf::Time now = clock.getElapsedTime();
-        deltaTime_ = (now - lastTime).asSeconds();
-        lastTime = now;
+        snapshots_.acquire();
+        const SceneSnapshot& snapshot = snapshots_.getReadBuffer();
+        crystal_.setState(snapshot.crystal);
+        if (!clouds_.isGpuSimulation())
+            clouds_.setRenderState(snapshot.clouds);
 
         audioViz_.update(deltaTime_);
 
@@ -137,6 +209,18 @@ struct App : public OpenGLApplication
 
         ImGui::Begin("Scene Parameters");
 
+        if (ImGui::Button("Screenshot"))
+            saveScreenshot();
+        ImGui::SameLine();
+        if (ImGui::Button(isRecording() ? "Stop Recording" : "Record"))
+        {
+            if (isRecording())
+                stopRecording();
+            else
+                startRecording("recording.y4m");
+        }
+        ImGui::Separator();
+
         if (audioViz_.isMusicLoaded()) {
             if (ImGui::Button(audioViz_.isMusicPlaying() ? "Pause Music" : "Play Music")) {
                 audioViz_.togglePlayback();
@@ -153,14 +237,24 @@ struct App : public OpenGLApplication
             ImGui::Text("No audio file loaded");
         }
 
+        // Les paramètres partent de l'état affiché et ne sont envoyés à simulate() que s'ils changent.
+        CrystalMotion motion = crystal_.getMotion();
+        bool isMotionChanged = false;
+
         ImGui::Text("Vitesse Rotation");
-        ImGui::SliderFloat("##RotationSpeed", &crystal_.rotationSpeed, 0.0f, 5.0f);
+        isMotionChanged |= ImGui::SliderFloat("##RotationSpeed", &motion.rotationSpeed, 0.0f, 5.0f);
 
         ImGui::Text("Vitesse Flottaison");
-        ImGui::SliderFloat("##FloatSpeed", &crystal_.floatSpeed, 0.0f, 5.0f);
+        isMotionChanged |= ImGui::SliderFloat("##FloatSpeed", &motion.floatSpeed, 0.0f, 5.0f);
 
         ImGui::Text("Amplitude Flottaison");
-        ImGui::SliderFloat("##FloatAmplitude", &crystal_.floatAmplitude, 0.0f, 1.0f);
+        isMotionChanged |= ImGui::SliderFloat("##FloatAmplitude", &motion.floatAmplitude, 0.0f, 1.0f);
+
+        if (isMotionChanged) {
+            crystal_.setMotion(motion);
+            crystalMotion_.getWriteBuffer() = motion;
+            crystalMotion_.publish();
+        }
 
         ImGui::Separator();
         ImGui::Text("Lumiere/ombres");
@@ -190,6 +284,22 @@ struct App : public OpenGLApplication
         ImGui::Separator();
         ImGui::Checkbox("Enable ombres", &sunLight.castShadows);
 
+        ImGui::Separator();
+        bool isCloudGpuSimulation = clouds_.isGpuSimulation();
+        if (ImGui::Checkbox("Nuages simules sur le GPU", &isCloudGpuSimulation))
+            setCloudGpuSimulation(isCloudGpuSimulation);
+        if (isCloudGpuSimulation)
+            ImGui::Text("Nuages: %u (elimines sur le GPU)", clouds_.getCloudCount());
+        else {
+            ImGui::Text("Nuages dessines: %u / %u", clouds_.getDrawnCloudCount(), clouds_.getCloudCount());
+            ImGui::Text("Par LOD: %u / %u / %u / %u, imposteurs: %u", clouds_.getDrawnLodCount(0),
+                clouds_.getDrawnLodCount(1), clouds_.getDrawnLodCount(2), clouds_.getDrawnLodCount(3),
+                clouds_.getDrawnLodCount(Clouds::MESH_LOD_COUNT));
+        }
+        float cloudLodScale = clouds_.getLodScale();
+        if (ImGui::SliderFloat("Echelle des LOD", &cloudLodScale, 0.1f, 4.0f))
+            clouds_.setLodScale(cloudLodScale);
+
         ImGui::End();
 
         sceneMain();
@@ -204,6 +314,7 @@ struct App : public OpenGLApplication
         if (crystalTexture_) glDeleteTextures(1, &crystalTexture_);
         if (crystalNormalTexture_) glDeleteTextures(1, &crystalNormalTexture_);
         if (crystalRoughnessTexture_) glDeleteTextures(1, &crystalRoughnessTexture_);
+        if (sparkleTexture_) glDeleteTextures(1, &sparkleTexture_);
     }
 
     void onKeyPress(const sf::Event::KeyPressed& key) override
@@ -268,6 +379,7 @@ struct App : public OpenGLApplication
 
         glGenTextures(1, &crystalTexture_);
         glBindTexture(GL_TEXTURE_2D, crystalTexture_);
+        GLDebug::label(GL_TEXTURE, crystalTexture_, "Crystal Color");
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -288,6 +400,7 @@ struct App : public OpenGLApplication
             imgNormal.flipVertically();
             glGenTextures(1, &crystalNormalTexture_);
             glBindTexture(GL_TEXTURE_2D, crystalNormalTexture_);
+            GLDebug::label(GL_TEXTURE, crystalNormalTexture_, "Crystal Normal");
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -309,6 +422,7 @@ struct App : public OpenGLApplication
             imgRoughness.flipVertically();
             glGenTextures(1, &crystalRoughnessTexture_);
             glBindTexture(GL_TEXTURE_2D, crystalRoughnessTexture_);
+            GLDebug::label(GL_TEXTURE, crystalRoughnessTexture_, "Crystal Roughness");
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -326,9 +440,61 @@ struct App : public OpenGLApplication
         crystal_.setRoughnessTexture(crystalRoughnessTexture_);
     }
 
+    // Étincelles autour du cristal, avec le système de particules de TP1-3.
+    void initSparkles()
+    {
+        // Point lumineux en croix généré plutôt que chargé.
+        const int SIZE = 32;
+        std::vector<unsigned char> pixels(SIZE * SIZE * 4);
+        for (int y = 0; y < SIZE; y++)
+        {
+            for (int x = 0; x < SIZE; x++)
+            {
+                float u = (x + 0.5f) / SIZE * 2.0f - 1.0f;
+                float v = (y + 0.5f) / SIZE * 2.0f - 1.0f;
+                float glow = glm::max(0.0f, 1.0f - glm::length(glm::vec2(u, v)));
+                float cross = glm::max(0.0f, 1.0f - glm::abs(u * v) * 40.0f) * (1.0f - glm::max(glm::abs(u), glm::abs(v)));
+                float alpha = glm::clamp(glow * glow + cross, 0.0f, 1.0f);
+
+                unsigned char* pixel = &pixels[(y * SIZE + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = 255;
+                pixel[3] = static_cast<unsigned char>(alpha * 255.0f);
+            }
+        }
+
+        glGenTextures(1, &sparkleTexture_);
+        glBindTexture(GL_TEXTURE_2D, sparkleTexture_);
+        GLDebug::label(GL_TEXTURE, sparkleTexture_, "Sparkle");
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SIZE, SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        sparkles_.init(1 << 12, "../../TP1-3/src/shaders/");
+        sparkles_.setAtlas(sparkleTexture_, 1, 1);
+
+        ParticleEmitter emitter;
+        emitter.velocity = glm::vec3(0.0f, 0.6f, 0.0f);
+        emitter.velocitySpread = 0.8f;
+        emitter.spawnRate = 40.0f;
+        emitter.lifetime = glm::vec2(0.8f, 1.6f);
+        emitter.colorStart = glm::vec4(0.9f, 0.7f, 1.0f, 1.0f);
+        emitter.colorEnd = glm::vec4(0.6f, 0.3f, 1.0f, 0.0f);
+        emitter.sizeStart = glm::vec2(0.15f);
+        emitter.sizeEnd = glm::vec2(0.02f);
+        sparkleEmitter_ = sparkles_.addEmitter(emitter);
+    }
+
+    void drawSparkles(const glm::mat4& proj, const glm::mat4& view)
+    {
+        sparkles_.draw(view, proj);
+    }
+
     void updateCameraInput()
     {
-        if (!window_.hasFocus())
+        if (!hasFocus())
             return;
 
         if (isMouseMotionEnabled_)
@@ -343,13 +509,13 @@ struct App : public OpenGLApplication
 
         const float KEYBOARD_MOUSE_SENSITIVITY = 1.5f;
 
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Up))
+        if (isKeyPressed(sf::Keyboard::Key::Up))
             cameraMouvementX -= KEYBOARD_MOUSE_SENSITIVITY;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Down))
+        if (isKeyPressed(sf::Keyboard::Key::Down))
             cameraMouvementX += KEYBOARD_MOUSE_SENSITIVITY;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Left))
+        if (isKeyPressed(sf::Keyboard::Key::Left))
             cameraMouvementY -= KEYBOARD_MOUSE_SENSITIVITY;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Right))
+        if (isKeyPressed(sf::Keyboard::Key::Right))
             cameraMouvementY += KEYBOARD_MOUSE_SENSITIVITY;
 
         cameraOrientation_.y -= cameraMouvementY * deltaTime_;
@@ -359,39 +525,39 @@ struct App : public OpenGLApplication
         const float SPEED = 10.f;
         if (isQWERTY_)
         {
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::W))
+            if (isKeyPressed(sf::Keyboard::Key::W))
                 positionOffset.z -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S))
+            if (isKeyPressed(sf::Keyboard::Key::S))
                 positionOffset.z += SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A))
+            if (isKeyPressed(sf::Keyboard::Key::A))
                 positionOffset.x -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
+            if (isKeyPressed(sf::Keyboard::Key::D))
                 positionOffset.x += SPEED;
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q))
+            if (isKeyPressed(sf::Keyboard::Key::Q))
                 positionOffset.y -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::E))
+            if (isKeyPressed(sf::Keyboard::Key::E))
                 positionOffset.y += SPEED;
         }
         else {
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Z))
+            if (isKeyPressed(sf::Keyboard::Key::Z))
                 positionOffset.z -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::S))
+            if (isKeyPressed(sf::Keyboard::Key::S))
                 positionOffset.z += SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q))
+            if (isKeyPressed(sf::Keyboard::Key::Q))
                 positionOffset.x -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
+            if (isKeyPressed(sf::Keyboard::Key::D))
                 positionOffset.x += SPEED;
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::A))
+            if (isKeyPressed(sf::Keyboard::Key::A))
                 positionOffset.y -= SPEED;
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::E))
+            if (isKeyPressed(sf::Keyboard::Key::E))
                 positionOffset.y += SPEED;
         }
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LControl))
+        if (isKeyPressed(sf::Keyboard::Key::LControl))
             positionOffset.y -= SPEED;
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::LShift))
+        if (isKeyPressed(sf::Keyboard::Key::LShift))
             positionOffset.y += SPEED;
 
         positionOffset = glm::rotate(glm::mat4(1.0f), cameraOrientation_.y, glm::vec3(0.0, 1.0, 0.0)) * glm::vec4(positionOffset, 1);
@@ -421,6 +587,7 @@ struct App : public OpenGLApplication
         glAttachShader(basicSP_, vs);
         glAttachShader(basicSP_, fs);
         glLinkProgram(basicSP_);
+        GLDebug::label(GL_PROGRAM, basicSP_, "Basic");
         checkProgramLinkingError("basicSP", basicSP_);
         glDetachShader(basicSP_, vs);
         glDetachShader(basicSP_, fs);
@@ -436,6 +603,7 @@ struct App : public OpenGLApplication
         glAttachShader(transformSP_, vs2);
         glAttachShader(transformSP_, fs2);
         glLinkProgram(transformSP_);
+        GLDebug::label(GL_PROGRAM, transformSP_, "Transform");
         checkProgramLinkingError("transformSP", transformSP_);
         glDetachShader(transformSP_, vs2);
         glDetachShader(transformSP_, fs2);
@@ -457,6 +625,7 @@ struct App : public OpenGLApplication
         glAttachShader(crystalShaderProgram_, vs3);
         glAttachShader(crystalShaderProgram_, fs3);
         glLinkProgram(crystalShaderProgram_);
+        GLDebug::label(GL_PROGRAM, crystalShaderProgram_, "Crystal");
         checkProgramLinkingError("crystalShader", crystalShaderProgram_);
         glDetachShader(crystalShaderProgram_, vs3);
         glDetachShader(crystalShaderProgram_, fs3);
@@ -475,10 +644,8 @@ struct App : public OpenGLApplication
     void drawCrystal(glm::mat4& projView) {
         glUseProgram(crystalShaderProgram_);
 
-        crystal_.update(deltaTime_);
-
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), crystal_.position);
-        model = glm::rotate(model, crystal_.orientation.y, glm::vec3(0.f, 1.f, 0.f));
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), crystal_.renderPosition);
+        model = glm::rotate(model, crystal_.renderOrientation.y, glm::vec3(0.f, 1.f, 0.f));
         model = glm::scale(model, glm::vec3(4.0f));
 
         glm::mat4 mvp = projView * model;
@@ -553,42 +720,78 @@ struct App : public OpenGLApplication
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 
+    // Trajet scripté du banc d'essai: un tour en orbite autour du cratère pendant la mesure.
+    void updateBenchmarkCamera()
+    {
+        float angle = 2.0f * M_PI * getBenchmarkProgress();
+        float radius = 0.4f * rockyFloor_.getExtent();
+        cameraPosition_ = glm::vec3(radius * std::cos(angle), 10.0f, radius * std::sin(angle));
+
+        glm::vec3 direction = -cameraPosition_;
+        cameraOrientation_.y = M_PI + atan2(direction.x, direction.z);
+        float horizontalDistance = sqrt(direction.x * direction.x + direction.z * direction.z);
+        cameraOrientation_.x = atan2(direction.y, horizontalDistance);
+    }
+
     void sceneMain()
     {
-        updateCameraInput();
+        if (isBenchmarking())
+            updateBenchmarkCamera();
+        else
+            updateCameraInput();
+        crystal_.interpolate(getInterpolationAlpha(snapshots_.getReadBuffer().publishTime));
 
         glm::mat4 proj = getPerspectiveProjectionMatrix();
         glm::mat4 view = getViewMatrix();
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        std::vector<glm::vec3> cloudPositions;
-        std::vector<float> cloudSizes;
-        std::vector<float> cloudAlphas;
-
-        for (int i = 0; i < clouds_.getCloudCount(); i++) {
-            auto cloud = clouds_.getCloud(i);
-            if (cloud.alpha > 0.01f) {
-                cloudPositions.push_back(cloud.position);
-                cloudSizes.push_back(cloud.scale.x);
-                cloudAlphas.push_back(cloud.alpha);
+        // Tableaux de la trame seulement : ils viennent de l'arène, pas du tas.
+        std::pmr::vector<glm::vec3> cloudPositions(&getFrameArena());
+        std::pmr::vector<float> cloudSizes(&getFrameArena());
+        std::pmr::vector<float> cloudAlphas(&getFrameArena());
+        size_t nCpuClouds = clouds_.isGpuSimulation() ? 0 : clouds_.getCloudCount();
+        cloudPositions.reserve(nCpuClouds);
+        cloudSizes.reserve(nCpuClouds);
+        cloudAlphas.reserve(nCpuClouds);
+
+        // Sur le GPU, le sol lit directement le tampon des nuages.
+        rockyFloor_.setCloudStateBuffer(clouds_.getGpuStateBuffer(), clouds_.getCloudCount());
+        const CloudArrays& clouds = clouds_.getClouds();
+        for (size_t i = 0; i < nCpuClouds; i++) {
+            if (clouds.alpha[i] > 0.01f) {
+                cloudPositions.push_back({ clouds.positionX[i], clouds.positionY[i], clouds.positionZ[i] });
+                cloudSizes.push_back(clouds.scaleX[i]);
+                cloudAlphas.push_back(clouds.alpha[i]);
             }
         }
 
-        rockyFloor_.draw(proj, view, cameraPosition_,
-            light_.getSunLight(),
-            crystal_.position,
-            crystal_.position.y,
-            cloudPositions,
-            cloudSizes,
-            cloudAlphas);
+        {
+            PROFILE_SCOPE("Rocky Floor");
+            rockyFloor_.draw(proj, view, cameraPosition_,
+                light_.getSunLight(),
+                crystal_.renderPosition,
+                crystal_.renderPosition.y,
+                cloudPositions,
+                cloudSizes,
+                cloudAlphas);
+        }
 
         glm::mat4 projView = proj * view;
 
-        drawCrystal(projView);
+        {
+            PROFILE_SCOPE("Crystal");
+            drawCrystal(projView);
+        }
+        {
+            PROFILE_SCOPE("Sparkles");
+            drawSparkles(proj, view);
+        }
 
-        clouds_.update(deltaTime_);
-        clouds_.draw(proj, view, light_.getSunLight(), cameraPosition_);
+        {
+            PROFILE_SCOPE("Clouds Draw");
+            clouds_.draw(proj, view, light_.getSunLight(), cameraPosition_);
+        }
     }
 
     glm::mat4 getPerspectiveProjectionMatrix()
@@ -626,12 +829,31 @@ private:
 
     RockyFloor rockyFloor_;
 
+    ParticleSystem sparkles_;
+    GLuint sparkleEmitter_ = 0;
+    GLuint sparkleTexture_ = 0;
+
+    static constexpr unsigned int DEFAULT_CLOUD_COUNT = 50;
     Clouds clouds_;
     float cloudSpeed_ = 1.0f;
     float cloudAlpha_ = 0.6f;
 
-    sf::Clock clock;
-    float deltaTime_;
+    // Ce que le rendu lit de la simulation, réutilisé d'un pas à l'autre (les colonnes des nuages ne réallouent pas).
+    struct SceneSnapshot
+    {
+        CrystalState crystal;
+        CloudArrays clouds;
+        double publishTime = 0.0;
+    };
+
+    // Propriété de simulate().
+    CrystalState simulatedCrystal_;
+    Clouds simulatedClouds_;
+    // Écrit par le fil OpenGL, lu par simulate().
+    std::atomic<bool> isCloudGpuSimulation_ = false;
+
+    TripleBuffer<SceneSnapshot> snapshots_;
+    TripleBuffer<CrystalMotion> crystalMotion_;
 
     Light light_;
 
@@ -649,6 +871,16 @@ private:
 
 int main(int argc, char* argv[])
 {
+    // Sans fenêtre ni contexte OpenGL.
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--cloud-benchmark") == 0)
+        {
+            benchmarkClouds();
+            return 0;
+        }
+    }
+
     WindowSettings settings = {};
     settings.fps = 60;
     settings.context.depthBits = 24;
@@ -4,6 +4,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+#include <inf2705/gl_debug.hpp>
+
 using namespace gl;
 
 struct PVertex {
@@ -92,6 +94,10 @@ void Model::load(const char* path)
 
     glBindVertexArray(0);
 
+    GLDebug::label(GL_VERTEX_ARRAY, vao_, path);
+    GLDebug::label(GL_BUFFER, vbo_, path);
+    GLDebug::label(GL_BUFFER, ebo_, path);
+
 }
 
 Model::~Model()
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cstdlib>
 #include <cmath>
+#include <algorithm>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -13,6 +14,7 @@ RockyFloor::RockyFloor() : time_(0.0f) {
 
 RockyFloor::~RockyFloor() {
     if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (ebo_) glDeleteBuffers(1, &ebo_);
     if (vao_) glDeleteVertexArrays(1, &vao_);
     if (shaderProgram_) glDeleteProgram(shaderProgram_);
 }
@@ -22,16 +24,24 @@ void RockyFloor::initialize() {
     loadShaders();
 }
 
+void RockyFloor::configure(float extent, int patchesPerSide, float tessScale) {
+    extent_ = std::max(1.0f, extent);
+    patchesPerSide_ = std::max(1, patchesPerSide);
+    tessScale_ = std::max(0.0f, tessScale);
+    createGeometry();
+}
+
 void RockyFloor::createGeometry() {
-    const int gridSize = 8;
-    const float patchSize = 60.0f / gridSize;
+    const int gridSize = patchesPerSide_;
+    const float patchSize = extent_ / gridSize;
+    const float origin = -extent_ / 2.0f;
 
     std::vector<float> vertices;
 
     for (int z = 0; z <= gridSize; ++z) {
         for (int x = 0; x <= gridSize; ++x) {
-            float worldX = -30.0f + x * patchSize;
-            float worldZ = -30.0f + z * patchSize;
+            float worldX = origin + x * patchSize;
+            float worldZ = origin + z * patchSize;
 
             vertices.push_back(worldX);
             vertices.push_back(0.0f);
@@ -57,6 +67,9 @@ void RockyFloor::createGeometry() {
     vertexCount_ = vertices.size();
     patchCount_ = indices.size() / 4;
 
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (ebo_) glDeleteBuffers(1, &ebo_);
     glGenVertexArrays(1, &vao_);
     glGenBuffers(1, &vbo_);
     glGenBuffers(1, &ebo_);
@@ -73,6 +86,10 @@ void RockyFloor::createGeometry() {
     glEnableVertexAttribArray(0);
 
     glBindVertexArray(0);
+
+    GLDebug::label(GL_VERTEX_ARRAY, vao_, "Rocky Floor");
+    GLDebug::label(GL_BUFFER, vbo_, "Rocky Floor");
+    GLDebug::label(GL_BUFFER, ebo_, "Rocky Floor");
 }
 
 void RockyFloor::loadShaders() {
@@ -91,6 +108,7 @@ void main() {
 #version 410 core
 layout(vertices = 4) out;
 uniform vec3 uCameraPos;
+uniform float uTessScale;
 
 void main() {
     gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
@@ -117,7 +135,7 @@ void main() {
             tessLevel = mix(16.0, 8.0, min(1.0, (minDist - 20.0) / 30.0));
         }
         
-        tessLevel = max(2.0, min(64.0, tessLevel));
+        tessLevel = max(2.0, min(64.0, tessLevel * uTessScale));
         
         gl_TessLevelInner[0] = tessLevel;
         gl_TessLevelInner[1] = tessLevel;
@@ -207,7 +225,7 @@ void main() {
 )GLSL";
 
     const char* fsSource = R"GLSL(
-#version 410 core
+#version 430 core
 in vec3 tePosition;
 in vec3 teNormal;
 
@@ -228,6 +246,29 @@ uniform float uCloudSizes[20];
 uniform float uCloudAlphas[20];
 uniform int uCloudCount;
 
+// Même disposition que Clouds::GpuState, écrit par le nuanceur de calcul des nuages.
+struct CloudState {
+    vec4 positionRotation;
+    vec4 scaleAlpha;
+    vec4 motion;
+    vec4 life;
+    float floatAmount;
+    uint random;
+    vec2 padding;
+};
+layout(std430, binding = 3) readonly buffer CloudStates { CloudState cloudStates[]; };
+uniform bool uCloudStatesEnabled;
+
+float calculateCloudShadow(vec2 groundPos, vec2 cloudGroundPos, float size, float alpha) {
+    float cloudDist = distance(groundPos, cloudGroundPos);
+
+    float cloudShadowRadius = size * 1.5;
+    float cloudShadowStrength = alpha * 0.6;
+
+    float cloudShadow = 1.0 - smoothstep(0.0, cloudShadowRadius, cloudDist);
+    return pow(cloudShadow, 1.1) * cloudShadowStrength;
+}
+
 float calculateSimpleShadows(vec3 groundPos) {
     if (!uShadowsEnabled) {
         return 0.0;
@@ -245,19 +286,22 @@ float calculateSimpleShadows(vec3 groundPos) {
     
     totalShadow = max(totalShadow, crystalShadow);
     
-    for(int i = 0; i < min(uCloudCount, 20); i++) {
-        if (uCloudAlphas[i] < 0.01) continue;
-        
-        vec2 cloudGroundPos = uCloudPositions[i].xz;
-        float cloudDist = distance(groundPos.xz, cloudGroundPos);
-        
-        float cloudShadowRadius = uCloudSizes[i] * 1.5;
-        float cloudShadowStrength = uCloudAlphas[i] * 0.6;
-        
-        float cloudShadow = 1.0 - smoothstep(0.0, cloudShadowRadius, cloudDist);
-        cloudShadow = pow(cloudShadow, 1.1) * cloudShadowStrength;
-        
-        totalShadow = max(totalShadow, cloudShadow);
+    if (uCloudStatesEnabled) {
+        // Les 20 premiers nuages visibles, comme les tableaux du CPU. La recherche est bornée : au départ, tous
+        // les nuages sont transparents.
+        int nFound = 0;
+        for (int i = 0; i < min(uCloudCount, 64) && nFound < 20; i++) {
+            vec4 scaleAlpha = cloudStates[i].scaleAlpha;
+            if (scaleAlpha.w < 0.01) continue;
+            nFound++;
+            totalShadow = max(totalShadow, calculateCloudShadow(groundPos.xz, cloudStates[i].positionRotation.xz, scaleAlpha.x, scaleAlpha.w));
+        }
+    }
+    else {
+        for(int i = 0; i < min(uCloudCount, 20); i++) {
+            if (uCloudAlphas[i] < 0.01) continue;
+            totalShadow = max(totalShadow, calculateCloudShadow(groundPos.xz, uCloudPositions[i].xz, uCloudSizes[i], uCloudAlphas[i]));
+        }
     }
     
     return min(totalShadow, 0.85);
@@ -343,6 +387,7 @@ void main() {
     glAttachShader(shaderProgram_, tes);
     glAttachShader(shaderProgram_, fs);
     glLinkProgram(shaderProgram_);
+    GLDebug::label(GL_PROGRAM, shaderProgram_, "Rocky Floor");
 
     GLint success;
     glGetProgramiv(shaderProgram_, GL_LINK_STATUS, &success);
@@ -362,6 +407,7 @@ void main() {
     uModelLoc_ = glGetUniformLocation(shaderProgram_, "uModel");
     uCameraPosLoc_ = glGetUniformLocation(shaderProgram_, "uCameraPos");
     uTimeLoc_ = glGetUniformLocation(shaderProgram_, "uTime");
+    uTessScaleLoc_ = glGetUniformLocation(shaderProgram_, "uTessScale");
 
     uLightPosLoc_ = glGetUniformLocation(shaderProgram_, "uLightPos");
     uLightColorLoc_ = glGetUniformLocation(shaderProgram_, "uLightColor");
@@ -373,20 +419,26 @@ void main() {
     uCloudSizesLoc_ = glGetUniformLocation(shaderProgram_, "uCloudSizes");
     uCloudAlphasLoc_ = glGetUniformLocation(shaderProgram_, "uCloudAlphas");
     uCloudCountLoc_ = glGetUniformLocation(shaderProgram_, "uCloudCount");
+    uCloudStatesEnabledLoc_ = glGetUniformLocation(shaderProgram_, "uCloudStatesEnabled");
 
     if (uCameraPosLoc_ == -1) {
         std::cerr << "ERROR: uCameraPos uniform not found!" << std::endl;
     }
 }
 
+void RockyFloor::setCloudStateBuffer(GLuint buffer, GLuint cloudCount) {
+    cloudStateBuffer_ = buffer;
+    cloudStateCount_ = cloudCount;
+}
+
 void RockyFloor::draw(const glm::mat4& proj, const glm::mat4& view,
     const glm::vec3& cameraPos,
     const Light::LightSource& light,
     const glm::vec3& crystalPos,
     float crystalHeight,
-    const std::vector<glm::vec3>& cloudPositions,
-    const std::vector<float>& cloudSizes,
-    const std::vector<float>& cloudAlphas) {
+    std::span<const glm::vec3> cloudPositions,
+    std::span<const float> cloudSizes,
+    std::span<const float> cloudAlphas) {
 
     if (!shaderProgram_ || !vao_) return;
 
@@ -407,6 +459,7 @@ void RockyFloor::draw(const glm::mat4& proj, const glm::mat4& view,
 
     glUniform3f(uCameraPosLoc_, cameraPos.x, cameraPos.y, cameraPos.z);
     glUniform1f(uTimeLoc_, time_);
+    glUniform1f(uTessScaleLoc_, tessScale_);
 
     glUniform3f(uLightPosLoc_, light.direction.x, light.direction.y, light.direction.z);
     glUniform3f(uLightColorLoc_, light.color.x, light.color.y, light.color.z);
@@ -415,8 +468,17 @@ void RockyFloor::draw(const glm::mat4& proj, const glm::mat4& view,
     glUniform3f(uCrystalPosLoc_, crystalPos.x, crystalPos.y, crystalPos.z);
     glUniform1f(uCrystalHeightLoc_, crystalHeight);
 
+    // Avec le SSBO, le nuanceur choisit lui-même les nuages : uCloudCount est le nombre total.
     int cloudCount = std::min(static_cast<int>(cloudPositions.size()), 20);
-    glUniform1i(uCloudCountLoc_, cloudCount);
+    glUniform1i(uCloudStatesEnabledLoc_, cloudStateBuffer_ != 0 ? 1 : 0);
+    if (cloudStateBuffer_ != 0) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLOUD_STATE_BINDING, cloudStateBuffer_);
+        glUniform1i(uCloudCountLoc_, static_cast<int>(cloudStateCount_));
+        cloudCount = 0;
+    }
+    else {
+        glUniform1i(uCloudCountLoc_, cloudCount);
+    }
 
     GLint lightingEnabledLoc = glGetUniformLocation(shaderProgram_, "uLightingEnabled");
     GLint shadowsEnabledLoc = glGetUniformLocation(shaderProgram_, "uShadowsEnabled");
@@ -428,28 +490,11 @@ void RockyFloor::draw(const glm::mat4& proj, const glm::mat4& view,
         glUniform1i(shadowsEnabledLoc, (light.enabled && light.castShadows) ? 1 : 0);
     }
 
-    for (int i = 0; i < cloudCount; i++) {
-        std::string posName = "uCloudPositions[" + std::to_string(i) + "]";
-        GLint loc = glGetUniformLocation(shaderProgram_, posName.c_str());
-        if (loc != -1) {
-            glUniform3f(loc, cloudPositions[i].x, cloudPositions[i].y, cloudPositions[i].z);
-        }
-    }
-
-    for (int i = 0; i < cloudCount; i++) {
-        std::string sizeName = "uCloudSizes[" + std::to_string(i) + "]";
-        GLint loc = glGetUniformLocation(shaderProgram_, sizeName.c_str());
-        if (loc != -1 && i < cloudSizes.size()) {
-            glUniform1f(loc, cloudSizes[i]);
-        }
-    }
-
-    for (int i = 0; i < cloudCount; i++) {
-        std::string alphaName = "uCloudAlphas[" + std::to_string(i) + "]";
-        GLint loc = glGetUniformLocation(shaderProgram_, alphaName.c_str());
-        if (loc != -1 && i < cloudAlphas.size()) {
-            glUniform1f(loc, cloudAlphas[i]);
-        }
+    // Les éléments d'un tableau uniforme ont des locations consécutives : un appel par tableau.
+    if (cloudCount > 0) {
+        glUniform3fv(uCloudPositionsLoc_, cloudCount, glm::value_ptr(cloudPositions[0]));
+        glUniform1fv(uCloudSizesLoc_, std::min(cloudCount, static_cast<int>(cloudSizes.size())), cloudSizes.data());
+        glUniform1fv(uCloudAlphasLoc_, std::min(cloudCount, static_cast<int>(cloudAlphas.size())), cloudAlphas.data());
     }
 
     glPatchParameteri(GL_PATCH_VERTICES, 4);
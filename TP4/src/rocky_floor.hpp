@@ -1,6 +1,7 @@
 #ifndef ROCKY_FLOOR_HPP
 #define ROCKY_FLOOR_HPP
 
+#include <span>
 #include <vector>
 #include <glm/glm.hpp>
 #include <inf2705/OpenGLApplication.hpp>
@@ -11,15 +12,25 @@ public:
     RockyFloor();
     ~RockyFloor();
 
+    static constexpr float DEFAULT_EXTENT = 60.0f;
+    static constexpr int DEFAULT_PATCHES_PER_SIDE = 8;
+
     void initialize();
+    // Reconstruit la grille de patchs (côté extent, centrée sur l'origine). tessScale multiplie le niveau de
+    // tessellation calculé selon la distance, plafonné à 64.
+    void configure(float extent, int patchesPerSide, float tessScale);
+    float getExtent() const { return extent_; }
+    // SSBO des nuages simulés sur le GPU (Clouds::getGpuStateBuffer()). Tant qu'il est non nul, les ombres le lisent
+    // directement et les tableaux de draw() sont ignorés.
+    void setCloudStateBuffer(GLuint buffer, GLuint cloudCount);
     void draw(const glm::mat4& proj, const glm::mat4& view,
         const glm::vec3& cameraPos,
         const Light::LightSource& light,
         const glm::vec3& crystalPos,
         float crystalHeight,
-        const std::vector<glm::vec3>& cloudPositions,
-        const std::vector<float>& cloudSizes,
-        const std::vector<float>& cloudAlphas);
+        std::span<const glm::vec3> cloudPositions,
+        std::span<const float> cloudSizes,
+        std::span<const float> cloudAlphas);
 
 private:
     void createGeometry();
@@ -34,11 +45,20 @@ private:
     int patchCount_ = 0;
     float time_ = 0.0f;
 
+    float extent_ = DEFAULT_EXTENT;
+    int patchesPerSide_ = DEFAULT_PATCHES_PER_SIDE;
+    float tessScale_ = 1.0f;
+
+    static constexpr GLuint CLOUD_STATE_BINDING = 3;
+    GLuint cloudStateBuffer_ = 0;
+    GLuint cloudStateCount_ = 0;
+
     GLint uProjLoc_;
     GLint uViewLoc_;
     GLint uModelLoc_;
     GLint uCameraPosLoc_;
     GLint uTimeLoc_;
+    GLint uTessScaleLoc_;
 
     GLint uLightPosLoc_;
     GLint uLightColorLoc_;
@@ -50,6 +70,7 @@ private:
     GLint uCloudSizesLoc_;
     GLint uCloudAlphasLoc_;
     GLint uCloudCountLoc_;
+    GLint uCloudStatesEnabledLoc_;
 };
 
 #endif
\ No newline at end of file